@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#ifdef ENG_BENCHMARK_PHYSX
+    #include <PxPhysicsAPI.h>
+#endif
+
+#include "world/cpu_terrain.hpp"
+
+// Headless benchmark of the CPU terrain backends over a fixed chunk set, configuration and ray seed. Results are
+// written as JSON so they can be tracked per commit, e.g.
+//   terrain_benchmark --radius 4 --iterations 5 --output bench_output.json
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        int m_radius = 4, m_iterations = 3, m_rays_per_chunk = 256;
+        int unsigned m_point_width = 16, m_tile_width = 10;
+        float m_threshold = 0.1f, m_chunk_size = 12.0f;
+        char const * m_config_path = "res/default_world_gen_config.txt";
+        char const * m_output_path = nullptr;
+    };
+
+    struct Stage
+    {
+        char const * m_name;
+        char const * m_unit;
+        std::vector<double> m_samples_ms{}; // One sample per chunk and iteration
+        double m_work{};                    // Units of work done in all samples
+    };
+
+    // How many of the chunks in a render distance World skips, either outside their column's surface range or
+    // classified uniform by classifyChunk
+    struct SkipReport
+    {
+        int m_render_distance;
+        size_t m_chunk_count{}, m_range_skipped_count{}, m_classified_count{}, m_classified_skipped_count{};
+        double m_total_ms{};
+    };
+
+    int constexpr SKIP_REPORT_DISTANCES[] = { 4, 8, 16, 32 };
+
+    // The chunks World streams around the origin, each column over its surface range
+    void collectChunks(eng::cpu::GenerationConfig const & config, float threshold, int radius, std::vector<glm::ivec3> & out_chunks)
+    {
+        out_chunks.clear();
+        for (int x = -radius; x <= radius; ++x)
+        {
+            for (int z = -radius; z <= radius; ++z)
+            {
+                int min_y, max_y;
+                eng::cpu::estimateSurfaceRange(config, { x, z }, threshold, min_y, max_y);
+                for (int y = std::max(min_y, -radius); y <= std::min(max_y, radius); ++y) out_chunks.emplace_back(x, y, z);
+            }
+        }
+    }
+
+    // Points of a chunk classified EMPTY or SOLID that are on the wrong side of the threshold in the density the GPU
+    // generates, anything but 0 means the bounds aren't conservative
+    size_t countClassificationErrors(eng::cpu::GenerationConfig const & config, glm::ivec3 const & chunk_position, int unsigned point_width, float threshold, eng::cpu::ChunkClass chunk_class)
+    {
+        if (chunk_class == eng::cpu::ChunkClass::SURFACE) return 0;
+        float const point_spacing = eng::cpu::CHUNK_NOISE_EXTENT / static_cast<float>(point_width - 1);
+        size_t errors = 0;
+        for (int unsigned z = 0; z < point_width; ++z)
+        {
+            for (int unsigned y = 0; y < point_width; ++y)
+            {
+                for (int unsigned x = 0; x < point_width; ++x)
+                {
+                    glm::vec3 const point = glm::vec3(glm::ivec3(x, y, z) + chunk_position * static_cast<int>(point_width - 1)) * point_spacing;
+                    bool const solid = eng::cpu::sampleGlslDensity(config, point) < threshold;
+                    errors += solid != (chunk_class == eng::cpu::ChunkClass::SOLID);
+                }
+            }
+        }
+        return errors;
+    }
+
+    // The surface ranges only rely on the density bounds, which use the empirical NOISE_JUMP_BOUND. Checks that the
+    // chunk just below each column's range is solid and the one just above it air, where the bounds are tightest.
+    size_t countSurfaceRangeErrors(eng::cpu::GenerationConfig const & config, int radius, int unsigned point_width, float threshold)
+    {
+        size_t errors = 0;
+        for (int x = -radius; x <= radius; ++x)
+        {
+            for (int z = -radius; z <= radius; ++z)
+            {
+                int min_y, max_y;
+                eng::cpu::estimateSurfaceRange(config, { x, z }, threshold, min_y, max_y);
+                errors += countClassificationErrors(config, { x, min_y - 1, z }, point_width, threshold, eng::cpu::ChunkClass::SOLID);
+                errors += countClassificationErrors(config, { x, max_y + 1, z }, point_width, threshold, eng::cpu::ChunkClass::EMPTY);
+            }
+        }
+        return errors;
+    }
+
+    // Packed words of generateMaterials that differ from the ones generate_points.glsl writes, computed the way the
+    // shader does it: the GLSL noise port at the shader's sample position, ORed into zeroed words
+    size_t countMaterialMismatches(glm::ivec3 const & chunk_position, int unsigned point_width, std::vector<uint32_t> const & materials)
+    {
+        int unsigned const points_from_zero = point_width - 1;
+        std::vector<uint32_t> reference(materials.size(), 0);
+        for (int unsigned z = 0; z < point_width; ++z)
+        {
+            for (int unsigned y = 0; y < point_width; ++y)
+            {
+                for (int unsigned x = 0; x < point_width; ++x)
+                {
+                    glm::vec3 const sample_position = (glm::vec3(x, y, z) + glm::vec3(chunk_position) * static_cast<float>(points_from_zero)) * (eng::cpu::CHUNK_NOISE_EXTENT / static_cast<float>(points_from_zero));
+                    auto const material = eng::TerrainMaterial::select(eng::cpu::simplexNoiseGlsl(sample_position * eng::TerrainMaterial::NOISE_FREQUENCY + eng::TerrainMaterial::NOISE_OFFSET));
+                    size_t const index = (static_cast<size_t>(z) * point_width + y) * point_width + x;
+                    reference[index >> 2] |= static_cast<uint32_t>(material) << ((index & 3u) * 8u);
+                }
+            }
+        }
+        size_t mismatches = 0;
+        for (size_t i = 0; i < reference.size(); ++i) mismatches += reference[i] != materials[i];
+        return mismatches;
+    }
+
+    double elapsedMs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    double percentile(std::vector<double> sorted_samples, double fraction)
+    {
+        if (sorted_samples.empty()) return 0.0;
+        std::sort(sorted_samples.begin(), sorted_samples.end());
+        size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted_samples.size() - 1) + 0.5);
+        return sorted_samples[index];
+    }
+
+    // Tiled meshing emits the same triangles in another order
+    bool sameTriangles(std::vector<float> const & a, std::vector<float> const & b)
+    {
+        if (a.size() != b.size()) return false;
+        using Triangle = std::array<float, eng::cpu::FLOATS_PER_TRIANGLE>;
+        auto sorted = [](std::vector<float> const & triangles)
+        {
+            std::vector<Triangle> result(triangles.size() / eng::cpu::FLOATS_PER_TRIANGLE);
+            std::memcpy(result.data(), triangles.data(), triangles.size() * sizeof(float));
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+        return sorted(a) == sorted(b);
+    }
+
+    bool parseOptions(int argc, char ** argv, Options & options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            auto next = [&]() -> char const * { return i + 1 < argc ? argv[++i] : nullptr; };
+            char const * value = nullptr;
+            if (!std::strcmp(argv[i], "--radius") && (value = next())) options.m_radius = std::atoi(value);
+            else if (!std::strcmp(argv[i], "--iterations") && (value = next())) options.m_iterations = std::atoi(value);
+            else if (!std::strcmp(argv[i], "--rays") && (value = next())) options.m_rays_per_chunk = std::atoi(value);
+            else if (!std::strcmp(argv[i], "--point-width") && (value = next())) options.m_point_width = static_cast<int unsigned>(std::atoi(value));
+            else if (!std::strcmp(argv[i], "--config") && (value = next())) options.m_config_path = value;
+            else if (!std::strcmp(argv[i], "--output") && (value = next())) options.m_output_path = value;
+            else
+            {
+                std::fprintf(stderr, "Usage: %s [--radius N] [--iterations N] [--rays N] [--point-width N] [--config FILE] [--output FILE]\n", argv[0]);
+                return false;
+            }
+        }
+        return options.m_point_width >= 2 && options.m_iterations > 0 && options.m_radius >= 0;
+    }
+
+    void writeResults(FILE * file, Options const & options, bool config_loaded, std::vector<Stage> const & stages, std::vector<SkipReport> const & skip_reports)
+    {
+        std::fprintf(file, "{\n  \"configuration\": { \"radius\": %d, \"iterations\": %d, \"point_width\": %u, \"rays_per_chunk\": %d, \"config_file\": \"%s\" },\n  \"stages\": {",
+            options.m_radius, options.m_iterations, options.m_point_width, options.m_rays_per_chunk, config_loaded ? options.m_config_path : "<built-in defaults>");
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            Stage const & stage = stages[i];
+            double total_ms = std::accumulate(stage.m_samples_ms.begin(), stage.m_samples_ms.end(), 0.0);
+            std::fprintf(file, "%s\n    \"%s\": { \"samples\": %zu, \"total_ms\": %.3f, \"%s_per_sec\": %.1f, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f }",
+                i == 0 ? "" : ",", stage.m_name, stage.m_samples_ms.size(), total_ms, stage.m_unit, total_ms > 0.0 ? stage.m_work / (total_ms / 1000.0) : 0.0,
+                percentile(stage.m_samples_ms, 0.5), percentile(stage.m_samples_ms, 0.9), percentile(stage.m_samples_ms, 0.99), percentile(stage.m_samples_ms, 1.0));
+        }
+        std::fprintf(file, "\n  },\n  \"uniform_chunk_skipping\": {");
+        for (size_t i = 0; i < skip_reports.size(); ++i)
+        {
+            SkipReport const & report = skip_reports[i];
+            size_t const skipped_count = report.m_range_skipped_count + report.m_classified_skipped_count;
+            std::fprintf(file, "%s\n    \"render_distance_%d\": { \"chunks\": %zu, \"outside_surface_range\": %zu, \"classified_uniform\": %zu, \"skipped_fraction\": %.3f, \"classified_skipped_fraction\": %.3f, \"classify_us_per_chunk\": %.2f }",
+                i == 0 ? "" : ",", report.m_render_distance, report.m_chunk_count, report.m_range_skipped_count, report.m_classified_skipped_count,
+                static_cast<double>(skipped_count) / static_cast<double>(report.m_chunk_count),
+                report.m_classified_count ? static_cast<double>(report.m_classified_skipped_count) / static_cast<double>(report.m_classified_count) : 0.0,
+                report.m_classified_count ? report.m_total_ms * 1000.0 / static_cast<double>(report.m_classified_count) : 0.0);
+        }
+        std::fprintf(file, "\n  }\n}\n");
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    eng::cpu::GenerationConfig config;
+    bool config_loaded = eng::cpu::loadGenerationConfig(options.m_config_path, config);
+    if (!config_loaded) std::fprintf(stderr, "Couldn't read %s, using built-in defaults\n", options.m_config_path);
+
+    std::vector<glm::ivec3> chunk_coordinates;
+    collectChunks(config, options.m_threshold, options.m_radius, chunk_coordinates);
+
+    Stage classification_stage{ "classification", "chunks" }, density_stage{ "density", "chunks" }, material_stage{ "materials", "chunks" }, meshing_stage{ "meshing", "triangles" }, bricked_meshing_stage{ "meshing_bricked", "triangles" }, tiled_meshing_stage{ "meshing_tiled", "triangles" }, compaction_stage{ "count_and_scan", "cells" }, bvh_stage{ "bvh_build", "triangles" }, ray_stage{ "ray_queries", "rays" };
+#ifdef ENG_BENCHMARK_PHYSX
+    Stage cooking_stage{ "collider_cooking", "triangles" };
+    physx::PxDefaultAllocator allocator;
+    physx::PxDefaultErrorCallback error_callback;
+    physx::PxFoundation * foundation = PxCreateFoundation(PX_PHYSICS_VERSION, allocator, error_callback);
+    physx::PxCooking * cooking = PxCreateCooking(PX_PHYSICS_VERSION, *foundation, physx::PxCookingParams(physx::PxTolerancesScale()));
+    std::vector<uint32_t> indices;
+#endif
+
+    std::mt19937 random(1337);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> density, triangles, bricked_density, bricked_triangles, tiled_triangles;
+    std::vector<uint32_t> materials, cell_triangle_offsets;
+    eng::cpu::TriangleBvh bvh;
+    size_t hits = 0, layout_mismatches = 0, tiling_mismatches = 0, compaction_mismatches = 0, classification_errors = 0, material_mismatches = 0;
+
+    for (int iteration = 0; iteration < options.m_iterations; ++iteration)
+    {
+        for (auto const & chunk_coordinate : chunk_coordinates)
+        {
+            auto start = Clock::now();
+            eng::cpu::ChunkClass const chunk_class = eng::cpu::classifyChunk(config, chunk_coordinate, options.m_point_width, options.m_threshold);
+            classification_stage.m_samples_ms.push_back(elapsedMs(start));
+            classification_stage.m_work += 1.0;
+            if (iteration == 0) classification_errors += countClassificationErrors(config, chunk_coordinate, options.m_point_width, options.m_threshold, chunk_class);
+
+            start = Clock::now();
+            eng::cpu::generateDensity(config, chunk_coordinate, options.m_point_width, density);
+            density_stage.m_samples_ms.push_back(elapsedMs(start));
+            density_stage.m_work += 1.0;
+
+            start = Clock::now();
+            eng::cpu::generateMaterials(chunk_coordinate, options.m_point_width, materials);
+            material_stage.m_samples_ms.push_back(elapsedMs(start));
+            material_stage.m_work += 1.0;
+            if (iteration == 0) material_mismatches += countMaterialMismatches(chunk_coordinate, options.m_point_width, materials);
+
+            start = Clock::now();
+            eng::cpu::generateMesh(density, options.m_point_width, options.m_threshold, triangles);
+            meshing_stage.m_samples_ms.push_back(elapsedMs(start));
+            size_t triangle_count = triangles.size() / eng::cpu::FLOATS_PER_TRIANGLE;
+            meshing_stage.m_work += static_cast<double>(triangle_count);
+
+            // Same cells in the same order, only the density storage differs, so the output has to match exactly
+            eng::cpu::convertDensityLayout(density, options.m_point_width, eng::DensityLayout::LINEAR, eng::DensityLayout::BRICKED, bricked_density);
+            start = Clock::now();
+            eng::cpu::generateMesh(bricked_density, options.m_point_width, options.m_threshold, bricked_triangles, eng::DensityLayout::BRICKED);
+            bricked_meshing_stage.m_samples_ms.push_back(elapsedMs(start));
+            bricked_meshing_stage.m_work += static_cast<double>(triangle_count);
+            layout_mismatches += bricked_triangles != triangles;
+
+            // Tiles the size of a marching cubes workgroup
+            start = Clock::now();
+            eng::cpu::generateMeshTiled(density, options.m_point_width, options.m_threshold, options.m_tile_width, tiled_triangles);
+            tiled_meshing_stage.m_samples_ms.push_back(elapsedMs(start));
+            tiled_meshing_stage.m_work += static_cast<double>(triangle_count);
+            tiling_mismatches += !sameTriangles(tiled_triangles, triangles);
+
+            start = Clock::now();
+            eng::cpu::countCellTriangles(density, options.m_point_width, options.m_threshold, cell_triangle_offsets);
+            uint32_t scanned_triangle_count = eng::cpu::exclusiveScan(cell_triangle_offsets);
+            compaction_stage.m_samples_ms.push_back(elapsedMs(start));
+            compaction_stage.m_work += static_cast<double>(cell_triangle_offsets.size());
+            compaction_mismatches += scanned_triangle_count != triangle_count;
+            if (triangle_count == 0) continue;
+
+#ifdef ENG_BENCHMARK_PHYSX
+            start = Clock::now();
+            indices.resize(triangle_count * 3);
+            std::iota(indices.begin(), indices.end(), 0u);
+            physx::PxTriangleMeshDesc mesh_desc;
+            mesh_desc.points.count = static_cast<physx::PxU32>(triangle_count * 3);
+            mesh_desc.points.stride = 2 * sizeof(physx::PxVec3);
+            mesh_desc.points.data = triangles.data();
+            mesh_desc.triangles.count = static_cast<physx::PxU32>(triangle_count);
+            mesh_desc.triangles.stride = 3 * sizeof(physx::PxU32);
+            mesh_desc.triangles.data = indices.data();
+            physx::PxDefaultMemoryOutputStream write_buffer;
+            cooking->cookTriangleMesh(mesh_desc, write_buffer);
+            cooking_stage.m_samples_ms.push_back(elapsedMs(start));
+            cooking_stage.m_work += static_cast<double>(triangle_count);
+#endif
+
+            start = Clock::now();
+            bvh.build(triangles, options.m_chunk_size, glm::vec3(chunk_coordinate));
+            bvh_stage.m_samples_ms.push_back(elapsedMs(start));
+            bvh_stage.m_work += static_cast<double>(triangle_count);
+
+            // Rays start above the chunk and point mostly downwards, like sculpting from the player's view
+            glm::vec3 chunk_min = glm::vec3(chunk_coordinate) * options.m_chunk_size;
+            start = Clock::now();
+            for (int ray = 0; ray < options.m_rays_per_chunk; ++ray)
+            {
+                glm::vec3 origin = chunk_min + glm::vec3(unit(random), 1.5f, unit(random)) * options.m_chunk_size;
+                glm::vec3 direction = glm::normalize(glm::vec3(unit(random) - 0.5f, -1.0f, unit(random) - 0.5f));
+                float distance;
+                hits += bvh.intersect(origin, direction, distance);
+            }
+            ray_stage.m_samples_ms.push_back(elapsedMs(start));
+            ray_stage.m_work += options.m_rays_per_chunk;
+        }
+    }
+
+#ifdef ENG_BENCHMARK_PHYSX
+    cooking->release();
+    foundation->release();
+    std::vector<Stage> stages{ classification_stage, density_stage, material_stage, meshing_stage, bricked_meshing_stage, tiled_meshing_stage, compaction_stage, cooking_stage, bvh_stage, ray_stage };
+#else
+    std::vector<Stage> stages{ classification_stage, density_stage, material_stage, meshing_stage, bricked_meshing_stage, tiled_meshing_stage, compaction_stage, bvh_stage, ray_stage };
+#endif
+
+    std::vector<SkipReport> skip_reports;
+    std::vector<glm::ivec3> report_chunks;
+    for (int render_distance : SKIP_REPORT_DISTANCES)
+    {
+        SkipReport & report = skip_reports.emplace_back(SkipReport{ render_distance });
+        collectChunks(config, options.m_threshold, render_distance, report_chunks);
+        auto const start = Clock::now();
+        for (auto const & chunk_coordinate : report_chunks) report.m_classified_skipped_count += eng::cpu::classifyChunk(config, chunk_coordinate, options.m_point_width, options.m_threshold) != eng::cpu::ChunkClass::SURFACE;
+        report.m_total_ms = elapsedMs(start);
+        // World streams the whole cube, collectChunks leaves out what's outside the surface ranges
+        size_t const width = static_cast<size_t>(2 * render_distance + 1);
+        report.m_chunk_count = width * width * width;
+        report.m_classified_count = report_chunks.size();
+        report.m_range_skipped_count = report.m_chunk_count - report.m_classified_count;
+    }
+
+    size_t const surface_range_errors = countSurfaceRangeErrors(config, options.m_radius, options.m_point_width, options.m_threshold);
+    std::fprintf(stderr, "%zu chunks x %d iterations, %zu ray hits, %zu layout mismatches, %zu tiling mismatches, %zu compaction mismatches, %zu classification errors, %zu surface range errors, %zu material mismatches\n", chunk_coordinates.size(), options.m_iterations, hits, layout_mismatches, tiling_mismatches, compaction_mismatches, classification_errors, surface_range_errors, material_mismatches);
+
+    FILE * output = options.m_output_path ? std::fopen(options.m_output_path, "w") : stdout;
+    if (!output)
+    {
+        std::fprintf(stderr, "Couldn't open %s for writing\n", options.m_output_path);
+        return 1;
+    }
+    writeResults(output, options, config_loaded, stages, skip_reports);
+    if (output != stdout) std::fclose(output);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "graphics/uniform_id.hpp"
+
+// CPU cost of resolving a uniform location per draw, the old string keyed lookup against the UniformId slots that
+// Shader uses now. Only the lookup is measured, the glUniform call itself is the same for both, e.g.
+//   uniform_benchmark --draws 338 --frames 2000 --output uniform_output.json
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using Location = int;
+
+    struct Options
+    {
+        int m_draws = 338, m_frames = 2000; // Render distance 6 has 13 * 13 * 2 chunks
+        char const * m_output_path = nullptr;
+    };
+
+    struct Result
+    {
+        char const * m_name;
+        std::vector<double> m_frame_ns{};
+    };
+
+    // Active uniforms of chunk.glsl before the FrameData block, plus the compute ones so the table isn't trivially small
+    char const * const UNIFORM_NAMES[] = { "u_model", "u_view", "u_projection", "u_camera_position_W", "u_color", "u_points_per_axis", "u_position_offset", "u_threshold" };
+
+    bool parseOptions(int argc, char ** argv, Options & options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            auto next = [&]() -> char const * { return i + 1 < argc ? argv[++i] : nullptr; };
+            char const * value = nullptr;
+            if (!std::strcmp(argv[i], "--draws") && (value = next())) options.m_draws = std::atoi(value);
+            else if (!std::strcmp(argv[i], "--frames") && (value = next())) options.m_frames = std::atoi(value);
+            else if (!std::strcmp(argv[i], "--output") && (value = next())) options.m_output_path = value;
+            else
+            {
+                std::fprintf(stderr, "Usage: %s [--draws N] [--frames N] [--output FILE]\n", argv[0]);
+                return false;
+            }
+        }
+        return options.m_draws > 0 && options.m_frames > 0;
+    }
+
+    double percentile(std::vector<double> sorted_samples, double fraction)
+    {
+        std::sort(sorted_samples.begin(), sorted_samples.end());
+        return sorted_samples[static_cast<size_t>(fraction * static_cast<double>(sorted_samples.size() - 1) + 0.5)];
+    }
+
+    template<typename Lookup>
+    Result measure(char const * name, Options const & options, Location & sink, Lookup const & lookup)
+    {
+        Result result{ name };
+        result.m_frame_ns.reserve(options.m_frames);
+        for (int frame = 0; frame < options.m_frames; ++frame)
+        {
+            auto start = Clock::now();
+            for (int draw = 0; draw < options.m_draws; ++draw) sink += lookup();
+            result.m_frame_ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        }
+        return result;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::unordered_map<std::string, Location> string_locations;
+    std::vector<Location> slot_locations;
+    Location location = 0;
+    for (char const * uniform_name : UNIFORM_NAMES)
+    {
+        string_locations[uniform_name] = location;
+        uint32_t slot = eng::UniformId(uniform_name).getSlot();
+        if (slot >= slot_locations.size()) slot_locations.resize(slot + 1, -1);
+        slot_locations[slot] = location++;
+    }
+
+    eng::UniformId const u_model("u_model");
+    char const * volatile model_name = "u_model"; // Keeps the compiler from hoisting the lookup out of the loop
+    Location sink = 0;
+    Result results[] = {
+        measure("string_map", options, sink, [&] { return string_locations.at(model_name); }),
+        measure("uniform_slot", options, sink, [&] { return u_model.getSlot() < slot_locations.size() ? slot_locations[u_model.getSlot()] : -1; }),
+    };
+
+    FILE * output = options.m_output_path ? std::fopen(options.m_output_path, "w") : stdout;
+    if (!output)
+    {
+        std::fprintf(stderr, "Couldn't open %s for writing\n", options.m_output_path);
+        return 1;
+    }
+    std::fprintf(output, "{\n  \"configuration\": { \"draws\": %d, \"frames\": %d },\n  \"lookups\": {", options.m_draws, options.m_frames);
+    for (size_t i = 0; i < std::size(results); ++i)
+    {
+        Result const & result = results[i];
+        std::fprintf(output, "%s\n    \"%s\": { \"ns_per_draw\": %.2f, \"p50_frame_us\": %.3f, \"p99_frame_us\": %.3f }", i == 0 ? "" : ",", result.m_name,
+            percentile(result.m_frame_ns, 0.5) / options.m_draws, percentile(result.m_frame_ns, 0.5) / 1000.0, percentile(result.m_frame_ns, 0.99) / 1000.0);
+    }
+    std::fprintf(output, "\n  }\n}\n");
+    if (output != stdout) std::fclose(output);
+    std::fprintf(stderr, "checksum %d\n", sink);
+    return 0;
+}
\ No newline at end of file
@@ -3,16 +3,19 @@
 
 layout (location = 0) in vec3 a_position;
 layout (location = 1) in vec3 a_normal;
+layout (location = 2) in uint a_material;
 
 uniform mat4 u_model = mat4(1.0f);
-uniform mat4 u_view;
-uniform mat4 u_projection;
+
+#include "include/frame_data.glsl"
 
 out vec3 v_position_W;
 out vec3 v_normal_W;
+flat out uint v_material;
 
 void main()
 {
+    v_material = a_material;
     v_position_W = (u_model * vec4(a_position, 1.0f)).xyz;
     v_normal_W = mat3(u_model) * a_normal;
     gl_Position = u_projection * u_view * u_model * vec4(a_position, 1.0f);
@@ -25,12 +28,14 @@ const vec3 light_direction = vec3(1.0f, -1.0f, 0.0f);
 
 in vec3 v_position_W;
 in vec3 v_normal_W;
+flat in uint v_material;
+
+#include "include/frame_data.glsl"
+#include "include/terrain_material.glsl"
 
-uniform vec3 u_camera_position_W;
 uniform vec3 u_color = vec3(0.22f, 0.42f, 0.046f);
 
-layout (binding = 0) uniform sampler2D s_grass;
-layout (binding = 1) uniform sampler2D s_dirt;
+layout (binding = 0) uniform sampler2DArray s_materials;
 
 const float c_fog_start = 50, c_fog_end = 70;
 
@@ -46,15 +51,16 @@ void main()
     blending *= normalize(vec3(1.0f, 4.0f, 1.0f));
 
     const float scale_factor = 0.2f;
-    vec3 x_axis = texture(s_dirt, v_position_W.yz * scale_factor).xyz;
-    vec3 y_axis = texture(s_grass, v_position_W.xz * scale_factor).xyz;
-    vec3 z_axis = texture(s_dirt, v_position_W.xy * scale_factor).xyz;
+    PaletteEntry material = palette[min(v_material, uint(MATERIAL_COUNT - 1))];
+    vec3 x_axis = texture(s_materials, vec3(v_position_W.yz * scale_factor, material.side_layer)).xyz;
+    vec3 y_axis = texture(s_materials, vec3(v_position_W.xz * scale_factor, material.top_layer)).xyz;
+    vec3 z_axis = texture(s_materials, vec3(v_position_W.xy * scale_factor, material.side_layer)).xyz;
 
     vec3 color = x_axis * blending.x + y_axis * blending.y + z_axis * blending.z;
     color *= normalize(vec3(0.4f, 1.25f, 1.0f));
 
     // Directional lighting
-    vec3 view_direction = normalize(u_camera_position_W - v_position_W);
+    vec3 view_direction = normalize(u_camera_position_W.xyz - v_position_W);
     vec3 direction = normalize(-light_direction);
     vec3 half_way_direction = normalize(direction + view_direction);
     
@@ -65,7 +71,7 @@ void main()
     vec3 specular = vec3(0.05f) * pow(max(dot(normal, half_way_direction), 0.0f), 16.0f);
 
     // Distance fog
-    float distance = distance(v_position_W, u_camera_position_W);
+    float distance = distance(v_position_W, u_camera_position_W.xyz);
     float fog_factor = clamp((distance - c_fog_start) / (c_fog_end - c_fog_start), 0.0f, 1.0f);
 
     vec4 final_color = mix(vec4(ambient + diffuse + specular, 1.0f), vec4(0.79f, 0.94f, 1.0f, 1.0f), fog_factor);
@@ -0,0 +1,53 @@
+#shader comp
+#version 460 core
+
+#include "include/compute.glsl"
+#include "include/density_layout.glsl"
+#include "include/terrain_material.glsl"
+
+// A chunk's last plane of points on each axis is its apron, a copy of the first plane of the upper neighbour, so
+// marching cubes only ever reads one buffer. This copies the points an edited chunk owns on its lower faces into the
+// apron of one of its lower neighbours.
+
+uniform uint u_direction_mask; // Bit per axis (x, y, z) along which the destination is the lower neighbour
+
+layout(std430, binding = 3) readonly buffer SourceDensity
+{
+    readonly float source_values[];
+};
+
+layout(std430, binding = 4) buffer DestinationDensity
+{
+    float destination_values[];
+};
+
+layout(std430, binding = 11) readonly buffer SourceMaterials
+{
+    readonly uint source_materials[];
+};
+
+layout(std430, binding = 13) buffer DestinationMaterials
+{
+    uint destination_materials[];
+};
+
+layout(local_size_x = 64) in; // World::APRON_COPY_GROUP_SIZE
+
+void main()
+{
+    uint points_from_zero = c_points_per_axis - 1;
+    bvec3 apron_axis = bvec3(u_direction_mask & 1u, u_direction_mask & 2u, u_direction_mask & 4u);
+    // Along shared axes only the points the source owns, the last one belongs to a diagonal neighbour which copies it itself
+    uvec3 extent = mix(uvec3(points_from_zero), uvec3(1u), apron_axis);
+    if (gl_GlobalInvocationID.x >= extent.x * extent.y * extent.z) return;
+
+    uvec3 source = uvec3(gl_GlobalInvocationID.x % extent.x, gl_GlobalInvocationID.x / extent.x % extent.y, gl_GlobalInvocationID.x / (extent.x * extent.y));
+    uvec3 destination = mix(source, uvec3(points_from_zero), apron_axis);
+    uint source_index = densityIndex(source), destination_index = densityIndex(destination);
+    destination_values[destination_index] = source_values[source_index];
+
+    // Neighbouring apron points share material words
+    uint shift = (destination_index & 3u) * 8u;
+    atomicAnd(destination_materials[destination_index >> 2], ~(0xFFu << shift));
+    atomicOr(destination_materials[destination_index >> 2], unpackMaterial(source_materials[source_index >> 2], source_index) << shift);
+}
\ No newline at end of file
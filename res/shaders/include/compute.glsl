@@ -0,0 +1,11 @@
+#ifndef WORK_GROUP_SIZE
+    #define WORK_GROUP_SIZE 10
+#endif
+
+// Specialized permutations have the chunk point width compiled in, generic ones read it from a uniform
+#ifdef POINTS_PER_AXIS
+    const uint c_points_per_axis = POINTS_PER_AXIS;
+#else
+    uniform uint u_points_per_axis;
+    #define c_points_per_axis u_points_per_axis
+#endif
\ No newline at end of file
@@ -0,0 +1,12 @@
+// Index of a density point, 4x4x4 bricks when DENSITY_BRICKED is defined and z-major otherwise. Matches
+// world/density_layout.hpp, needs compute.glsl for c_points_per_axis.
+uint densityIndex(uvec3 point)
+{
+#ifdef DENSITY_BRICKED
+    uint bricks_per_axis = (c_points_per_axis + 3u) >> 2;
+    uvec3 brick = point >> 2, local = point & 3u;
+    return (((brick.z * bricks_per_axis + brick.y) * bricks_per_axis + brick.x) << 6) | (local.z << 4) | (local.y << 2) | local.x;
+#else
+    return point.z * c_points_per_axis * c_points_per_axis + point.y * c_points_per_axis + point.x;
+#endif
+}
\ No newline at end of file
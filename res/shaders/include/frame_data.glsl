@@ -0,0 +1,6 @@
+layout (std140, binding = 1) uniform FrameData
+{
+    mat4 u_view;
+    mat4 u_projection;
+    vec4 u_camera_position_W;
+};
\ No newline at end of file
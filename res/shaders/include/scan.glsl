@@ -0,0 +1,4 @@
+// Block sizes of the triangle offset scan, World::SCAN_BLOCK_SIZE has to match
+#define SCAN_GROUP_SIZE 256
+#define SCAN_VALUES_PER_INVOCATION 4
+#define SCAN_BLOCK_SIZE (SCAN_GROUP_SIZE * SCAN_VALUES_PER_INVOCATION)
\ No newline at end of file
@@ -0,0 +1,22 @@
+// Ids and selection constants are injected from world/terrain_material.hpp by World::makeMaterialDefines
+struct PaletteEntry
+{
+    uint top_layer, side_layer;
+    float hardness, padding;
+};
+
+layout (std140, binding = 2) uniform MaterialPalette
+{
+    PaletteEntry palette[MATERIAL_COUNT];
+};
+
+uint selectMaterial(float noise)
+{
+    return noise > MATERIAL_ROCK_THRESHOLD ? MATERIAL_ROCK : noise < MATERIAL_DIRT_THRESHOLD ? MATERIAL_DIRT : MATERIAL_GRASS;
+}
+
+// Four 8 bit ids per word in point index order
+uint unpackMaterial(uint word, uint index)
+{
+    return (word >> ((index & 3u) * 8u)) & 0xFFu;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+// Tightly packed position and normal per vertex, matches VertexDataLayout::POSITION_NORMAL_3F
+struct UnpaddedTriangle
+{
+    float  x_1,  y_1,  z_1;
+    float nx_1, ny_1, nz_1;
+    float  x_2,  y_2,  z_2;
+    float nx_2, ny_2, nz_2;
+    float  x_3,  y_3,  z_3;
+    float nx_3, ny_3, nz_3;
+};
\ No newline at end of file
@@ -1,7 +1,11 @@
 #shader comp
 #version 460 core
 
-const uint WORK_GROUP_SIZE = 10;
+#include "include/compute.glsl"
+#include "include/density_layout.glsl"
+#include "include/scan.glsl"
+#include "include/terrain_material.glsl"
+#include "include/triangle.glsl"
 
 const int cornerIndexAFromEdge[12] =
 {
@@ -13,43 +17,57 @@ const int cornerIndexBFromEdge[12] =
     1, 2, 3, 0, 5, 6, 7, 4, 4, 5, 6, 7
 };
 
-uniform uint u_points_per_axis;
 uniform float u_threshold = 0.0f;
-uniform int u_has_neighbors;
-
-struct UnpaddedTriangle
-{
-    float  x_1,  y_1,  z_1;
-    float nx_1, ny_1, nz_1;
-    float  x_2,  y_2,  z_2;
-    float nx_2, ny_2, nz_2;
-    float  x_3,  y_3,  z_3;
-    float nx_3, ny_3, nz_3;
-};
 
 layout (std430, binding = 0) readonly buffer TriangulationTable
 {
     readonly int tri_table[256][16];
 };
 
-layout (std430, binding = 1) buffer Mesh
+// The last plane on each axis is the apron copied from the upper neighbours, so every corner is in this buffer
+layout (std430, binding = 3) readonly buffer DensityDistribution
 {
-    UnpaddedTriangle triangles[];
+    readonly float values[];
 };
 
-layout (binding = 2) buffer IndirectDrawConfig
-{
-    uint index_count, prim_count, first_index, base_vertex, base_instance, triangle_count;
-};
+// Two passes: MARCHING_CUBES_COUNT writes the triangle count of every cell, scan_triangle_counts.glsl turns them into
+// offsets, and the write pass emits each cell's triangles at its offset. Triangles end up in cell order without any
+// atomics, the same order as cpu::generateMesh.
+#ifdef MARCHING_CUBES_COUNT
+    layout (std430, binding = 5) writeonly buffer CellTriangleCounts
+    {
+        writeonly uint cell_triangle_counts[];
+    };
+#else
+    layout (std430, binding = 1) writeonly buffer Mesh
+    {
+        writeonly UnpaddedTriangle triangles[];
+    };
 
-layout (std430, binding = 3) readonly buffer DensityDistribution
-{
-    readonly float values[];
-} density_distributions[8];
+    layout (std430, binding = 5) readonly buffer CellTriangleOffsets
+    {
+        readonly uint cell_triangle_offsets[]; // Relative to the block of SCAN_BLOCK_SIZE cells
+    };
+
+    layout (std430, binding = 6) readonly buffer BlockTriangleOffsets
+    {
+        readonly uint block_triangle_offsets[];
+    };
+
+    layout (std430, binding = 11) readonly buffer MaterialDistribution
+    {
+        readonly uint materials[];
+    };
+
+    layout (std430, binding = 12) writeonly buffer VertexMaterials
+    {
+        writeonly uint vertex_materials[]; // One per vertex of triangles
+    };
+#endif
 
 uint indexFromCoord(uint x, uint y, uint z)
 {
-    return z * u_points_per_axis * u_points_per_axis + y * u_points_per_axis + x;
+    return densityIndex(uvec3(x, y, z));
 }
 
 vec3 interpolateVertices(vec4 v1, vec4 v2)
@@ -58,30 +76,53 @@ vec3 interpolateVertices(vec4 v1, vec4 v2)
     return v1.xyz + t * (v2.xyz - v1.xyz);
 }
 
-float getDensityBasedOnNeighbors(uvec3 density_sample_point)
+#ifdef MARCHING_CUBES_TILED
+// The workgroup's points plus one more per axis, staged once so every point is read from global memory once instead
+// of by up to 8 cells. Neighbouring chunks' borders are in the apron, so the tile never leaves this chunk's buffer.
+const uint TILE_WIDTH = WORK_GROUP_SIZE + 1;
+shared float s_density_tile[TILE_WIDTH * TILE_WIDTH * TILE_WIDTH];
+
+void loadDensityTile()
 {
-    if (bool(u_has_neighbors)) // 0byzx (might swap y and z idk)
+    uvec3 tile_origin = gl_WorkGroupID * WORK_GROUP_SIZE;
+    uint last_point = c_points_per_axis - 1;
+    for (uint i = gl_LocalInvocationIndex; i < s_density_tile.length(); i += WORK_GROUP_SIZE * WORK_GROUP_SIZE * WORK_GROUP_SIZE)
     {
-        bool has_x = (u_has_neighbors & 1) == 1, has_y = (u_has_neighbors & 4) == 4, has_z = (u_has_neighbors & 2) == 2;
-        bool x_zero_has = density_sample_point.x == 0 && has_x, y_zero_has = density_sample_point.y == 0 && has_y, z_zero_has = density_sample_point.z == 0 && has_z;
-        if (x_zero_has || y_zero_has || z_zero_has)
-        {
-            return density_distributions[int(x_zero_has) | int(z_zero_has) << 1 | int(y_zero_has) << 2].values[indexFromCoord(x_zero_has ? u_points_per_axis - 1 : density_sample_point.x, y_zero_has ? u_points_per_axis - 1 : density_sample_point.y, z_zero_has ? u_points_per_axis - 1 : density_sample_point.z)];
-        }
+        uvec3 tile_point = uvec3(i % TILE_WIDTH, i / TILE_WIDTH % TILE_WIDTH, i / (TILE_WIDTH * TILE_WIDTH));
+        // Clamped points past the chunk only feed cells that return before reading them
+        s_density_tile[i] = values[densityIndex(min(tile_origin + tile_point, uvec3(last_point)))];
     }
-    return density_distributions[0].values[indexFromCoord(density_sample_point.x, density_sample_point.y, density_sample_point.z)];
+    barrier();
 }
 
 float getOwnDensity(uvec3 density_sample_point)
 {
-    return density_distributions[0].values[indexFromCoord(density_sample_point.x, density_sample_point.y, density_sample_point.z)];
+    uvec3 tile_point = density_sample_point - gl_WorkGroupID * WORK_GROUP_SIZE;
+    return s_density_tile[(tile_point.z * TILE_WIDTH + tile_point.y) * TILE_WIDTH + tile_point.x];
+}
+#else
+float getOwnDensity(uvec3 density_sample_point)
+{
+    return values[indexFromCoord(density_sample_point.x, density_sample_point.y, density_sample_point.z)];
 }
+#endif
+
+#ifndef MARCHING_CUBES_COUNT
+uint getOwnMaterial(uvec3 density_sample_point)
+{
+    uint index = indexFromCoord(density_sample_point.x, density_sample_point.y, density_sample_point.z);
+    return unpackMaterial(materials[index >> 2], index);
+}
+#endif
 
 layout (local_size_x = WORK_GROUP_SIZE, local_size_y = WORK_GROUP_SIZE, local_size_z = WORK_GROUP_SIZE) in;
 
 void main()
 {
-    uint points_from_zero = u_points_per_axis - 1; // ppa is a count, can't be used as index
+    uint points_from_zero = c_points_per_axis - 1; // ppa is a count, can't be used as index
+#ifdef MARCHING_CUBES_TILED
+    loadDensityTile(); // Before the bounds check, every invocation has to reach the barrier
+#endif
     if (gl_GlobalInvocationID.x >= points_from_zero || gl_GlobalInvocationID.y >= points_from_zero || gl_GlobalInvocationID.z >= points_from_zero) return; // however there's one less cube volume per axis
 
     float step_size = 1.0f / float(points_from_zero);
@@ -104,9 +145,29 @@ void main()
     {
         if (cube_corners[i].w < u_threshold) cube_index |= 1 << i;
     }
+    uint cell = (gl_GlobalInvocationID.z * points_from_zero + gl_GlobalInvocationID.y) * points_from_zero + gl_GlobalInvocationID.x;
+
+#ifdef MARCHING_CUBES_COUNT
+    uint triangle_count = 0;
+    if (cube_index != 0 && cube_index != 255)
+    {
+        for (int i = 0; tri_table[cube_index][i] != -1; i += 3) ++triangle_count;
+    }
+    cell_triangle_counts[cell] = triangle_count;
+#else
     if (cube_index == 0 || cube_index == 255) return;
 
     const int index_configuration[16] = tri_table[cube_index];
+    uint triangle_index = cell_triangle_offsets[cell] + block_triangle_offsets[cell / SCAN_BLOCK_SIZE];
+
+    // Vertices take the material of the solid end of their edge
+    const uvec3 corner_offsets[8] =
+    {
+        uvec3(0, 0, 0), uvec3(1, 0, 0), uvec3(1, 0, 1), uvec3(0, 0, 1),
+        uvec3(0, 1, 0), uvec3(1, 1, 0), uvec3(1, 1, 1), uvec3(0, 1, 1)
+    };
+    uint corner_materials[8];
+    for (uint i = 0; i < corner_offsets.length(); ++i) corner_materials[i] = getOwnMaterial(gl_GlobalInvocationID + corner_offsets[i]);
 
     for (int i = 0; index_configuration[i] != -1; i += 3)
     {
@@ -128,7 +189,11 @@ void main()
             vertexB.x, vertexB.y, vertexB.z, normal.x, normal.y, normal.z,
             vertexC.x, vertexC.y, vertexC.z, normal.x, normal.y, normal.z
         );
-        triangles[atomicAdd(triangle_count, 1)] = triangle;
-        atomicAdd(index_count, 3);
+        triangles[triangle_index] = triangle;
+        vertex_materials[triangle_index * 3]     = corner_materials[cube_corners[a0].w < u_threshold ? a0 : b0];
+        vertex_materials[triangle_index * 3 + 1] = corner_materials[cube_corners[a1].w < u_threshold ? a1 : b1];
+        vertex_materials[triangle_index * 3 + 2] = corner_materials[cube_corners[a2].w < u_threshold ? a2 : b2];
+        ++triangle_index;
     }
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#shader comp
+#version 460 core
+
+#include "include/scan.glsl"
+
+// Exclusive prefix sum of the per cell triangle counts written by the marching cubes count pass, matching
+// cpu::exclusiveScan. The first dispatch scans every block of SCAN_BLOCK_SIZE counts in place and writes the block
+// totals, the second (SCAN_BLOCK_TOTALS) scans the totals in a single workgroup and writes the draw counts. The write
+// pass adds the scanned total of a cell's block to its offset, which saves a third dispatch.
+
+uniform uint u_value_count;
+
+#ifdef SCAN_BLOCK_TOTALS
+    layout (std430, binding = 2) buffer IndirectDrawConfig
+    {
+        uint index_count, prim_count, first_index, base_vertex, base_instance, triangle_count;
+    };
+
+    layout (std430, binding = 6) buffer Values
+    {
+        uint values[];
+    };
+#else
+    layout (std430, binding = 5) buffer Values
+    {
+        uint values[];
+    };
+
+    layout (std430, binding = 6) writeonly buffer BlockTotals
+    {
+        writeonly uint block_totals[];
+    };
+#endif
+
+layout (local_size_x = SCAN_GROUP_SIZE) in;
+
+shared uint s_sums[SCAN_GROUP_SIZE];
+
+uint workGroupExclusiveScan(uint value, out uint total)
+{
+    uint lane = gl_LocalInvocationID.x;
+    s_sums[lane] = value;
+    barrier();
+    for (uint offset = 1; offset < SCAN_GROUP_SIZE; offset <<= 1)
+    {
+        uint addend = lane >= offset ? s_sums[lane - offset] : 0u;
+        barrier();
+        s_sums[lane] += addend;
+        barrier();
+    }
+    total = s_sums[SCAN_GROUP_SIZE - 1];
+    uint inclusive = s_sums[lane];
+    barrier(); // s_sums is reused by the next call
+    return inclusive - value;
+}
+
+// Scans the block starting at block_start in place, each invocation owns consecutive values
+uint scanBlock(uint block_start, uint carry)
+{
+    uint first = block_start + gl_LocalInvocationID.x * SCAN_VALUES_PER_INVOCATION;
+    uint local_values[SCAN_VALUES_PER_INVOCATION];
+    uint local_total = 0;
+    for (uint i = 0; i < SCAN_VALUES_PER_INVOCATION; ++i)
+    {
+        local_values[i] = first + i < u_value_count ? values[first + i] : 0u;
+        local_total += local_values[i];
+    }
+
+    uint block_total;
+    uint offset = carry + workGroupExclusiveScan(local_total, block_total);
+    for (uint i = 0; i < SCAN_VALUES_PER_INVOCATION; ++i)
+    {
+        if (first + i < u_value_count) values[first + i] = offset;
+        offset += local_values[i];
+    }
+    return block_total;
+}
+
+void main()
+{
+#ifdef SCAN_BLOCK_TOTALS
+    uint carry = 0;
+    for (uint block_start = 0; block_start < u_value_count; block_start += SCAN_BLOCK_SIZE)
+    {
+        uint block_total = scanBlock(block_start, carry);
+        carry += block_total;
+    }
+    if (gl_LocalInvocationID.x == 0)
+    {
+        triangle_count = carry;
+        index_count = carry * 3u;
+    }
+#else
+    uint block_total = scanBlock(gl_WorkGroupID.x * SCAN_BLOCK_SIZE, 0u);
+    if (gl_LocalInvocationID.x == 0) block_totals[gl_WorkGroupID.x] = block_total;
+#endif
+}
\ No newline at end of file
@@ -1,6 +1,9 @@
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <functional>
 #include <stdio.h>
+#include <thread>
 
 #include <glad/glad.h>
 #include <imgui.h>
@@ -11,13 +14,14 @@
 #include "event/key_event.hpp"
 #include "event/mouse_event.hpp"
 #include "logger.hpp"
+#include "profiler.hpp"
 
 #include "application.hpp"
 
 namespace eng
 {
-    Application::Application(int unsigned width, int unsigned height, char const * title, bool maximized)
-        : m_window(width, height, title, maximized, std::bind(&Application::onEvent, this, std::placeholders::_1)), m_camera(width, height), m_world(m_game_system)
+    Application::Application(int unsigned width, int unsigned height, char const * title, bool maximized, uint32_t worker_count)
+        : m_window(width, height, title, maximized, std::bind(&Application::onEvent, this, std::placeholders::_1)), m_game_system(worker_count), m_camera(width, height), m_world(m_game_system)
     {
         glfwSwapInterval(1);
         glEnable(GL_DEPTH_TEST);
@@ -41,14 +45,13 @@ namespace eng
             0, 2, 3, 0, 3, 1        //CW
         };
 
-        float crosshair_width = static_cast<float>(m_crosshair_texture->getWidth());
-        float crosshair_height = static_cast<float>(m_crosshair_texture->getHeight());
+        // Unit quad, scaled to the crosshair size when drawn since the texture is still loading here
         float quad_vertices[] = 
         {
-            0.0f,               0.0f,               0.0f, 0.0f,
-            crosshair_width,    0.0f,               1.0f, 0.0f,
-            0.0f,               crosshair_height,   0.0f, 1.0f,
-            crosshair_width,    crosshair_height,   1.0f, 1.0f
+            0.0f, 0.0f, 0.0f, 0.0f,
+            1.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 1.0f,
+            1.0f, 1.0f, 1.0f, 1.0f
         };
 
         m_crosshair_ib = m_game_system.getAssetManager().createBuffer();
@@ -62,10 +65,33 @@ namespace eng
 
         m_debug_controls.onShaderBlockChanged(m_world.getGenerationSpec().size());
         m_world.generateChunks();
+
+        auto const & shader_statistics = Shader::getCompileStatistics();
+        ENG_LOG_F("Startup took %.1f ms since window creation, shaders: %zu from cache, %zu compiled, %.1f ms CPU time",
+            glfwGetTime() * 1000.0, shader_statistics.m_cache_hits, shader_statistics.m_compiled, shader_statistics.m_cpu_time_ms);
+    }
+
+    void Application::recordInput(char const * file_path)
+    {
+        m_input_recorder = std::make_unique<InputRecorder>(file_path);
+        if (!m_input_recorder->isOpen()) m_input_recorder.reset();
+    }
+
+    void Application::replayInput(char const * file_path)
+    {
+        m_input_replayer = std::make_unique<InputReplayer>(file_path);
+        if (!m_input_replayer->isOpen())
+        {
+            m_input_replayer.reset();
+            return;
+        }
+        m_window.setExternalInput(true);
+        glfwSwapInterval(0); // Replays are used for benchmarking, so don't wait for vsync
     }
 
     void Application::onEvent(Event const & event)
     {
+        if (m_input_recorder) m_input_recorder->recordEvent(event);
         EventDispatcher::dispatch<WindowResizedEvent>(event, &FirstPersonCamera::onWindowResized, &m_camera);
         if (!event.m_window.isCursorVisible())
         {
@@ -104,13 +130,28 @@ namespace eng
 
     void Application::update(float delta_time)
     {
-        glfwPollEvents();
+        ENG_PROFILE_SCOPE("Application::update");
+        if (m_input_replayer)
+        {
+            glfwPollEvents(); // Keeps the window responsive, its input is ignored while replaying
+            if (!m_input_replayer->replayTick(m_window, delta_time))
+            {
+                glfwSetWindowShouldClose(m_window.getWindowHandle(), GLFW_TRUE);
+                return;
+            }
+        }
+        else
+        {
+            if (m_input_recorder) m_input_recorder->recordTick(delta_time);
+            glfwPollEvents();
+        }
         m_game_system.getGpuSynchronizer().update();
         if (!m_window.isCursorVisible()) m_world.update(delta_time, m_window, m_camera);
     }
 
     void Application::render()
     {
+        ENG_PROFILE_SCOPE("Application::render");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         m_world.render(m_camera);
@@ -130,6 +171,10 @@ namespace eng
 
             bool values_changed{};
             if (m_spectating) values_changed = m_debug_controls.render(m_world);
+            m_debug_controls.renderPhysicsStressTest(m_world);
+#ifdef ENG_PROFILE_ENABLED
+            Profiler::get().renderImGui();
+#endif
 
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -145,8 +190,9 @@ namespace eng
         glDisable(GL_DEPTH_TEST);
         glEnable(GL_BLEND);
         m_textured_quad_shader->bind();
-        m_textured_quad_shader->setUniformMatrix4f("u_model", glm::translate(glm::mat4(1.0f), glm::vec3(m_window.getWidth() / 2 - m_crosshair_texture->getWidth() / 2, m_window.getHeight() / 2 - m_crosshair_texture->getHeight() / 2, 0.0f)));
-        m_textured_quad_shader->setUniformMatrix4f("u_projection", glm::ortho(0.0f, static_cast<float>(m_window.getWidth()), static_cast<float>(m_window.getHeight()), 0.0f));
+        glm::vec3 const crosshair_size(m_crosshair_texture->getWidth(), m_crosshair_texture->getHeight(), 1.0f);
+        m_textured_quad_shader->setUniformMatrix4f(U_MODEL, glm::translate(glm::mat4(1.0f), glm::vec3(m_window.getWidth() / 2 - m_crosshair_texture->getWidth() / 2, m_window.getHeight() / 2 - m_crosshair_texture->getHeight() / 2, 0.0f)) * glm::scale(glm::mat4(1.0f), crosshair_size));
+        m_textured_quad_shader->setUniformMatrix4f(U_PROJECTION, glm::ortho(0.0f, static_cast<float>(m_window.getWidth()), static_cast<float>(m_window.getHeight()), 0.0f));
         m_crosshair_texture->bind(0);
         glBindVertexArray(m_crosshair_va);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -155,12 +201,39 @@ namespace eng
         glfwSwapBuffers(m_window.getWindowHandle());
     }
 
+    void Application::updateTitle(int frames, int updates, double frame_time)
+    {
+        auto const & upload_statistics = m_game_system.getUploadAllocator().getLastFrameStatistics();
+        char frame_data[128];
+        sprintf_s(frame_data, sizeof(frame_data), "FPS: %d, UPS: %d, Frametime: %f ms, Uploaded: %zu B, Stalls avoided: %zu", frames, updates, frame_time * 1000.0, upload_statistics.m_bytes_uploaded, upload_statistics.m_stalls_avoided);
+        m_window.setTitle(frame_data);
+    }
+
     void Application::run()
+    {
+        ENG_PROFILE_THREAD("Main");
+        // Recording and replaying need every tick to see the input of a known frame, so they stay on one thread
+        if (m_input_recorder || m_input_replayer) runInline();
+        else runThreaded();
+    }
+
+    void Application::runInline()
     {
         int frames = 0, updates = 0;
-        double const dt = 1.0 / 60.0;
         double time = 0.0;
         double current_time = glfwGetTime();
+        double const start_time = current_time;
+
+        if (m_input_replayer)
+        {
+            // Textures popping in on a different frame would change what a replay renders
+            TextureLoader & texture_loader = m_game_system.getAssetManager().getTextureLoader();
+            while (!texture_loader.isIdle())
+            {
+                texture_loader.update();
+                std::this_thread::yield();
+            }
+        }
 
         while (!glfwWindowShouldClose(m_window.getWindowHandle()))
         {
@@ -170,23 +243,108 @@ namespace eng
 
             if (time > 1.0)
             {
-                char frame_data[60];
-                sprintf_s(frame_data, sizeof(frame_data), "FPS: %d, UPS: %d, Frametime: %f ms", frames, updates, frame_time * 1000.0);
-                m_window.setTitle(frame_data);
+                updateTitle(frames, updates, frame_time);
                 frames = 0;
                 updates = 0;
                 time = 0.0;
             }
 
-            while (frame_time > 0.0)
+            m_game_system.getUploadAllocator().beginFrame();
+            m_game_system.getAssetManager().getTextureLoader().update();
+            if (m_input_replayer)
             {
-                double delta_time = frame_time < dt ? frame_time : dt;
+                // One recorded tick per frame, so every replay renders the same sequence of frames
+                update((float)SIMULATION_TICK);
+                time += frame_time;
+                ++updates;
+            }
+            else while (frame_time > 0.0)
+            {
+                double delta_time = frame_time < SIMULATION_TICK ? frame_time : SIMULATION_TICK;
                 update((float)delta_time);
                 frame_time -= delta_time;
                 time += delta_time;
                 ++updates;
             }
             render();
+            m_game_system.getUploadAllocator().endFrame();
+            ENG_PROFILE_FRAME();
+            ++frames;
+        }
+
+        if (m_input_replayer)
+        {
+            double replay_time = glfwGetTime() - start_time;
+            size_t ticks = m_input_replayer->getTickCount();
+            ENG_LOG_F("Replayed %zu ticks in %.3f s, %.3f ms per frame", ticks, replay_time, ticks ? replay_time * 1000.0 / ticks : 0.0);
+            ENG_LOG_F("%zu of %zu frames presented with visible chunks still generating", m_world.getFramesWithMissingChunks(), m_world.getPresentedFrameCount());
+        }
+    }
+
+    void Application::runSimulation(std::stop_token stop_token)
+    {
+        ENG_PROFILE_THREAD("Simulation");
+        auto const tick_length = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(SIMULATION_TICK));
+        auto next_tick = std::chrono::steady_clock::now();
+        while (!stop_token.stop_requested())
+        {
+            m_simulation_input.update();
+            WorldSnapshot & snapshot = m_world_snapshots.getWriteBuffer();
+            m_world.simulate((float)SIMULATION_TICK, m_simulation_input.getReadBuffer(), snapshot);
+            snapshot.m_time = glfwGetTime();
+            m_world_snapshots.publish();
+            m_simulation_ticks.fetch_add(1, std::memory_order_relaxed);
+
+            // Skip ticks instead of spiralling when the simulation can't keep up
+            next_tick += tick_length;
+            auto now = std::chrono::steady_clock::now();
+            if (now - next_tick > 5 * tick_length) next_tick = now;
+            std::this_thread::sleep_until(next_tick);
+        }
+    }
+
+    void Application::runThreaded()
+    {
+        int frames = 0;
+        double time = 0.0;
+        double current_time = glfwGetTime();
+        std::jthread simulation_thread([this](std::stop_token stop_token) { runSimulation(stop_token); });
+
+        while (!glfwWindowShouldClose(m_window.getWindowHandle()))
+        {
+            double new_time = glfwGetTime();
+            double frame_time = new_time - current_time;
+            current_time = new_time;
+            time += frame_time;
+
+            if (time > 1.0)
+            {
+                updateTitle(frames, m_simulation_ticks.exchange(0, std::memory_order_relaxed), frame_time);
+                frames = 0;
+                time = 0.0;
+            }
+
+            m_game_system.getUploadAllocator().beginFrame();
+            m_game_system.getAssetManager().getTextureLoader().update();
+            {
+                ENG_PROFILE_SCOPE("Application::update");
+                glfwPollEvents();
+                m_game_system.getGpuSynchronizer().update();
+                m_simulation_input.getWriteBuffer() = m_world.makeSimulationInput(m_window, m_camera);
+                m_simulation_input.publish();
+
+                bool new_snapshot = m_world_snapshots.update();
+                if (!m_window.isCursorVisible())
+                {
+                    WorldSnapshot const & snapshot = m_world_snapshots.getReadBuffer();
+                    float interpolation = static_cast<float>(std::clamp((glfwGetTime() - snapshot.m_time) / SIMULATION_TICK, 0.0, 1.0));
+                    m_world.present(snapshot, interpolation, m_camera);
+                    if (new_snapshot) m_world.sculpt(m_window, m_camera); // Sculpting stays at the tick rate
+                }
+            }
+            render();
+            m_game_system.getUploadAllocator().endFrame();
+            ENG_PROFILE_FRAME();
             ++frames;
         }
     }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <stop_token>
 
 #include <glm/glm.hpp>
 #include <PxPhysicsAPI.h>
@@ -14,6 +16,8 @@
 #include "graphics/shader.hpp"
 #include "graphics/texture.hpp"
 #include "graphics/vertex_array.hpp"
+#include "input_recording.hpp"
+#include "triple_buffer.hpp"
 #include "window.hpp"
 #include "world/world.hpp"
 #include "world/chunk.hpp"
@@ -22,6 +26,10 @@ namespace eng
 {
     class Application
     {
+    private:
+        double constexpr static SIMULATION_TICK = 1.0 / 60.0;
+        UniformId inline static const U_MODEL{ "u_model" }, U_PROJECTION{ "u_projection" };
+
     private:
         Window m_window; // Has to be first due to OpenGL initialization
         DebugControls m_debug_controls;
@@ -37,8 +45,24 @@ namespace eng
         GLuint m_crosshair_vb;
         GLuint m_crosshair_ib;
 
+        std::unique_ptr<InputRecorder> m_input_recorder;
+        std::unique_ptr<InputReplayer> m_input_replayer;
+
+        TripleBuffer<SimulationInput> m_simulation_input;
+        TripleBuffer<WorldSnapshot> m_world_snapshots;
+        std::atomic<int> m_simulation_ticks{};
+
+    private:
+        void updateTitle(int frames, int updates, double frame_time);
+        void runInline();
+        void runThreaded();
+        void runSimulation(std::stop_token stop_token);
+
     public:
-        Application(int unsigned width, int unsigned height, char const * title, bool maximized);
+        Application(int unsigned width, int unsigned height, char const * title, bool maximized, uint32_t worker_count = 0);
+
+        void recordInput(char const * file_path);
+        void replayInput(char const * file_path);
 
         void run();
         void onEvent(Event const & event);
@@ -1,5 +1,9 @@
+#include <string>
+
 #include <imgui.h>
 
+#include "logger.hpp"
+
 #include "debug_controls.hpp"
 
 namespace eng
@@ -52,6 +56,51 @@ namespace eng
             ImGui::SameLine();
             if (ImGui::Button("Save As Default")) saveDefaultValues(world.getGenerationSpec());
             values_changed |= ImGui::DragFloat("Threshold", &world.m_threshold, 0.05f);
+            // Both variants show up in the profiler's GPU track, so their dispatch times can be compared directly
+            values_changed |= ImGui::Checkbox("Specialized Kernels", &world.m_specialized_kernels);
+            bool bricked = world.m_density_layout == DensityLayout::BRICKED;
+            if (ImGui::Checkbox("Bricked Density Layout", &bricked)) world.setDensityLayout(bricked ? DensityLayout::BRICKED : DensityLayout::LINEAR);
+            bool tiled_meshing = world.m_tiled_meshing;
+            if (ImGui::Checkbox("Tiled Meshing", &tiled_meshing)) world.setTiledMeshing(tiled_meshing);
+            ImGui::Checkbox("Batched Generation", &world.m_batched_generation);
+            ImGui::Text("Last generation: %zu chunks in %.2f ms", world.m_generated_chunk_count, world.m_generation_time_ms);
+            bool skip_uniform_chunks = world.m_skip_uniform_chunks;
+            if (ImGui::Checkbox("Skip Uniform Chunks", &skip_uniform_chunks)) world.setSkipUniformChunks(skip_uniform_chunks);
+            ImGui::Text("Skipped: %zu of %zu visible chunks", world.m_skipped_chunks.size(), world.m_visible_chunk_count);
+            ChunkPool & pool = world.m_chunk_pool;
+            ImGui::Text("Pool: %zu of %zu chunks active in %zu slabs, %.1f of %zu MiB", pool.getActiveCount(), pool.getCapacity(), pool.getSlabCount(), pool.getMemoryUsage() / 1048576.0, pool.getMemoryBudget() >> 20);
+            int budget_mb = static_cast<int>(pool.getMemoryBudget() >> 20);
+            if (ImGui::SliderInt("Pool Budget (MiB)", &budget_mb, 64, 4096))
+            {
+                physx::PxSceneWriteLock scene_lock(*world.m_scene);
+                pool.setMemoryBudget(static_cast<size_t>(budget_mb) << 20);
+            }
+            int cache_mb = static_cast<int>(pool.getCacheBudget() >> 20);
+            if (ImGui::SliderInt("Chunk Cache (MiB)", &cache_mb, 0, 1024)) pool.setCacheBudget(static_cast<size_t>(cache_mb) << 20);
+            size_t const cache_lookups = pool.getCacheHits() + pool.getCacheMisses();
+            ImGui::Text("Cache: %zu parked, %.1f%% hit rate, %zu evicted", pool.getParkedCount(), cache_lookups ? 100.0 * pool.getCacheHits() / cache_lookups : 0.0, pool.getCacheEvictions());
+            ImGui::Text("Restored %zu chunks, ~%.1f ms of GPU generation saved", world.m_restored_chunk_count, world.m_generation_ms_saved);
+            ImGui::Checkbox("Predictive Prefetch", &world.m_prefetch);
+            ImGui::Text("Prefetch: %zu used, %zu queued", world.m_prefetch_hit_count, world.m_prefetch_queue.size());
+            ImGui::Text("Frames with visible chunks generating: %zu of %zu", world.getFramesWithMissingChunks(), world.getPresentedFrameCount());
+            for (int job = 0; job < World::CHUNK_JOB_COUNT; ++job)
+            {
+                ImGui::Text("%s: %zu completed, %zu cancelled", World::CHUNK_JOB_NAMES[job], world.m_completed_chunk_jobs[job], world.m_cancelled_chunk_jobs[job]);
+            }
+            for (auto const & event : pool.getEvents())
+            {
+                char const * const names[] = { "Allocated", "Released", "Out of budget" };
+                ImGui::Text("  %s slab %zu, capacity %zu", names[event.m_type], event.m_slab, event.m_capacity);
+            }
+            if (ImGui::Button("Benchmark Meshing")) world.benchmarkMeshing(20);
+            ImGui::SameLine();
+            if (ImGui::Button("Validate Mesh Compaction")) ENG_LOG_F("Mesh compaction validated, %d mismatching chunks", world.validateMeshCompaction());
+            for (int kernel = 0; kernel < World::COMPUTE_KERNEL_COUNT; ++kernel)
+            {
+                int unsigned const size = world.m_work_group_sizes[kernel];
+                ImGui::Text("%s: %u^3, %.1f%% idle, %.3f ms", World::COMPUTE_KERNEL_NAMES[kernel], size, world.getIdleInvocationFraction(static_cast<World::ComputeKernel>(kernel), size) * 100.0f, world.m_work_group_times_ms[kernel]);
+            }
+            if (ImGui::Button("Retune Work Groups")) world.autotuneWorkGroupSizes(true);
             for (auto const & block_variable : world.getGenerationSpec())
             {
                 switch (block_variable.m_type)
@@ -73,9 +122,37 @@ namespace eng
                 }
             }
         }
+        if (ImGui::CollapsingHeader("Terrain Materials"))
+        {
+            char const * material_names[TerrainMaterial::COUNT];
+            for (int id = 0; id < TerrainMaterial::COUNT; ++id) material_names[id] = TerrainMaterial::getDescription(static_cast<TerrainMaterial::Id>(id)).m_name;
+            int brush_material = world.m_brush_material;
+            if (ImGui::Combo("Brush Material", &brush_material, material_names, TerrainMaterial::COUNT)) world.m_brush_material = static_cast<TerrainMaterial::Id>(brush_material);
+            bool palette_changed = false;
+            for (int id = 0; id < TerrainMaterial::COUNT; ++id)
+            {
+                std::string const label = std::string("Hardness ") + TerrainMaterial::getDescription(static_cast<TerrainMaterial::Id>(id)).m_name;
+                palette_changed |= ImGui::DragFloat(label.c_str(), &world.m_material_palette[id].m_hardness, 0.05f, 0.05f, 100.0f);
+            }
+            if (palette_changed) world.updateMaterialPalette();
+        }
         return values_changed;
 	}
 
+    void DebugControls::renderPhysicsStressTest(World & world)
+    {
+        if (!ImGui::CollapsingHeader("Physics Stress Test")) return;
+
+        JobSystem & job_system = world.r_game_system.getJobSystem();
+        int worker_count = static_cast<int>(job_system.getActiveWorkerCount());
+        if (ImGui::SliderInt("Worker Threads", &worker_count, 1, static_cast<int>(job_system.getWorkerCount()))) job_system.setActiveWorkerCount(static_cast<uint32_t>(worker_count));
+        ImGui::SliderInt("Bodies", &m_stress_body_count, 100, 10000);
+        if (ImGui::Button("Spawn")) world.spawnStressBodies(m_stress_body_count);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) world.clearStressBodies();
+        ImGui::Text("Dynamic bodies: %zu, PhysX simulate: %.3f ms", world.getStressBodyCount(), world.getSimulateTime());
+    }
+
     float const * DebugControls::getBufferData() const
     {
         return &m_generation_data.data()->f;
@@ -16,11 +16,13 @@ namespace eng
 		};
 		std::vector<IntOrFloat> m_generation_data;
 		bool m_tweakable_lac_per{};
+		int m_stress_body_count{ 1000 };
 	public:
 		void onShaderBlockChanged(size_t num_variables);
 		void loadDefaultValues(std::vector<Shader::BlockVariable> const & spec);
 		void saveDefaultValues(std::vector<Shader::BlockVariable> const & spec);
 		bool render(World & world);
+		void renderPhysicsStressTest(World & world);
 		float const * getBufferData() const;
 	};
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 namespace eng
 {
-    GameSystem::GameSystem()
+    GameSystem::GameSystem(uint32_t worker_count) : m_job_system(worker_count), m_asset_manager(m_job_system)
     {
 #pragma warning(push)
 #pragma warning(disable : 6011)
@@ -23,7 +23,7 @@ namespace eng
         m_px_cooking = PxCreateCooking(PX_PHYSICS_VERSION, *m_px_foundation, physx::PxCookingParams(physx::PxTolerancesScale()));
         if (!m_px_cooking) ENG_LOG("Failed to initialize PxCooking!");
 
-        m_px_cpu_dispatcher = physx::PxDefaultCpuDispatcherCreate(1);
+        ENG_LOG_F("Job system running %u workers", m_job_system.getWorkerCount());
     }
     
     GameSystem::~GameSystem()
@@ -51,9 +51,14 @@ namespace eng
         return m_px_cooking;
     }
   
-    physx::PxCpuDispatcher * GameSystem::getPhysxCpuDispatcher() const
+    physx::PxCpuDispatcher * GameSystem::getPhysxCpuDispatcher()
     {
-        return m_px_cpu_dispatcher;
+        return &m_px_cpu_dispatcher;
+    }
+
+    JobSystem & GameSystem::getJobSystem()
+    {
+        return m_job_system;
     }
   
     AssetManager & GameSystem::getAssetManager()
@@ -65,4 +70,9 @@ namespace eng
     {
         return m_gpu_synchronizer;
     }
+
+    UploadAllocator & GameSystem::getUploadAllocator()
+    {
+        return m_upload_allocator;
+    }
 }
\ No newline at end of file
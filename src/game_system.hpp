@@ -4,7 +4,10 @@
 
 #include "graphics/asset.hpp"
 #include "graphics/gpu_synchronizer.hpp"
+#include "graphics/upload_allocator.hpp"
+#include "job_system.hpp"
 #include "logger.hpp"
+#include "profiler.hpp"
 
 namespace eng
 {
@@ -34,26 +37,55 @@ namespace eng
             }
         } m_px_error_callback;
 
+        // Runs PhysX tasks on the engine job system instead of a separate PhysX thread pool
+        class EngPxCpuDispatcher : public physx::PxCpuDispatcher
+        {
+        private:
+            JobSystem & r_job_system;
+
+        public:
+            explicit EngPxCpuDispatcher(JobSystem & job_system) : r_job_system(job_system) {}
+
+            void submitTask(physx::PxBaseTask & task) override
+            {
+                r_job_system.submit([&task]
+                {
+                    ENG_PROFILE_SCOPE(task.getName());
+                    task.run();
+                    task.release();
+                });
+            }
+
+            uint32_t getWorkerCount() const override
+            {
+                return r_job_system.getActiveWorkerCount();
+            }
+        };
+
     private:
+        JobSystem m_job_system;
+        EngPxCpuDispatcher m_px_cpu_dispatcher{ m_job_system };
         physx::PxFoundation * m_px_foundation;
         physx::PxPhysics * m_px_physics;
         physx::PxCooking * m_px_cooking;
         physx::PxPvd * m_px_pvd;
         physx::PxPvdTransport * m_pvd_transport;
-        physx::PxCpuDispatcher * m_px_cpu_dispatcher;
         AssetManager m_asset_manager;
         GpuSynchronizer m_gpu_synchronizer;
+        UploadAllocator m_upload_allocator;
 
     public:
-        GameSystem();
+        explicit GameSystem(uint32_t worker_count = 0);
         ~GameSystem();
 
         physx::PxFoundation * getPhysxFoundation() const;
         physx::PxPhysics * getPhysx() const;
         physx::PxCooking * getPhysxCooking() const;
-        physx::PxCpuDispatcher * getPhysxCpuDispatcher() const;
+        physx::PxCpuDispatcher * getPhysxCpuDispatcher();
 
+        JobSystem & getJobSystem();
         AssetManager & getAssetManager();
         GpuSynchronizer & getGpuSynchronizer();
+        UploadAllocator & getUploadAllocator();
     };
 }
\ No newline at end of file
@@ -6,20 +6,51 @@
 
 namespace eng
 {
+    AssetManager::AssetManager(JobSystem & job_system) : m_texture_loader(job_system)
+    {
+        Shader::enableParallelCompile();
+    }
+
     AssetManager::~AssetManager()
     {
         glDeleteBuffers(static_cast<GLsizei>(m_buffers.size()), m_buffers.data());
         glDeleteVertexArrays(static_cast<GLsizei>(m_vertex_arrays.size()), m_vertex_arrays.data());
     }
 
-    std::shared_ptr<Shader> & AssetManager::getShader(char const * key)
+    std::shared_ptr<Shader> & AssetManager::getShader(char const * key, Shader::Defines const & defines)
     {
-        return (*m_shaders.try_emplace(key, std::make_shared<Shader>(key)).first).second;
+        std::string permutation_key = key;
+        for (auto const & define : defines) permutation_key += "|" + define.m_name + "=" + define.m_value;
+        auto shader = m_shaders.find(permutation_key);
+        if (shader == m_shaders.end()) shader = m_shaders.emplace(std::move(permutation_key), std::make_shared<Shader>(key, defines)).first; // Only compile on a miss
+        return shader->second;
     }
 
     std::shared_ptr<Texture> & AssetManager::getTexture(char const * key)
     {
-        return (*m_textures.try_emplace(key, std::make_shared<Texture>(key)).first).second;
+        auto texture = m_textures.find(key);
+        if (texture == m_textures.end())
+        {
+            texture = m_textures.emplace(key, std::make_shared<Texture>()).first;
+            m_texture_loader.load(texture->second, key);
+        }
+        return texture->second;
+    }
+
+    std::shared_ptr<Texture> & AssetManager::getTextureArray(char const * key, std::vector<std::string> const & layer_paths)
+    {
+        auto texture = m_textures.find(key);
+        if (texture == m_textures.end())
+        {
+            texture = m_textures.emplace(key, std::make_shared<Texture>(GL_TEXTURE_2D_ARRAY)).first;
+            m_texture_loader.loadLayers(texture->second, layer_paths);
+        }
+        return texture->second;
+    }
+
+    TextureLoader & AssetManager::getTextureLoader()
+    {
+        return m_texture_loader;
     }
 
     GLuint AssetManager::createBuffer()
@@ -1,28 +1,37 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "graphics/shader.hpp"
 #include "graphics/texture.hpp"
+#include "graphics/texture_loader.hpp"
+#include "job_system.hpp"
 
 namespace eng
 {
     class AssetManager
     {
     private:
-        std::unordered_map<char const *, std::shared_ptr<Shader>> m_shaders;
-        std::unordered_map<char const *, std::shared_ptr<Texture>> m_textures;
+        std::unordered_map<std::string, std::shared_ptr<Shader>> m_shaders; // Keyed by path and defines, one per permutation
+        std::unordered_map<std::string, std::shared_ptr<Texture>> m_textures;
+        TextureLoader m_texture_loader;
 
         std::vector<GLuint> m_buffers;
         std::vector<GLuint> m_vertex_arrays;
 
     public:
+        explicit AssetManager(JobSystem & job_system);
         ~AssetManager();
 
-        std::shared_ptr<Shader> & getShader(char const * key);
+        std::shared_ptr<Shader> & getShader(char const * key, Shader::Defines const & defines = {});
+        // Returns immediately, the texture is decoded on the job system and uploaded over the next frames
         std::shared_ptr<Texture> & getTexture(char const * key);
+        // One layer per path, key only identifies the array
+        std::shared_ptr<Texture> & getTextureArray(char const * key, std::vector<std::string> const & layer_paths);
+        TextureLoader & getTextureLoader();
 
         GLuint createBuffer();
         void deleteBuffer(GLuint buffer);
@@ -0,0 +1,101 @@
+#include <fstream>
+
+#include "graphics/dds.hpp"
+
+namespace eng::Dds
+{
+    namespace
+    {
+        uint32_t constexpr MAGIC = 0x20534444; // "DDS "
+        uint32_t constexpr FOURCC_DXT1 = 0x31545844, FOURCC_DX10 = 0x30315844;
+        uint32_t constexpr DXGI_FORMAT_BC1_UNORM = 71, DXGI_FORMAT_BC7_UNORM = 98;
+
+        uint32_t constexpr DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+        uint32_t constexpr DDPF_FOURCC = 0x4;
+        uint32_t constexpr DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+        uint32_t constexpr D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+        struct PixelFormat
+        {
+            uint32_t m_size, m_flags, m_four_cc, m_rgb_bit_count;
+            uint32_t m_r_mask, m_g_mask, m_b_mask, m_a_mask;
+        };
+
+        struct Header
+        {
+            uint32_t m_size, m_flags, m_height, m_width, m_pitch_or_linear_size, m_depth, m_mip_map_count;
+            uint32_t m_reserved_1[11];
+            PixelFormat m_pixel_format;
+            uint32_t m_caps, m_caps_2, m_caps_3, m_caps_4, m_reserved_2;
+        };
+
+        struct HeaderDx10
+        {
+            uint32_t m_dxgi_format, m_resource_dimension, m_misc_flag, m_array_size, m_misc_flags_2;
+        };
+
+        static_assert(sizeof(Header) == 124 && sizeof(PixelFormat) == 32 && sizeof(HeaderDx10) == 20);
+    }
+
+    bool read(char const * path, MipChain & out_image)
+    {
+        std::ifstream stream(path, std::ios::in | std::ios::binary);
+        uint32_t magic = 0;
+        Header header{};
+        if (!stream.read(reinterpret_cast<char *>(&magic), sizeof(magic)) || magic != MAGIC) return false;
+        if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.m_size != sizeof(Header)) return false;
+        if (!(header.m_pixel_format.m_flags & DDPF_FOURCC)) return false;
+
+        if (header.m_pixel_format.m_four_cc == FOURCC_DXT1)
+        {
+            out_image.m_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        }
+        else if (header.m_pixel_format.m_four_cc == FOURCC_DX10)
+        {
+            HeaderDx10 header_dx10{};
+            if (!stream.read(reinterpret_cast<char *>(&header_dx10), sizeof(header_dx10))) return false;
+            if (header_dx10.m_dxgi_format == DXGI_FORMAT_BC1_UNORM) out_image.m_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            else if (header_dx10.m_dxgi_format == DXGI_FORMAT_BC7_UNORM) out_image.m_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+            else return false;
+        }
+        else return false;
+
+        out_image.m_width = static_cast<int>(header.m_width);
+        out_image.m_height = static_cast<int>(header.m_height);
+        out_image.m_levels.resize((header.m_flags & DDSD_MIPMAPCOUNT) && header.m_mip_map_count > 0 ? header.m_mip_map_count : 1);
+        for (size_t level = 0; level < out_image.m_levels.size(); ++level)
+        {
+            out_image.m_levels[level].resize(out_image.getLevelSize(level));
+            if (!stream.read(reinterpret_cast<char *>(out_image.m_levels[level].data()), out_image.m_levels[level].size())) return false;
+        }
+        return true;
+    }
+
+    bool write(char const * path, MipChain const & image)
+    {
+        bool const bc7 = image.m_format == GL_COMPRESSED_RGBA_BPTC_UNORM;
+        if (!bc7 && image.m_format != GL_COMPRESSED_RGB_S3TC_DXT1_EXT) return false;
+
+        Header header{};
+        header.m_size = sizeof(Header);
+        header.m_flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+        header.m_height = static_cast<uint32_t>(image.m_height);
+        header.m_width = static_cast<uint32_t>(image.m_width);
+        header.m_pitch_or_linear_size = static_cast<uint32_t>(image.getLevelSize(0));
+        header.m_mip_map_count = static_cast<uint32_t>(image.m_levels.size());
+        header.m_pixel_format = { sizeof(PixelFormat), DDPF_FOURCC, bc7 ? FOURCC_DX10 : FOURCC_DXT1, 0, 0, 0, 0, 0 };
+        header.m_caps = DDSCAPS_TEXTURE | (image.m_levels.size() > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+        std::ofstream stream(path, std::ios::out | std::ios::binary);
+        if (!stream) return false;
+        stream.write(reinterpret_cast<char const *>(&MAGIC), sizeof(MAGIC));
+        stream.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        if (bc7)
+        {
+            HeaderDx10 const header_dx10{ DXGI_FORMAT_BC7_UNORM, D3D10_RESOURCE_DIMENSION_TEXTURE2D, 0, 1, 0 };
+            stream.write(reinterpret_cast<char const *>(&header_dx10), sizeof(header_dx10));
+        }
+        for (auto const & level : image.m_levels) stream.write(reinterpret_cast<char const *>(level.data()), level.size());
+        return static_cast<bool>(stream);
+    }
+}
\ No newline at end of file
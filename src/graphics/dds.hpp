@@ -0,0 +1,14 @@
+#pragma once
+
+#include "graphics/mip_chain.hpp"
+
+namespace eng
+{
+    // Minimal DDS container for BC1 (DXT1) and BC7 (DX10 header) mip chains. Rows are stored bottom up like the rest
+    // of the engine's textures, not top down like most DDS tools expect.
+    namespace Dds
+    {
+        bool read(char const * path, MipChain & out_image);
+        bool write(char const * path, MipChain const & image);
+    }
+}
\ No newline at end of file
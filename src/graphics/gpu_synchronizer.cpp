@@ -2,6 +2,7 @@
 #include <vector>
 
 #include "logger.hpp"
+#include "profiler.hpp"
 
 #include "gpu_synchronizer.hpp"
 
@@ -21,6 +22,7 @@ namespace eng
             glGetSynciv((*iterator).first, GL_SYNC_STATUS, sizeof(result), nullptr, result);
             if (result[0] == GL_SIGNALED)
             {
+                ENG_PROFILE_SCOPE("GpuSynchronizer callback");
                 (*iterator).second();
                 glDeleteSync((*iterator).first);
                 iterator = m_fences.erase(iterator);
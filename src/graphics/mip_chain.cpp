@@ -0,0 +1,63 @@
+#include <algorithm>
+
+#include "graphics/mip_chain.hpp"
+
+namespace eng
+{
+    uint32_t MipChain::getBlockSize(GLenum format)
+    {
+        switch (format)
+        {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:   return 8;
+            case GL_COMPRESSED_RGBA_BPTC_UNORM:     return 16;
+            default:                                return 0;
+        }
+    }
+
+    int MipChain::getLevelWidth(size_t level) const
+    {
+        return std::max(m_width >> level, 1);
+    }
+
+    int MipChain::getLevelHeight(size_t level) const
+    {
+        return std::max(m_height >> level, 1);
+    }
+
+    size_t MipChain::getLevelSize(size_t level) const
+    {
+        size_t const width = static_cast<size_t>(getLevelWidth(level)), height = static_cast<size_t>(getLevelHeight(level));
+        uint32_t const block_size = getBlockSize(m_format);
+        if (block_size == 0) return width * height * 4;
+        return (width + 3) / 4 * ((height + 3) / 4) * block_size;
+    }
+
+    void MipChain::generateMips()
+    {
+        m_levels.resize(1);
+        for (size_t level = 1; getLevelWidth(level - 1) > 1 || getLevelHeight(level - 1) > 1; ++level)
+        {
+            int const width = getLevelWidth(level - 1), height = getLevelHeight(level - 1);
+            int const next_width = getLevelWidth(level), next_height = getLevelHeight(level);
+            std::vector<uint8_t> const & source = m_levels.back();
+            std::vector<uint8_t> destination(getLevelSize(level));
+            for (int y = 0; y < next_height; ++y)
+            {
+                uint8_t const * row_0 = source.data() + static_cast<size_t>(std::min(2 * y, height - 1)) * width * 4;
+                uint8_t const * row_1 = source.data() + static_cast<size_t>(std::min(2 * y + 1, height - 1)) * width * 4;
+                uint8_t * destination_row = destination.data() + static_cast<size_t>(y) * next_width * 4;
+                // Branch free inner loop over bytes, so the compiler can vectorize it
+                for (int x = 0; x < next_width; ++x)
+                {
+                    int const left = std::min(2 * x, width - 1) * 4, right = std::min(2 * x + 1, width - 1) * 4;
+                    for (int channel = 0; channel < 4; ++channel)
+                    {
+                        int sum = row_0[left + channel] + row_0[right + channel] + row_1[left + channel] + row_1[right + channel];
+                        destination_row[x * 4 + channel] = static_cast<uint8_t>((sum + 2) >> 2);
+                    }
+                }
+            }
+            m_levels.push_back(std::move(destination));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Core GL only has BPTC, S3TC comes from EXT_texture_compression_s3tc which every desktop driver exposes
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+namespace eng
+{
+    // CPU side texture data, either RGBA8 texels or 4x4 blocks of a BCn format. Level 0 first.
+    struct MipChain
+    {
+        GLenum m_format{ GL_RGBA8 };
+        int m_width{}, m_height{};
+        std::vector<std::vector<uint8_t>> m_levels;
+
+        // Bytes per 4x4 block, 0 for uncompressed RGBA8
+        static uint32_t getBlockSize(GLenum format);
+
+        int getLevelWidth(size_t level) const;
+        int getLevelHeight(size_t level) const;
+        size_t getLevelSize(size_t level) const;
+
+        // Replaces everything but level 0 with a 2x2 box filtered chain down to 1x1, RGBA8 only. Odd edges repeat
+        // their last texel.
+        void generateMips();
+    };
+}
\ No newline at end of file
@@ -1,12 +1,23 @@
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
+#include <GLFW/glfw3.h>
+
+#include "graphics/shader_cache.hpp"
 #include "logger.hpp"
+#include "profiler.hpp"
 
 #include "graphics/shader.hpp"
 
 namespace eng
 {
+    // GL_COMPLETION_STATUS_KHR, the generated loader doesn't include the parallel compile extensions
+    GLenum constexpr COMPLETION_STATUS = 0x91B1;
+
     static GLenum customShaderTypeToGLenum(std::string const & shader_type_token)
     {
         if (shader_type_token == "vert")        return GL_VERTEX_SHADER;
@@ -16,10 +27,8 @@ namespace eng
         return 0;
     }
 
-    static std::unordered_map<GLenum, std::string> parseCustomShader(char const * file_path)
+    static std::unordered_map<GLenum, std::string> parseCustomShader(std::string const & source)
     {
-        std::ifstream file(file_path, std::ios::in);
-        std::string source{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
         // Break shaders according to #shader <shader_type>
         std::unordered_map<GLenum, std::string> shader_sources;
 
@@ -40,8 +49,58 @@ namespace eng
         return shader_sources;
     }
 
+    // Replaces #include "file" lines with the contents of file, relative to the including file. Every file is included
+    // at most once per stage, so shared files don't need guards.
+    static void expandIncludes(std::filesystem::path const & file_path, std::string & out_source, std::unordered_set<std::string> & included_files)
+    {
+        std::ifstream file(file_path, std::ios::in);
+        if (!file)
+        {
+            ENG_LOG_F("Couldn't open shader source %s", file_path.string().c_str());
+            return;
+        }
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            size_t directive = line.find_first_not_of(" \t");
+            if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+            {
+                if (directive != std::string::npos && line.compare(directive, 7, "#shader") == 0) included_files.clear();
+                out_source += line;
+                out_source += '\n';
+                continue;
+            }
+
+            size_t open_quote = line.find('"', directive), close_quote = line.find('"', open_quote + 1);
+            if (open_quote == std::string::npos || close_quote == std::string::npos)
+            {
+                ENG_LOG_F("Malformed include in %s: %s", file_path.string().c_str(), line.c_str());
+                continue;
+            }
+            std::filesystem::path include_path = (file_path.parent_path() / line.substr(open_quote + 1, close_quote - open_quote - 1)).lexically_normal();
+            if (included_files.insert(include_path.generic_string()).second) expandIncludes(include_path, out_source, included_files);
+        }
+    }
+
+    static std::string makeDefineLines(Shader::Defines const & defines)
+    {
+        std::string define_lines;
+        for (auto const & define : defines) define_lines += "#define " + define.m_name + " " + define.m_value + "\n";
+        return define_lines;
+    }
+
+    static void injectDefines(std::string & stage_source, std::string const & define_lines)
+    {
+        // Defines have to follow #version, which has to come first
+        size_t version = stage_source.find("#version");
+        size_t end_of_version = version == std::string::npos ? std::string::npos : stage_source.find('\n', version);
+        stage_source.insert(end_of_version == std::string::npos ? 0 : end_of_version + 1, define_lines);
+    }
+
     static std::vector<GLuint> compileCustomShaders(std::unordered_map<GLenum, std::string> const & shader_sources)
     {
+        // Compile status isn't queried here, that would wait for the driver. Errors are reported when the link fails.
         std::vector<GLuint> compiled_shaders;
         for (auto & map_pair : shader_sources)
         {
@@ -49,80 +108,136 @@ namespace eng
             const GLchar * src = map_pair.second.c_str();
             glShaderSource(shader_handle, 1, &src, nullptr);
             glCompileShader(shader_handle);
+            compiled_shaders.push_back(shader_handle);
+        }
+        return compiled_shaders;
+    }
 
-#ifdef ENG_DEBUG
-            GLint is_compiled;
-            glGetShaderiv(shader_handle, GL_COMPILE_STATUS, &is_compiled);
-            if (is_compiled == GL_FALSE)
+    void Shader::enableParallelCompile()
+    {
+        GLint extension_count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+        for (GLint i = 0; i < extension_count; ++i)
+        {
+            std::string_view extension = reinterpret_cast<char const *>(glGetStringi(GL_EXTENSIONS, i));
+            char const * function_name = nullptr;
+            if (extension == "GL_KHR_parallel_shader_compile") function_name = "glMaxShaderCompilerThreadsKHR";
+            else if (extension == "GL_ARB_parallel_shader_compile") function_name = "glMaxShaderCompilerThreadsARB";
+            else continue;
+
+            using MaxShaderCompilerThreads = void (APIENTRYP)(GLuint count);
+            if (auto max_shader_compiler_threads = reinterpret_cast<MaxShaderCompilerThreads>(glfwGetProcAddress(function_name)))
             {
-                ENG_LOG_F("Failed to compile type %d shader!", map_pair.first);
-
-                constexpr GLsizei MAX_LOG_LENGTH = 512;
-                GLsizei log_length = 0;
-                GLchar info_log[MAX_LOG_LENGTH];
-                glGetShaderInfoLog(shader_handle, MAX_LOG_LENGTH, &log_length, &info_log[0]);
-
-                glDeleteShader(shader_handle);
-
-                ENG_LOG(info_log);
+                max_shader_compiler_threads(0xFFFFFFFF); // Let the driver pick
+                s_parallel_compile = true;
+                ENG_LOG_F("Parallel shader compilation enabled (%s)", extension.data());
+                return;
             }
-#endif
-            compiled_shaders.push_back(shader_handle);
         }
-        return compiled_shaders;
     }
 
-    Shader::Shader(char const * file_path)
+    Shader::CompileStatistics const & Shader::getCompileStatistics()
+    {
+        return s_statistics;
+    }
+
+    Shader::Shader(char const * file_path, Defines defines) : m_defines(std::move(defines))
     {
         compile(file_path);
     }
 
     void Shader::compile(char const * file_path)
     {
-        ENG_LOG_F("Compiled shader %s", file_path);
-        std::vector<GLuint> compiled_shaders = compileCustomShaders(parseCustomShader(file_path));
-
+        auto start = std::chrono::steady_clock::now();
+        std::string source;
+        std::unordered_set<std::string> included_files;
+        expandIncludes(file_path, source, included_files);
+        std::string const define_lines = makeDefineLines(m_defines);
+
+        for (auto shader_handle : m_pending_shaders) glDeleteShader(shader_handle);
+        m_pending_shaders.clear();
+        glDeleteProgram(m_id);
         m_id = glCreateProgram();
+        m_cache_key = ShaderCache::hashSource(define_lines + source);
 
-        for (auto & shader_handle : compiled_shaders)
+        if (ShaderCache::load(m_cache_key, m_id))
         {
-            glAttachShader(m_id, shader_handle);
+            ENG_LOG_F("Loaded shader %s from cache", file_path);
+            ++s_statistics.m_cache_hits;
+            m_link_pending = false;
+            cacheUniformLocations();
         }
+        else
+        {
+            ENG_LOG_F("Compiling shader %s", file_path);
+            ++s_statistics.m_compiled;
+            auto shader_sources = parseCustomShader(source);
+            if (!define_lines.empty()) for (auto & shader_source : shader_sources) injectDefines(shader_source.second, define_lines);
+            m_pending_shaders = compileCustomShaders(shader_sources);
+            for (auto & shader_handle : m_pending_shaders)
+            {
+                glAttachShader(m_id, shader_handle);
+            }
+            glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(m_id);
+            m_link_pending = true;
+        }
+        s_statistics.m_cpu_time_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
 
-        glLinkProgram(m_id);
-        glValidateProgram(m_id);
+    bool Shader::finishLink(bool wait)
+    {
+        // Without parallel compilation the driver links on this thread, there's nothing to poll
+        if (!wait && s_parallel_compile)
+        {
+            GLint is_complete = GL_FALSE;
+            glGetProgramiv(m_id, COMPLETION_STATUS, &is_complete);
+            if (is_complete == GL_FALSE) return false;
+        }
+        ENG_PROFILE_SCOPE("Shader::finishLink");
+        auto start = std::chrono::steady_clock::now();
+        m_link_pending = false;
 
-#ifdef ENG_DEBUG
         GLint is_linked = 0;
         glGetProgramiv(m_id, GL_LINK_STATUS, &is_linked);
-        if (is_linked == GL_FALSE)
+        if (is_linked == GL_TRUE)
         {
-            ENG_LOG("Failed to link program!");
-
+            ShaderCache::store(m_cache_key, m_id);
+        }
+        else
+        {
+#ifdef ENG_DEBUG
             constexpr GLsizei MAX_LOG_LENGTH = 512;
             GLsizei log_length = 0;
             GLchar info_log[MAX_LOG_LENGTH];
-            glGetProgramInfoLog(m_id, MAX_LOG_LENGTH, &log_length, &info_log[0]);
-
-            glDeleteProgram(m_id);
-
-            for (auto & shader_handle : compiled_shaders)
+            for (auto & shader_handle : m_pending_shaders)
             {
-                glDeleteShader(shader_handle);
+                GLint is_compiled;
+                glGetShaderiv(shader_handle, GL_COMPILE_STATUS, &is_compiled);
+                if (is_compiled == GL_TRUE) continue;
+                glGetShaderInfoLog(shader_handle, MAX_LOG_LENGTH, &log_length, &info_log[0]);
+                ENG_LOG("Failed to compile shader!");
+                ENG_LOG(info_log);
             }
-
+            glGetProgramInfoLog(m_id, MAX_LOG_LENGTH, &log_length, &info_log[0]);
+            ENG_LOG("Failed to link program!");
             ENG_LOG_F("Log length: %d", log_length);
             ENG_LOG(info_log);
-            return;
-        }
 #endif
+        }
 
-        for (auto & shader_handle : compiled_shaders)
+        for (auto & shader_handle : m_pending_shaders)
         {
             glDeleteShader(shader_handle);
         }
+        m_pending_shaders.clear();
+        if (is_linked == GL_TRUE) cacheUniformLocations();
+        s_statistics.m_cpu_time_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
 
-        // Cache all uniform locations
+    void Shader::cacheUniformLocations()
+    {
         m_uniform_locations.clear();
         GLint uniform_count;
         glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniform_count);
@@ -137,81 +252,91 @@ namespace eng
             std::string name(values[1], ' ');
             glGetProgramResourceName(m_id, GL_UNIFORM, uniform, static_cast<GLsizei>(values[1]), nullptr, name.data());
             name.pop_back(); // \0 means nothing in an std::string, but this mf ^ will add one regardless
-            m_uniform_locations[name] = values[2];
+            uint32_t slot = UniformId(name).getSlot();
+            if (slot >= m_uniform_locations.size()) m_uniform_locations.resize(slot + 1, -1);
+            m_uniform_locations[slot] = values[2];
         }
     }
 
+    GLint Shader::getUniformLocation(UniformId uniform) const
+    {
+        return uniform.getSlot() < m_uniform_locations.size() ? m_uniform_locations[uniform.getSlot()] : -1;
+    }
+
     Shader::~Shader()
     {
         glDeleteProgram(m_id);
     }
 
-    void Shader::bind() const
+    bool Shader::isReady()
+    {
+        return !m_link_pending || finishLink(false);
+    }
+
+    void Shader::bind()
     {
+        if (m_link_pending) finishLink(true);
         glUseProgram(m_id);
     }
 
-#if defined(ENG_DEBUG) && ENG_DETECT_INACTIVE_UNIFORMS
-    #if ENG_VERBOSE_UNIFORM_CHECKER
-        #define ENG_UNIFORM_CHECKER if (m_uniform_locations.find(name) == m_uniform_locations.end()) { ENG_LOG_F("Matrix4fv uniform with name %s does not exist!", name); return; }
-    #else
-        #define ENG_UNIFORM_CHECKER if (m_uniform_locations.find(name) == m_uniform_locations.end()) { return; }
-    #endif
+#if defined(ENG_DEBUG) && ENG_VERBOSE_UNIFORM_CHECKER
+    #define ENG_UNIFORM_CHECKER if (location == -1) { ENG_LOG_F("Uniform with name %s does not exist!", uniform.getName()); return; }
 #else
-    #define ENG_UNIFORM_CHECKER
+    #define ENG_UNIFORM_CHECKER if (location == -1) { return; }
 #endif
 
-    void Shader::setUniformMatrix3f(char const * name, glm::mat3 const & data)
+    void Shader::setUniformMatrix3f(UniformId uniform, glm::mat3 const & data)
     {
+        GLint location = getUniformLocation(uniform);
         ENG_UNIFORM_CHECKER;
-        GLuint location = m_uniform_locations.at(name);
         glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(data));
     }
 
-    void Shader::setUniformMatrix4f(char const * name, glm::mat4 const & data)
+    void Shader::setUniformMatrix4f(UniformId uniform, glm::mat4 const & data)
     {
+        GLint location = getUniformLocation(uniform);
         ENG_UNIFORM_CHECKER;
-        GLuint location = m_uniform_locations.at(name);
         glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(data));
     }
 
-    void Shader::setUniformVector2f(char const * name, glm::vec2 const & data)
+    void Shader::setUniformVector2f(UniformId uniform, glm::vec2 const & data)
     {
+        GLint location = getUniformLocation(uniform);
         ENG_UNIFORM_CHECKER;
-        GLuint location = m_uniform_locations.at(name);
         glUniform2f(location, data.x, data.y);
     }
 
-    void Shader::setUniformVector3f(char const * name, glm::vec3 const & data)
+    void Shader::setUniformVector3f(UniformId uniform, glm::vec3 const & data)
     {
+        GLint location = getUniformLocation(uniform);
         ENG_UNIFORM_CHECKER;
-        GLuint location = m_uniform_locations.at(name);
         glUniform3f(location, data.x, data.y, data.z);
     }
 
-    void Shader::setUniformFloat(char const * name, float data)
+    void Shader::setUniformFloat(UniformId uniform, float data)
     {
+        GLint location = getUniformLocation(uniform);
         ENG_UNIFORM_CHECKER;
-        GLuint location = m_uniform_locations.at(name);
         glUniform1f(location, data);
     }
 
-    void Shader::setUniformInt(char const * name, int data)
+    void Shader::setUniformInt(UniformId uniform, int data)
     {
+        GLint location = getUniformLocation(uniform);
         ENG_UNIFORM_CHECKER;
-        GLuint location = m_uniform_locations.at(name);
         glUniform1i(location, data);
     }
 
-    void Shader::setUniformUInt(char const * name, int unsigned data)
+    void Shader::setUniformUInt(UniformId uniform, int unsigned data)
     {
+        GLint location = getUniformLocation(uniform);
         ENG_UNIFORM_CHECKER;
-        GLuint location = m_uniform_locations.at(name);
         glUniform1ui(location, data);
     }
 
     std::vector<Shader::BlockVariable> Shader::getBlockUniformInfo()
     {
+        if (m_link_pending) finishLink(true);
         std::vector<BlockVariable> block_uniform_names;
         GLint uniform_count;
         glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniform_count);
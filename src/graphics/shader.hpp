@@ -4,13 +4,14 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include "graphics/uniform_id.hpp"
+
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 
-#define ENG_DETECT_INACTIVE_UNIFORMS 1
 #define ENG_VERBOSE_UNIFORM_CHECKER 0
 
 namespace eng
@@ -24,24 +25,58 @@ namespace eng
             GLenum m_type;
             GLint m_buffer_offset;
         };
+        // Injected as #define m_name m_value after the #version line of every stage
+        struct Define
+        {
+            std::string m_name, m_value;
+        };
+        using Defines = std::vector<Define>;
+        struct CompileStatistics
+        {
+            size_t m_cache_hits, m_compiled;
+            double m_cpu_time_ms; // Time spent in compile and finishing links, not the driver's background compile time
+        };
     private:
-        GLuint m_id;
-        std::unordered_map<std::string, GLuint> m_uniform_locations;
+        bool inline static s_parallel_compile{};
+        CompileStatistics inline static s_statistics{};
+
+        GLuint m_id{};
+        Defines m_defines;
+        std::vector<GLint> m_uniform_locations; // Indexed by UniformId slot, -1 for uniforms this program doesn't use
+        // Links are finished lazily on first use, so that programs compiled back to back overlap in the driver
+        std::vector<GLuint> m_pending_shaders;
+        uint64_t m_cache_key{};
+        bool m_link_pending{};
+
+    private:
+        // False if the driver is still linking on its own threads and wait isn't set
+        bool finishLink(bool wait);
+        void cacheUniformLocations();
+        GLint getUniformLocation(UniformId uniform) const;
+
     public:
-        explicit Shader(char const * file_path);
+        // Lets the driver compile and link on its own threads (KHR_parallel_shader_compile), needs a current context
+        static void enableParallelCompile();
+        static CompileStatistics const & getCompileStatistics();
+
+        explicit Shader(char const * file_path, Defines defines = {});
         ~Shader();
 
+        // Loads the program binary from the shader cache, or starts compiling from source if it misses. Recompiling
+        // keeps the defines the shader was created with, so permutations stay specialized.
         void compile(char const * file_path);
 
-        void bind() const;
+        // Whether bind() would return without waiting for the link, always the case without parallel compilation
+        bool isReady();
+        void bind();
 
-        void setUniformMatrix3f(char const * name, glm::mat3 const & data);
-        void setUniformMatrix4f(char const * name, glm::mat4 const & data);
-        void setUniformVector2f(char const * name, glm::vec2 const & data);
-        void setUniformVector3f(char const * name, glm::vec3 const & data);
-        void setUniformFloat(char const * name, float data);
-        void setUniformInt(char const * name, int data);
-        void setUniformUInt(char const * name, int unsigned data);
+        void setUniformMatrix3f(UniformId uniform, glm::mat3 const & data);
+        void setUniformMatrix4f(UniformId uniform, glm::mat4 const & data);
+        void setUniformVector2f(UniformId uniform, glm::vec2 const & data);
+        void setUniformVector3f(UniformId uniform, glm::vec3 const & data);
+        void setUniformFloat(UniformId uniform, float data);
+        void setUniformInt(UniformId uniform, int data);
+        void setUniformUInt(UniformId uniform, int unsigned data);
 
         std::vector<BlockVariable> getBlockUniformInfo();
     };
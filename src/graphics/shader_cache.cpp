@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+
+#include "graphics/shader_cache.hpp"
+
+namespace eng::ShaderCache
+{
+    namespace
+    {
+        uint32_t constexpr MAGIC = 0x43535045; // "EPSC"
+
+        struct Header
+        {
+            uint32_t m_magic;
+            GLenum m_format;
+            uint64_t m_key;
+            uint32_t m_length;
+        };
+
+        uint64_t fnv1a(std::string_view data, uint64_t hash = 0xCBF29CE484222325ull)
+        {
+            for (char c : data)
+            {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 0x100000001B3ull;
+            }
+            return hash;
+        }
+
+        uint64_t getDriverHash()
+        {
+            static uint64_t const driver_hash = []
+            {
+                std::string driver;
+                for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) driver += reinterpret_cast<char const *>(glGetString(name));
+                return fnv1a(driver);
+            }();
+            return driver_hash;
+        }
+
+        std::filesystem::path getCachePath(uint64_t key)
+        {
+            char file_name[32];
+            std::snprintf(file_name, sizeof(file_name), "%016llx.bin", static_cast<unsigned long long>(key));
+            return std::filesystem::path(CACHE_DIRECTORY) / file_name;
+        }
+    }
+
+    uint64_t hashSource(std::string_view source)
+    {
+        return fnv1a(source, getDriverHash());
+    }
+
+    bool load(uint64_t key, GLuint program)
+    {
+        std::ifstream stream(getCachePath(key), std::ios::in | std::ios::binary);
+        if (!stream) return false;
+
+        Header header{};
+        if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.m_magic != MAGIC || header.m_key != key) return false;
+        std::vector<char> binary(header.m_length);
+        if (!stream.read(binary.data(), header.m_length)) return false;
+
+        glProgramBinary(program, header.m_format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint is_linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+        return is_linked == GL_TRUE;
+    }
+
+    void store(uint64_t key, GLuint program)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        Header header{ MAGIC, 0, key, static_cast<uint32_t>(length) };
+        std::vector<char> binary(static_cast<size_t>(length));
+        glGetProgramBinary(program, length, nullptr, &header.m_format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(CACHE_DIRECTORY, error);
+        std::ofstream stream(getCachePath(key), std::ios::out | std::ios::binary);
+        if (!stream)
+        {
+            ENG_LOG_F("Failed to write shader cache entry %016llx", static_cast<unsigned long long>(key));
+            return;
+        }
+        stream.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        stream.write(binary.data(), binary.size());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include <glad/glad.h>
+
+namespace eng
+{
+    // On-disk cache of linked program binaries. Keys combine the shader source with the driver identification, so a
+    // driver update or a source edit simply misses and falls back to compiling from source.
+    namespace ShaderCache
+    {
+        char const constexpr * CACHE_DIRECTORY = "shader_cache";
+
+        uint64_t hashSource(std::string_view source);
+
+        // Loads the binary into program, false if there is none or the driver rejects it
+        bool load(uint64_t key, GLuint program);
+        void store(uint64_t key, GLuint program);
+    }
+}
\ No newline at end of file
@@ -4,19 +4,35 @@
 
 namespace eng
 {
+    // Immutable 2D texture or 2D texture array with a full mip chain, RGBA8 or block compressed. Textures start out
+    // empty and are filled by the TextureLoader over the following frames, binding one that isn't loaded yet binds
+    // nothing.
     class Texture
     {
+        friend class TextureLoader;
     private:
-        GLuint m_texture_handle;
-        int m_width, m_height;
+        GLuint m_texture_handle{};
+        GLenum m_target;
+        int m_width{}, m_height{}, m_layer_count{ 1 };
+        bool m_loaded{};
+
+    private:
+        // layer_count is ignored for GL_TEXTURE_2D
+        void allocateStorage(GLenum internal_format, int width, int height, int levels, int layer_count);
 
     public:
-        explicit Texture(char const * path);
+        explicit Texture(GLenum target = GL_TEXTURE_2D);
         ~Texture();
 
+        Texture(Texture const &) = delete;
+        Texture & operator=(Texture const &) = delete;
+
         void bind(int unsigned unit) const;
 
+        bool isLoaded() const;
         int getWidth() const;
         int getHeight() const;
+        int getLayerCount() const;
+        bool isArray() const;
     };
 }
\ No newline at end of file
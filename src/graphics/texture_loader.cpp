@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <stb_image/stb_image.hpp>
+
+#include "graphics/dds.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+
+#include "graphics/texture_loader.hpp"
+
+namespace eng
+{
+    namespace
+    {
+        uint32_t constexpr CACHE_MAGIC = 0x58545045; // "EPTX"
+        uint32_t constexpr CACHE_VERSION = 1;
+
+        struct CacheHeader
+        {
+            uint32_t m_magic, m_version;
+            uint64_t m_source_size;
+            int64_t m_source_time;
+            int32_t m_width, m_height;
+            uint32_t m_level_count;
+        };
+
+        // Size and modification time of the source, a cache entry is only used while both match
+        bool getSourceStamp(std::string const & path, uint64_t & out_size, int64_t & out_time)
+        {
+            std::error_code error;
+            out_size = std::filesystem::file_size(path, error);
+            if (error) return false;
+            out_time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+            return !error;
+        }
+
+        std::filesystem::path getCachePath(std::string const & path)
+        {
+            char file_name[32];
+            std::snprintf(file_name, sizeof(file_name), "%016llx.bin", static_cast<unsigned long long>(std::hash<std::string>{}(path)));
+            return std::filesystem::path(TextureLoader::CACHE_DIRECTORY) / file_name;
+        }
+    }
+
+    TextureLoader::TextureLoader(JobSystem & job_system) : r_job_system(job_system)
+    {
+        GLint extension_count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+        for (GLint i = 0; i < extension_count && !m_s3tc_supported; ++i)
+        {
+            std::string_view extension = reinterpret_cast<char const *>(glGetStringi(GL_EXTENSIONS, i));
+            m_s3tc_supported = extension == "GL_EXT_texture_compression_s3tc";
+        }
+    }
+
+    TextureLoader::~TextureLoader()
+    {
+        // Jobs reference the loader, textures still decoding are simply dropped afterwards
+        while (m_jobs_in_flight.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    }
+
+    bool TextureLoader::readCache(std::string const & path, MipChain & out_image)
+    {
+        uint64_t source_size;
+        int64_t source_time;
+        if (!getSourceStamp(path, source_size, source_time)) return false;
+        std::ifstream stream(getCachePath(path), std::ios::in | std::ios::binary);
+        if (!stream) return false;
+
+        CacheHeader header{};
+        if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+        if (header.m_magic != CACHE_MAGIC || header.m_version != CACHE_VERSION || header.m_source_size != source_size || header.m_source_time != source_time) return false;
+
+        out_image.m_width = header.m_width;
+        out_image.m_height = header.m_height;
+        out_image.m_levels.resize(header.m_level_count);
+        for (size_t level = 0; level < out_image.m_levels.size(); ++level)
+        {
+            out_image.m_levels[level].resize(out_image.getLevelSize(level));
+            if (!stream.read(reinterpret_cast<char *>(out_image.m_levels[level].data()), out_image.m_levels[level].size())) return false;
+        }
+        return true;
+    }
+
+    void TextureLoader::writeCache(std::string const & path, MipChain const & image)
+    {
+        CacheHeader header{ CACHE_MAGIC, CACHE_VERSION, 0, 0, image.m_width, image.m_height, static_cast<uint32_t>(image.m_levels.size()) };
+        if (!getSourceStamp(path, header.m_source_size, header.m_source_time)) return;
+
+        std::error_code error;
+        std::filesystem::create_directories(CACHE_DIRECTORY, error);
+        std::ofstream stream(getCachePath(path), std::ios::out | std::ios::binary);
+        if (!stream)
+        {
+            ENG_LOG_F("Failed to write texture cache entry for %s", path.c_str());
+            return;
+        }
+        stream.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        for (auto const & level : image.m_levels) stream.write(reinterpret_cast<char const *>(level.data()), level.size());
+    }
+
+    bool TextureLoader::decode(std::string const & path, MipChain & out_image)
+    {
+        stbi_set_flip_vertically_on_load_thread(true);
+        int channels;
+        // Always expanded to RGBA, every texture then shares one upload and filtering path
+        char unsigned * data = stbi_load(path.c_str(), &out_image.m_width, &out_image.m_height, &channels, 4);
+        if (!data)
+        {
+            ENG_LOG_F("Failed to load texture at %s! %s", path.c_str(), stbi_failure_reason());
+            return false;
+        }
+        out_image.m_format = GL_RGBA8;
+        out_image.m_levels.assign(1, std::vector<uint8_t>(data, data + out_image.getLevelSize(0)));
+        stbi_image_free(data);
+        return true;
+    }
+
+    bool TextureLoader::readCompressed(std::string const & path, MipChain & out_image) const
+    {
+        std::filesystem::path compressed_path(path);
+        compressed_path.replace_extension(".dds");
+        std::error_code error;
+        if (compressed_path == std::filesystem::path(path) || !std::filesystem::exists(compressed_path, error)) return false;
+        if (!Dds::read(compressed_path.string().c_str(), out_image)) return false;
+        return out_image.m_format != GL_COMPRESSED_RGB_S3TC_DXT1_EXT || m_s3tc_supported;
+    }
+
+    char const * TextureLoader::readImage(std::string const & path, bool allow_compressed, MipChain & out_image) const
+    {
+        if (allow_compressed && readCompressed(path, out_image)) return "Loaded compressed";
+        out_image = {};
+        if (readCache(path, out_image)) return "Loaded cached";
+        if (!decode(path, out_image)) return nullptr;
+        out_image.generateMips();
+        writeCache(path, out_image);
+        return "Decoded";
+    }
+
+    void TextureLoader::load(std::shared_ptr<Texture> texture, std::string path)
+    {
+        m_jobs_in_flight.fetch_add(1, std::memory_order_relaxed);
+        r_job_system.submit([this, texture = std::move(texture), path = std::move(path)]() mutable
+        {
+            ENG_PROFILE_SCOPE("TextureLoader::decode");
+            PendingUpload upload{ std::move(texture), path, std::vector<MipChain>(1) };
+            MipChain & image = upload.m_layers[0];
+            if (char const * source = readImage(path, true, image))
+            {
+                ENG_LOG_F("%s texture %s | Width: %d, Height %d, Levels: %zu", source, path.c_str(), image.m_width, image.m_height, image.m_levels.size());
+                std::scoped_lock lock(m_decoded_mutex);
+                m_decoded.push_back(std::move(upload));
+            }
+            m_jobs_in_flight.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    void TextureLoader::loadLayers(std::shared_ptr<Texture> texture, std::vector<std::string> paths)
+    {
+        m_jobs_in_flight.fetch_add(1, std::memory_order_relaxed);
+        r_job_system.submit([this, texture = std::move(texture), paths = std::move(paths)]() mutable
+        {
+            ENG_PROFILE_SCOPE("TextureLoader::decode");
+            PendingUpload upload{ std::move(texture), paths.empty() ? std::string() : paths[0], std::vector<MipChain>(paths.size()) };
+            auto read_layers = [&](bool allow_compressed)
+            {
+                for (size_t layer = 0; layer < paths.size(); ++layer)
+                {
+                    if (!readImage(paths[layer], allow_compressed, upload.m_layers[layer])) return false;
+                }
+                return true;
+            };
+            auto layers_match = [&]
+            {
+                return std::all_of(upload.m_layers.begin(), upload.m_layers.end(), [&](MipChain const & layer)
+                {
+                    MipChain const & first = upload.m_layers[0];
+                    return layer.m_format == first.m_format && layer.m_width == first.m_width && layer.m_height == first.m_height && layer.m_levels.size() == first.m_levels.size();
+                });
+            };
+            // One layer without a .dds decides for all of them
+            bool loaded = !paths.empty() && read_layers(true);
+            if (loaded && !layers_match()) loaded = read_layers(false) && layers_match();
+            if (loaded)
+            {
+                upload.m_path += " (+" + std::to_string(paths.size() - 1) + " layers)";
+                ENG_LOG_F("Loaded texture array %s | Width: %d, Height %d, Layers: %zu", upload.m_path.c_str(), upload.m_layers[0].m_width, upload.m_layers[0].m_height, paths.size());
+                std::scoped_lock lock(m_decoded_mutex);
+                m_decoded.push_back(std::move(upload));
+            }
+            else ENG_LOG_F("Failed to load texture array %s, its layers differ in size or didn't load", upload.m_path.c_str());
+            m_jobs_in_flight.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    void TextureLoader::update()
+    {
+        {
+            std::scoped_lock lock(m_decoded_mutex);
+            for (auto & decoded : m_decoded) m_uploads.push_back(std::move(decoded));
+            m_decoded.clear();
+        }
+        if (m_uploads.empty()) return;
+
+        ENG_PROFILE_SCOPE("TextureLoader::update");
+        m_staging.beginFrame();
+        while (!m_uploads.empty())
+        {
+            PendingUpload & upload = m_uploads.front();
+            Texture & texture = *upload.m_texture;
+            MipChain const & image = upload.m_layers[upload.m_layer];
+            if (upload.m_layer == 0 && upload.m_level == 0 && upload.m_row == 0)
+            {
+                texture.allocateStorage(image.m_format, image.m_width, image.m_height, static_cast<int>(image.m_levels.size()), static_cast<int>(upload.m_layers.size()));
+            }
+
+            // Bands are whole texel rows, or whole rows of 4x4 blocks for compressed formats. Uncompressed rows are a
+            // multiple of 4 bytes, so the default unpack alignment holds.
+            uint32_t const block_size = MipChain::getBlockSize(image.m_format);
+            int const rows_per_band_row = block_size ? 4 : 1;
+            int const level_width = image.getLevelWidth(upload.m_level), level_height = image.getLevelHeight(upload.m_level);
+            GLsizeiptr const row_size = block_size ? static_cast<GLsizeiptr>((level_width + 3) / 4) * block_size : static_cast<GLsizeiptr>(level_width) * 4;
+            int const band_rows_left = (level_height - upload.m_row + rows_per_band_row - 1) / rows_per_band_row;
+            int const band_rows = static_cast<int>(std::min<GLsizeiptr>(band_rows_left, m_staging.getFrameCapacityLeft() / row_size));
+            UploadAllocator::Allocation allocation;
+            if (band_rows <= 0 || !m_staging.allocate(band_rows * row_size, 4, allocation)) break; // Budget spent, continue next frame
+
+            int const rows = std::min(band_rows * rows_per_band_row, level_height - upload.m_row);
+            std::memcpy(allocation.m_data, image.m_levels[upload.m_level].data() + upload.m_row / rows_per_band_row * row_size, band_rows * row_size);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, allocation.m_buffer);
+            void const * offset = reinterpret_cast<void const *>(allocation.m_offset);
+            GLint const level = static_cast<GLint>(upload.m_level), layer = static_cast<GLint>(upload.m_layer);
+            GLsizei const band_size = static_cast<GLsizei>(band_rows * row_size);
+            if (texture.isArray())
+            {
+                if (block_size) glCompressedTextureSubImage3D(texture.m_texture_handle, level, 0, upload.m_row, layer, level_width, rows, 1, image.m_format, band_size, offset);
+                else glTextureSubImage3D(texture.m_texture_handle, level, 0, upload.m_row, layer, level_width, rows, 1, GL_RGBA, GL_UNSIGNED_BYTE, offset);
+            }
+            else
+            {
+                if (block_size) glCompressedTextureSubImage2D(texture.m_texture_handle, level, 0, upload.m_row, level_width, rows, image.m_format, band_size, offset);
+                else glTextureSubImage2D(texture.m_texture_handle, level, 0, upload.m_row, level_width, rows, GL_RGBA, GL_UNSIGNED_BYTE, offset);
+            }
+
+            upload.m_row += rows;
+            if (upload.m_row < level_height) continue;
+            upload.m_row = 0;
+            if (++upload.m_level < image.m_levels.size()) continue;
+            upload.m_level = 0;
+            if (++upload.m_layer < upload.m_layers.size()) continue;
+
+            size_t texture_bytes = 0, uncompressed_bytes = 0;
+            for (auto const & layer_image : upload.m_layers)
+            {
+                for (size_t layer_level = 0; layer_level < layer_image.m_levels.size(); ++layer_level)
+                {
+                    texture_bytes += layer_image.m_levels[layer_level].size();
+                    uncompressed_bytes += static_cast<size_t>(layer_image.getLevelWidth(layer_level)) * layer_image.getLevelHeight(layer_level) * 4;
+                }
+            }
+            m_resident_bytes += texture_bytes;
+            m_uncompressed_bytes += uncompressed_bytes;
+            ENG_LOG_F("Uploaded %s, %.2f MiB (%.2f MiB as RGBA8), %.2f MiB of textures resident", upload.m_path.c_str(),
+                texture_bytes / 1048576.0, uncompressed_bytes / 1048576.0, m_resident_bytes / 1048576.0);
+            texture.m_loaded = true;
+            m_uploads.pop_front();
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        m_staging.endFrame();
+    }
+
+    size_t TextureLoader::getResidentBytes() const
+    {
+        return m_resident_bytes;
+    }
+
+    size_t TextureLoader::getUncompressedBytes() const
+    {
+        return m_uncompressed_bytes;
+    }
+
+    bool TextureLoader::isIdle() const
+    {
+        if (m_jobs_in_flight.load(std::memory_order_acquire) > 0 || !m_uploads.empty()) return false;
+        std::scoped_lock lock(m_decoded_mutex);
+        return m_decoded.empty();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "graphics/mip_chain.hpp"
+#include "graphics/texture.hpp"
+#include "graphics/upload_allocator.hpp"
+#include "job_system.hpp"
+
+namespace eng
+{
+    // Decodes images and builds their mip chains on the job system, then uploads them in row bands through its own
+    // staging ring, so no frame uploads more than UPLOAD_BUDGET bytes. Decoded chains are cached on disk, which skips
+    // decoding and filtering entirely on later launches. A block compressed .dds next to the requested file, written by
+    // texture_compressor, is preferred over it when the driver supports its format. Array layers are loaded together and
+    // fall back to uncompressed if their formats don't agree.
+    class TextureLoader
+    {
+    public:
+        GLsizeiptr constexpr static UPLOAD_BUDGET = 4 * 1024 * 1024;
+        char const constexpr static * CACHE_DIRECTORY = "texture_cache";
+
+    private:
+        struct PendingUpload
+        {
+            std::shared_ptr<Texture> m_texture;
+            std::string m_path;
+            std::vector<MipChain> m_layers;
+            size_t m_layer{}, m_level{};
+            int m_row{};
+        };
+
+        JobSystem & r_job_system;
+        UploadAllocator m_staging{ UPLOAD_BUDGET };
+        std::atomic<size_t> m_jobs_in_flight{};
+        bool m_s3tc_supported{};
+        size_t m_resident_bytes{}, m_uncompressed_bytes{};
+
+        std::mutex mutable m_decoded_mutex;
+        std::vector<PendingUpload> m_decoded; // Filled by the workers
+
+        std::deque<PendingUpload> m_uploads; // Only touched by the GL thread
+
+    private:
+        static bool readCache(std::string const & path, MipChain & out_image);
+        static void writeCache(std::string const & path, MipChain const & image);
+        static bool decode(std::string const & path, MipChain & out_image);
+        bool readCompressed(std::string const & path, MipChain & out_image) const;
+        // Compressed, cached or decoded, in that order of preference. Returns which one it was, nullptr on failure.
+        char const * readImage(std::string const & path, bool allow_compressed, MipChain & out_image) const;
+
+    public:
+        explicit TextureLoader(JobSystem & job_system);
+        ~TextureLoader();
+
+        void load(std::shared_ptr<Texture> texture, std::string path);
+        // texture has to be a GL_TEXTURE_2D_ARRAY, the images must share their size
+        void loadLayers(std::shared_ptr<Texture> texture, std::vector<std::string> paths);
+        // Needs the GL context, call once per frame
+        void update();
+
+        // No texture left to decode or upload
+        bool isIdle() const;
+        // GPU memory of the loaded textures, and what they would take as RGBA8
+        size_t getResidentBytes() const;
+        size_t getUncompressedBytes() const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include "graphics/uniform_id.hpp"
+
+namespace eng
+{
+    namespace
+    {
+        struct UniformRegistry
+        {
+            std::unordered_map<std::string_view, uint32_t> m_slots;
+            std::deque<std::string> m_names; // Stable storage for the keys above
+        };
+
+        // Function local so ids declared at namespace scope in other translation units can register during static init
+        UniformRegistry & getRegistry()
+        {
+            static UniformRegistry registry;
+            return registry;
+        }
+    }
+
+    UniformId::UniformId(std::string_view name)
+    {
+        UniformRegistry & registry = getRegistry();
+        if (auto it = registry.m_slots.find(name); it != registry.m_slots.end())
+        {
+            m_slot = it->second;
+            return;
+        }
+        m_slot = static_cast<uint32_t>(registry.m_names.size());
+        registry.m_slots.emplace(registry.m_names.emplace_back(name), m_slot);
+    }
+
+    uint32_t UniformId::getSlot() const
+    {
+        return m_slot;
+    }
+
+    char const * UniformId::getName() const
+    {
+        return getRegistry().m_names[m_slot].c_str();
+    }
+
+    uint32_t UniformId::getRegisteredCount()
+    {
+        return static_cast<uint32_t>(getRegistry().m_names.size());
+    }
+}
\ No newline at end of file
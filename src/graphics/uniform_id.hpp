@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace eng
+{
+    // Handle to a uniform name, registered once into a process wide table of dense slots. Shaders resolve the slots of
+    // their active uniforms when they link, so setting a uniform per draw is an array index instead of a string hash.
+    // Declare them once at namespace scope, registering isn't meant for hot paths.
+    class UniformId
+    {
+    private:
+        uint32_t m_slot;
+
+    public:
+        explicit UniformId(std::string_view name);
+
+        uint32_t getSlot() const;
+        char const * getName() const;
+
+        static uint32_t getRegisteredCount();
+    };
+}
\ No newline at end of file
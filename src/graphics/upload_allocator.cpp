@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <cstring>
+
+#include "logger.hpp"
+
+#include "graphics/upload_allocator.hpp"
+
+namespace eng
+{
+    UploadAllocator::UploadAllocator(GLsizeiptr frame_capacity) : m_frame_capacity(frame_capacity)
+    {
+        GLbitfield constexpr flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glCreateBuffers(1, &m_buffer);
+        glNamedBufferStorage(m_buffer, m_frame_capacity * FRAMES_IN_FLIGHT, nullptr, flags);
+        m_mapped_ptr = static_cast<char unsigned *>(glMapNamedBufferRange(m_buffer, 0, m_frame_capacity * FRAMES_IN_FLIGHT, flags));
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniform_alignment);
+    }
+
+    UploadAllocator::~UploadAllocator()
+    {
+        for (auto fence : m_frame_fences) if (fence) glDeleteSync(fence);
+        glUnmapNamedBuffer(m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    void UploadAllocator::beginFrame()
+    {
+        // Only the section about to be overwritten has to be retired, the other frames can still be in flight
+        GLsync & fence = m_frame_fences[m_frame_index];
+        if (fence)
+        {
+            if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                ++m_current_statistics.m_stalls;
+                glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX);
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        m_frame_destinations[m_frame_index].clear();
+        for (int unsigned frame = 0; frame < FRAMES_IN_FLIGHT; ++frame)
+        {
+            m_frame_in_flight[frame] = false;
+            if (!m_frame_fences[frame]) continue;
+            GLint status;
+            glGetSynciv(m_frame_fences[frame], GL_SYNC_STATUS, sizeof(status), nullptr, &status);
+            m_frame_in_flight[frame] = status != GL_SIGNALED;
+        }
+    }
+
+    void UploadAllocator::endFrame()
+    {
+        m_frame_fences[m_frame_index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_frame_index = (m_frame_index + 1) % FRAMES_IN_FLIGHT;
+        m_frame_offset = 0;
+        m_last_statistics = m_current_statistics;
+        m_current_statistics = {};
+    }
+
+    bool UploadAllocator::allocate(GLsizeiptr size, GLsizeiptr alignment, Allocation & out_allocation)
+    {
+        GLsizeiptr aligned_offset = (m_frame_offset + alignment - 1) / alignment * alignment;
+        if (aligned_offset + size > m_frame_capacity)
+        {
+            ++m_current_statistics.m_overflows;
+            return false;
+        }
+        m_frame_offset = aligned_offset + size;
+        GLintptr buffer_offset = m_frame_index * m_frame_capacity + aligned_offset;
+        out_allocation = { m_mapped_ptr + buffer_offset, m_buffer, buffer_offset, size };
+        m_current_statistics.m_bytes_uploaded += size;
+        ++m_current_statistics.m_uploads;
+        return true;
+    }
+
+    void UploadAllocator::upload(GLuint destination, GLintptr destination_offset, void const * data, GLsizeiptr size)
+    {
+        Allocation allocation;
+        if (!allocate(size, 4, allocation))
+        {
+            ENG_LOG_F("Upload of %lld bytes exceeded frame capacity, falling back to synchronous upload", static_cast<long long>(size));
+            glNamedBufferSubData(destination, destination_offset, size, data);
+            return;
+        }
+        std::memcpy(allocation.m_data, data, size);
+        glCopyNamedBufferSubData(allocation.m_buffer, destination, allocation.m_offset, destination_offset, size);
+
+        // A glNamedBufferSubData into a range an unfinished frame still reads would have waited for that frame
+        bool in_use = false;
+        for (int unsigned frame = 0; frame < FRAMES_IN_FLIGHT && !in_use; ++frame)
+        {
+            if (!m_frame_in_flight[frame]) continue;
+            for (auto const & range : m_frame_destinations[frame])
+            {
+                if (range.m_buffer != destination || range.m_offset >= destination_offset + size || destination_offset >= range.m_offset + range.m_size) continue;
+                in_use = true;
+                break;
+            }
+        }
+        if (in_use) ++m_current_statistics.m_stalls_avoided;
+        m_frame_destinations[m_frame_index].push_back({ destination, destination_offset, size });
+    }
+
+    GLsizeiptr UploadAllocator::getFrameCapacityLeft() const
+    {
+        return m_frame_capacity - m_frame_offset;
+    }
+
+    GLint UploadAllocator::getUniformAlignment() const
+    {
+        return m_uniform_alignment;
+    }
+
+    UploadAllocator::FrameStatistics const & UploadAllocator::getLastFrameStatistics() const
+    {
+        return m_last_statistics;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace eng
+{
+    // Ring of persistently mapped staging memory, one section per frame in flight. Data is written on the CPU and copied
+    // into its destination by the GPU, so uploads never wait for the driver to finish with the destination buffer.
+    class UploadAllocator
+    {
+    public:
+        int unsigned constexpr static FRAMES_IN_FLIGHT = 3;
+        GLsizeiptr constexpr static DEFAULT_FRAME_CAPACITY = 256 * 1024;
+
+        struct Allocation
+        {
+            void * m_data;
+            GLuint m_buffer;
+            GLintptr m_offset;
+            GLsizeiptr m_size;
+        };
+
+        struct FrameStatistics
+        {
+            size_t m_bytes_uploaded{}, m_uploads{};
+            // Avoided stalls are uploads to a destination range that a frame still in flight uploaded to as well
+            size_t m_stalls{}, m_stalls_avoided{}, m_overflows{};
+        };
+
+    private:
+        struct DestinationRange
+        {
+            GLuint m_buffer;
+            GLintptr m_offset;
+            GLsizeiptr m_size;
+        };
+
+        GLuint m_buffer;
+        char unsigned * m_mapped_ptr;
+        GLsizeiptr m_frame_capacity;
+        GLint m_uniform_alignment{};
+        std::array<GLsync, FRAMES_IN_FLIGHT> m_frame_fences{};
+        std::array<std::vector<DestinationRange>, FRAMES_IN_FLIGHT> m_frame_destinations;
+        std::array<bool, FRAMES_IN_FLIGHT> m_frame_in_flight{};
+        int unsigned m_frame_index{};
+        GLsizeiptr m_frame_offset{};
+
+        FrameStatistics m_current_statistics, m_last_statistics;
+
+    public:
+        explicit UploadAllocator(GLsizeiptr frame_capacity = DEFAULT_FRAME_CAPACITY);
+        ~UploadAllocator();
+
+        void beginFrame();
+        void endFrame();
+
+        bool allocate(GLsizeiptr size, GLsizeiptr alignment, Allocation & out_allocation);
+        void upload(GLuint destination, GLintptr destination_offset, void const * data, GLsizeiptr size);
+
+        GLsizeiptr getFrameCapacityLeft() const;
+        GLint getUniformAlignment() const;
+        FrameStatistics const & getLastFrameStatistics() const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "event/application_event.hpp"
+#include "event/key_event.hpp"
+#include "event/mouse_event.hpp"
+#include "logger.hpp"
+
+#include "input_recording.hpp"
+
+namespace eng
+{
+    InputRecorder::InputRecorder(char const * file_path) : m_stream(file_path, std::ios::out | std::ios::binary)
+    {
+        if (!m_stream)
+        {
+            ENG_LOG_F("Failed to open %s for recording!", file_path);
+            return;
+        }
+        write(InputRecord::MAGIC);
+        write(InputRecord::VERSION);
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        if (isOpen()) ENG_LOG_F("Recorded %zu ticks and %zu events", m_tick_count, m_event_count);
+    }
+
+    template<typename T>
+    void InputRecorder::write(T const & value)
+    {
+        m_stream.write(reinterpret_cast<char const *>(&value), sizeof(T));
+    }
+
+    bool InputRecorder::isOpen() const
+    {
+        return m_stream.is_open();
+    }
+
+    void InputRecorder::recordTick(float delta_time)
+    {
+        write(InputRecord::Type::TICK);
+        write(delta_time);
+        ++m_tick_count;
+    }
+
+    void InputRecorder::recordEvent(Event const & event)
+    {
+        switch (event.m_event_type)
+        {
+            case EventType::KEY_PRESSED:
+            case EventType::KEY_RELEASED:
+            {
+                write(event.m_event_type == EventType::KEY_PRESSED ? InputRecord::Type::KEY_PRESSED : InputRecord::Type::KEY_RELEASED);
+                write(static_cast<int32_t>(static_cast<KeyEvent const &>(event).m_key_code));
+                break;
+            }
+            case EventType::MOUSE_PRESSED:
+            case EventType::MOUSE_RELEASED:
+            {
+                write(event.m_event_type == EventType::MOUSE_PRESSED ? InputRecord::Type::MOUSE_PRESSED : InputRecord::Type::MOUSE_RELEASED);
+                write(static_cast<int32_t>(static_cast<MouseButtonEvent const &>(event).m_button_code));
+                break;
+            }
+            case EventType::MOUSE_SCROLLED:
+            {
+                auto const & scrolled_event = static_cast<MouseScrolledEvent const &>(event);
+                write(InputRecord::Type::MOUSE_SCROLLED);
+                write(scrolled_event.m_x_offset);
+                write(scrolled_event.m_y_offset);
+                break;
+            }
+            case EventType::MOUSE_MOVED:
+            {
+                auto const & moved_event = static_cast<MouseMovedEvent const &>(event);
+                write(InputRecord::Type::MOUSE_MOVED);
+                write(moved_event.m_x_pos);
+                write(moved_event.m_y_pos);
+                break;
+            }
+            case EventType::WINDOW_RESIZED:
+            {
+                auto const & resized_event = static_cast<WindowResizedEvent const &>(event);
+                write(InputRecord::Type::WINDOW_RESIZED);
+                write(static_cast<int32_t>(resized_event.m_width));
+                write(static_cast<int32_t>(resized_event.m_height));
+                break;
+            }
+        }
+        ++m_event_count;
+    }
+
+    InputReplayer::InputReplayer(char const * file_path) : m_stream(file_path, std::ios::in | std::ios::binary)
+    {
+        uint32_t magic{}, version{};
+        if (!read(magic) || !read(version) || magic != InputRecord::MAGIC || version != InputRecord::VERSION)
+        {
+            ENG_LOG_F("%s is not a valid input recording!", file_path);
+            m_stream.close();
+        }
+    }
+
+    template<typename T>
+    bool InputReplayer::read(T & value)
+    {
+        return static_cast<bool>(m_stream.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    bool InputReplayer::isOpen() const
+    {
+        return m_stream.is_open();
+    }
+
+    bool InputReplayer::replayTick(Window & window, float & out_delta_time)
+    {
+        InputRecord::Type type;
+        if (!isOpen() || !read(type) || type != InputRecord::Type::TICK || !read(out_delta_time)) return false;
+        ++m_tick_count;
+
+        // Events up to the next tick marker belong to this tick
+        while (m_stream.peek() != std::ifstream::traits_type::eof() && static_cast<InputRecord::Type>(m_stream.peek()) != InputRecord::Type::TICK)
+        {
+            read(type);
+            switch (type)
+            {
+                case InputRecord::Type::KEY_PRESSED:
+                case InputRecord::Type::KEY_RELEASED:
+                {
+                    int32_t key{};
+                    read(key);
+                    window.dispatchKey(key, type == InputRecord::Type::KEY_PRESSED);
+                    break;
+                }
+                case InputRecord::Type::MOUSE_PRESSED:
+                case InputRecord::Type::MOUSE_RELEASED:
+                {
+                    int32_t button{};
+                    read(button);
+                    window.dispatchMouseButton(button, type == InputRecord::Type::MOUSE_PRESSED);
+                    break;
+                }
+                case InputRecord::Type::MOUSE_SCROLLED:
+                {
+                    double x_offset{}, y_offset{};
+                    read(x_offset);
+                    read(y_offset);
+                    window.dispatchScroll(x_offset, y_offset);
+                    break;
+                }
+                case InputRecord::Type::MOUSE_MOVED:
+                {
+                    double x_pos{}, y_pos{};
+                    read(x_pos);
+                    read(y_pos);
+                    window.dispatchCursorPosition(x_pos, y_pos);
+                    break;
+                }
+                case InputRecord::Type::WINDOW_RESIZED:
+                {
+                    int32_t width{}, height{};
+                    read(width);
+                    read(height);
+                    window.dispatchResize(width, height);
+                    break;
+                }
+                default:
+                {
+                    ENG_LOG_F("Unknown input record type %d, stopping replay", static_cast<int>(type));
+                    m_stream.close();
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    size_t InputReplayer::getTickCount() const
+    {
+        return m_tick_count;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+
+#include "event/event.hpp"
+#include "window.hpp"
+
+namespace eng
+{
+    // Binary stream of the delta time of every update tick, each followed by the window events that arrived during it.
+    // Replaying it drives the application through exactly the same updates, independent of the frame rate it was
+    // recorded at.
+    namespace InputRecord
+    {
+        uint32_t constexpr MAGIC = 0x4E525045; // "EPRN"
+        uint32_t constexpr VERSION = 1;
+
+        enum class Type : uint8_t
+        {
+            TICK,
+            KEY_PRESSED, KEY_RELEASED,
+            MOUSE_PRESSED, MOUSE_RELEASED,
+            MOUSE_SCROLLED,
+            MOUSE_MOVED,
+            WINDOW_RESIZED
+        };
+    }
+
+    class InputRecorder
+    {
+    private:
+        std::ofstream m_stream;
+        size_t m_tick_count{}, m_event_count{};
+
+    private:
+        template<typename T>
+        void write(T const & value);
+
+    public:
+        explicit InputRecorder(char const * file_path);
+        ~InputRecorder();
+
+        bool isOpen() const;
+
+        void recordTick(float delta_time);
+        void recordEvent(Event const & event);
+    };
+
+    class InputReplayer
+    {
+    private:
+        std::ifstream m_stream;
+        size_t m_tick_count{};
+
+    private:
+        template<typename T>
+        bool read(T & value);
+
+    public:
+        explicit InputReplayer(char const * file_path);
+
+        bool isOpen() const;
+
+        // Dispatches the events of the next tick through the window, false once the recording is exhausted
+        bool replayTick(Window & window, float & out_delta_time);
+
+        size_t getTickCount() const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <string>
+
+#include "profiler.hpp"
+
+#include "job_system.hpp"
+
+namespace eng
+{
+    namespace
+    {
+        thread_local JobSystem * t_job_system = nullptr;
+        thread_local uint32_t t_worker_index = 0;
+    }
+
+    JobSystem::JobSystem(uint32_t worker_count)
+    {
+        if (worker_count == 0) worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        m_active_worker_count = worker_count;
+        m_workers.reserve(worker_count);
+        for (uint32_t i = 0; i < worker_count; ++i) m_workers.emplace_back(std::make_unique<Worker>());
+        for (uint32_t i = 0; i < worker_count; ++i) m_workers[i]->m_thread = std::thread(&JobSystem::workerLoop, this, i);
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::scoped_lock lock(m_wake_mutex);
+            m_stopping = true;
+        }
+        m_wake_condition.notify_all();
+        for (auto & worker : m_workers) worker->m_thread.join();
+    }
+
+    void JobSystem::workerLoop(uint32_t worker_index)
+    {
+        t_job_system = this;
+        t_worker_index = worker_index;
+        ENG_PROFILE_THREAD(("Worker " + std::to_string(worker_index)).c_str());
+
+        Job job;
+        while (true)
+        {
+            if (worker_index < m_active_worker_count.load(std::memory_order_relaxed) && (tryPopJob(worker_index, job) || tryStealJob(worker_index, job)))
+            {
+                job();
+                continue;
+            }
+            std::unique_lock lock(m_wake_mutex);
+            m_wake_condition.wait(lock, [&]
+            {
+                return m_stopping || (worker_index < m_active_worker_count.load(std::memory_order_relaxed) && m_queued_job_count.load(std::memory_order_acquire) > 0);
+            });
+            if (m_stopping) return;
+        }
+    }
+
+    bool JobSystem::tryPopJob(uint32_t worker_index, Job & out_job)
+    {
+        Worker & worker = *m_workers[worker_index];
+        std::scoped_lock lock(worker.m_mutex);
+        if (worker.m_jobs.empty()) return false;
+        out_job = std::move(worker.m_jobs.back());
+        worker.m_jobs.pop_back();
+        m_queued_job_count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool JobSystem::tryStealJob(uint32_t thief_index, Job & out_job)
+    {
+        uint32_t const worker_count = static_cast<uint32_t>(m_workers.size());
+        for (uint32_t i = 1; i <= worker_count; ++i)
+        {
+            Worker & victim = *m_workers[(thief_index + i) % worker_count];
+            std::scoped_lock lock(victim.m_mutex);
+            if (victim.m_jobs.empty()) continue;
+            out_job = std::move(victim.m_jobs.front());
+            victim.m_jobs.pop_front();
+            m_queued_job_count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void JobSystem::submit(Job job)
+    {
+        uint32_t const active_worker_count = m_active_worker_count.load(std::memory_order_relaxed);
+        // Jobs spawned by jobs stay on their worker for locality, everything else is spread round robin
+        uint32_t target = t_job_system == this && t_worker_index < active_worker_count ? t_worker_index : m_next_worker.fetch_add(1, std::memory_order_relaxed) % active_worker_count;
+        {
+            Worker & worker = *m_workers[target];
+            std::scoped_lock lock(worker.m_mutex);
+            worker.m_jobs.push_back(std::move(job));
+        }
+        m_queued_job_count.fetch_add(1, std::memory_order_release);
+        {
+            std::scoped_lock lock(m_wake_mutex);
+        }
+        // A sleeping inactive worker could swallow a single notification
+        if (active_worker_count == m_workers.size()) m_wake_condition.notify_one();
+        else m_wake_condition.notify_all();
+    }
+
+    void JobSystem::parallelFor(size_t count, std::function<void(size_t)> const & function)
+    {
+        std::atomic<size_t> remaining{ count };
+        for (size_t i = 0; i < count; ++i)
+        {
+            submit([&function, &remaining, i]
+            {
+                function(i);
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+
+        bool const on_worker = t_job_system == this;
+        uint32_t const caller_index = on_worker ? t_worker_index : static_cast<uint32_t>(m_workers.size());
+        Job job;
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            if ((on_worker && tryPopJob(caller_index, job)) || tryStealJob(caller_index, job)) job();
+            else std::this_thread::yield();
+        }
+    }
+
+    void JobSystem::setActiveWorkerCount(uint32_t count)
+    {
+        m_active_worker_count = std::clamp(count, 1u, static_cast<uint32_t>(m_workers.size()));
+        {
+            std::scoped_lock lock(m_wake_mutex);
+        }
+        m_wake_condition.notify_all();
+    }
+
+    uint32_t JobSystem::getActiveWorkerCount() const
+    {
+        return m_active_worker_count.load(std::memory_order_relaxed);
+    }
+
+    uint32_t JobSystem::getWorkerCount() const
+    {
+        return static_cast<uint32_t>(m_workers.size());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eng
+{
+    // Work-stealing thread pool shared by physics, cooking and any other CPU work, so they don't oversubscribe the
+    // cores with their own threads. Each worker pops from the back of its own queue and steals from the front of the
+    // others when it runs dry.
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+
+    private:
+        struct Worker
+        {
+            std::mutex m_mutex;
+            std::deque<Job> m_jobs;
+            std::thread m_thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::atomic<uint32_t> m_active_worker_count;
+        std::atomic<uint32_t> m_next_worker{};
+        std::atomic<size_t> m_queued_job_count{};
+
+        std::mutex m_wake_mutex;
+        std::condition_variable m_wake_condition;
+        bool m_stopping{};
+
+    private:
+        void workerLoop(uint32_t worker_index);
+        bool tryPopJob(uint32_t worker_index, Job & out_job);
+        bool tryStealJob(uint32_t thief_index, Job & out_job);
+
+    public:
+        // 0 workers picks one less than the hardware thread count, the main thread is expected to help out in parallelFor
+        explicit JobSystem(uint32_t worker_count = 0);
+        ~JobSystem();
+
+        JobSystem(JobSystem const &) = delete;
+        JobSystem & operator=(JobSystem const &) = delete;
+
+        void submit(Job job);
+
+        // Runs function(0..count-1) across the pool, the calling thread executes jobs until all of them are done
+        void parallelFor(size_t count, std::function<void(size_t)> const & function);
+
+        // Workers past the active count sleep, their queued jobs are stolen by the active ones
+        void setActiveWorkerCount(uint32_t count);
+        uint32_t getActiveWorkerCount() const;
+        uint32_t getWorkerCount() const;
+    };
+}
\ No newline at end of file
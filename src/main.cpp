@@ -1,8 +1,24 @@
+#include <cstdlib>
+#include <cstring>
+
 #include "application.hpp"
 
-int main()
+// --record <file> writes the input of the session to file, --replay <file> plays it back and exits when it's done,
+// --workers <count> sizes the job system (defaults to one less than the hardware thread count)
+int main(int argc, char ** argv)
 {
-    eng::Application application(1280, 720, "Engineering Game", false);
+    char const * record_path = nullptr, * replay_path = nullptr;
+    uint32_t worker_count = 0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!std::strcmp(argv[i], "--record")) record_path = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--replay")) replay_path = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--workers")) worker_count = static_cast<uint32_t>(std::atoi(argv[i + 1]));
+    }
+
+    eng::Application application(1280, 720, "Engineering Game", false, worker_count);
+    if (record_path) application.recordInput(record_path);
+    if (replay_path) application.replayInput(replay_path);
     application.run();
     return 0;
 }
\ No newline at end of file
@@ -4,6 +4,21 @@
 
 namespace eng
 {
+	PlayerInput PlayerInput::fromWindow(Window const & window, FirstPersonCamera const & camera)
+	{
+		PlayerInput input;
+		input.m_yaw = camera.getYaw();
+		input.m_forward = window.isKeyDown(GLFW_KEY_W);
+		input.m_backward = window.isKeyDown(GLFW_KEY_S);
+		input.m_left = window.isKeyDown(GLFW_KEY_A);
+		input.m_right = window.isKeyDown(GLFW_KEY_D);
+		input.m_up = window.isKeyDown(GLFW_KEY_SPACE);
+		input.m_down = window.isKeyDown(GLFW_KEY_C);
+		input.m_run = window.isKeyDown(GLFW_KEY_LEFT_SHIFT);
+		input.m_reset = window.isKeyDown(GLFW_KEY_Q);
+		return input;
+	}
+
 	void Player::initCharacterController(physx::PxControllerManager * controller_manager, GameSystem & game_system, physx::PxExtendedVec3 const & initial_position)
 	{
 		physx::PxCapsuleControllerDesc capsule_desc;
@@ -14,7 +29,7 @@ namespace eng
 		m_character_controller = controller_manager->createController(capsule_desc);
 	}
 
-	void Player::update(float delta_time, Window const & window, FirstPersonCamera const & camera, bool flight)
+	void Player::update(float delta_time, PlayerInput const & input, bool flight)
 	{
 		if (flight)
 		{
@@ -23,7 +38,7 @@ namespace eng
 		else
 		{
 			// Jump
-			if (m_on_ground && glfwGetKey(window.getWindowHandle(), GLFW_KEY_SPACE))
+			if (m_on_ground && input.m_up)
 			{
 				m_on_ground = false;
 				m_velocity.y += 4.0f;
@@ -33,22 +48,22 @@ namespace eng
 
 		// Movement
 		m_velocity.x = m_velocity.z = 0.0f;
-		float speed = WALKING_SPEED * (glfwGetKey(window.getWindowHandle(), GLFW_KEY_LEFT_SHIFT) ? RUN_MULTIPLIER : 1.0f);
-		float cos_yaw = std::cosf(camera.getYaw()), sin_yaw = std::sinf(camera.getYaw());
+		float speed = WALKING_SPEED * (input.m_run ? RUN_MULTIPLIER : 1.0f);
+		float cos_yaw = std::cosf(input.m_yaw), sin_yaw = std::sinf(input.m_yaw);
 		glm::vec2 player_direction{};
 
-        if (glfwGetKey(window.getWindowHandle(), GLFW_KEY_W)) player_direction += glm::vec2{ cos_yaw, sin_yaw };
-        if (glfwGetKey(window.getWindowHandle(), GLFW_KEY_A)) player_direction += glm::mat2(0.0f, -1.0f, 1.0f, 0.0f) * glm::vec2{ cos_yaw, sin_yaw };
-        if (glfwGetKey(window.getWindowHandle(), GLFW_KEY_S)) player_direction += -glm::vec2{ cos_yaw, sin_yaw };
-        if (glfwGetKey(window.getWindowHandle(), GLFW_KEY_D)) player_direction += glm::mat2(0.0f, 1.0f, -1.0f, 0.0f) * glm::vec2{ cos_yaw, sin_yaw };
-		if (flight && glfwGetKey(window.getWindowHandle(), GLFW_KEY_SPACE)) m_velocity.y += speed;
-		else if (glfwGetKey(window.getWindowHandle(), GLFW_KEY_C)) m_velocity.y -= speed;
+        if (input.m_forward) player_direction += glm::vec2{ cos_yaw, sin_yaw };
+        if (input.m_left) player_direction += glm::mat2(0.0f, -1.0f, 1.0f, 0.0f) * glm::vec2{ cos_yaw, sin_yaw };
+        if (input.m_backward) player_direction += -glm::vec2{ cos_yaw, sin_yaw };
+        if (input.m_right) player_direction += glm::mat2(0.0f, 1.0f, -1.0f, 0.0f) * glm::vec2{ cos_yaw, sin_yaw };
+		if (flight && input.m_up) m_velocity.y += speed;
+		else if (input.m_down) m_velocity.y -= speed;
 		if (glm::length(player_direction) > 0.0f)
 		{
 			player_direction = glm::normalize(player_direction) * speed;
 			m_velocity += physx::PxVec3{ player_direction.x, 0.0f, player_direction.y };
 		}
-		if (glfwGetKey(window.getWindowHandle(), GLFW_KEY_Q))
+		if (input.m_reset)
 		{
 			m_velocity = {};
 			m_character_controller->setPosition({ 0.0f, 15.0f, 0.0f });
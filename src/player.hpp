@@ -10,6 +10,15 @@
 
 namespace eng
 {
+	// Everything the player simulation reads from input, so it can run away from the thread that owns the window
+	struct PlayerInput
+	{
+		float m_yaw{};
+		bool m_forward{}, m_backward{}, m_left{}, m_right{}, m_up{}, m_down{}, m_run{}, m_reset{};
+
+		static PlayerInput fromWindow(Window const & window, FirstPersonCamera const & camera);
+	};
+
 	class Player
 	{
 	private:
@@ -24,7 +33,7 @@ namespace eng
 	public:
 		void initCharacterController(physx::PxControllerManager * controller_manager, GameSystem & game_system, physx::PxExtendedVec3 const & initial_position);
 
-		void update(float delta_time, Window const & window, FirstPersonCamera const & camera, bool flight);
+		void update(float delta_time, PlayerInput const & input, bool flight);
 
 		glm::vec3 getPosition() const;
 	};
@@ -0,0 +1,252 @@
+#ifdef ENG_PROFILE_ENABLED
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <string_view>
+
+#include <imgui.h>
+
+#include "logger.hpp"
+
+#include "profiler.hpp"
+
+namespace eng
+{
+    Profiler & Profiler::get()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    int64_t Profiler::now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+    }
+
+    Profiler::ThreadBuffer & Profiler::getThreadBuffer()
+    {
+        thread_local ThreadBuffer * t_buffer = nullptr;
+        if (!t_buffer)
+        {
+            std::scoped_lock lock(m_registration_mutex);
+            t_buffer = m_thread_buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+            t_buffer->m_thread_id = static_cast<uint32_t>(m_thread_buffers.size() - 1);
+            t_buffer->m_name = "Thread " + std::to_string(t_buffer->m_thread_id);
+        }
+        return *t_buffer;
+    }
+
+    void Profiler::setThreadName(char const * name)
+    {
+        ThreadBuffer & buffer = getThreadBuffer();
+        std::scoped_lock lock(m_registration_mutex);
+        buffer.m_name = name;
+    }
+
+    uint32_t Profiler::beginEvent()
+    {
+        return getThreadBuffer().m_depth++;
+    }
+
+    void Profiler::endEvent(char const * name, int64_t start_ns, uint32_t depth)
+    {
+        ThreadBuffer & buffer = getThreadBuffer();
+        --buffer.m_depth;
+        size_t index = buffer.m_write_index.load(std::memory_order_relaxed);
+        buffer.m_events[index % THREAD_BUFFER_CAPACITY] = { name, start_ns, now(), depth };
+        buffer.m_write_index.store(index + 1, std::memory_order_release);
+    }
+
+    void Profiler::beginGpuEvent(GLuint & out_begin_query, uint32_t & out_depth)
+    {
+        if (!m_gpu_clock_calibrated)
+        {
+            GLint64 gpu_time;
+            glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+            m_gpu_clock_offset_ns = now() - gpu_time;
+            m_gpu_clock_calibrated = true;
+        }
+        if (m_free_queries.empty())
+        {
+            GLuint queries[2];
+            glCreateQueries(GL_TIMESTAMP, 2, queries);
+            m_free_queries.insert(m_free_queries.end(), std::begin(queries), std::end(queries));
+        }
+        out_begin_query = m_free_queries.back();
+        m_free_queries.pop_back();
+        glQueryCounter(out_begin_query, GL_TIMESTAMP);
+        out_depth = m_gpu_depth++;
+    }
+
+    void Profiler::endGpuEvent(char const * name, GLuint begin_query, uint32_t depth)
+    {
+        if (m_free_queries.empty())
+        {
+            GLuint query;
+            glCreateQueries(GL_TIMESTAMP, 1, &query);
+            m_free_queries.push_back(query);
+        }
+        GLuint end_query = m_free_queries.back();
+        m_free_queries.pop_back();
+        glQueryCounter(end_query, GL_TIMESTAMP);
+        --m_gpu_depth;
+        m_pending_gpu_queries.push_back({ name, begin_query, end_query, depth });
+    }
+
+    void Profiler::drainThreadBuffers()
+    {
+        std::scoped_lock lock(m_registration_mutex);
+        for (auto & buffer : m_thread_buffers)
+        {
+            size_t write_index = buffer->m_write_index.load(std::memory_order_acquire);
+            if (write_index - buffer->m_read_index > THREAD_BUFFER_CAPACITY) buffer->m_read_index = write_index - THREAD_BUFFER_CAPACITY; // Overrun, oldest events are lost
+            for (; buffer->m_read_index < write_index; ++buffer->m_read_index)
+            {
+                m_current_frame_events.push_back({ buffer->m_events[buffer->m_read_index % THREAD_BUFFER_CAPACITY], buffer->m_thread_id });
+            }
+        }
+    }
+
+    void Profiler::resolveGpuQueries()
+    {
+        // Queries complete in submission order, so stop at the first one that isn't available yet
+        auto resolved_end = m_pending_gpu_queries.begin();
+        for (; resolved_end != m_pending_gpu_queries.end(); ++resolved_end)
+        {
+            GLint available{};
+            glGetQueryObjectiv(resolved_end->m_end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+            GLint64 begin_ns, end_ns;
+            glGetQueryObjecti64v(resolved_end->m_begin_query, GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjecti64v(resolved_end->m_end_query, GL_QUERY_RESULT, &end_ns);
+            m_current_frame_events.push_back({ { resolved_end->m_name, begin_ns + m_gpu_clock_offset_ns, end_ns + m_gpu_clock_offset_ns, resolved_end->m_depth }, GPU_TRACK_ID });
+            m_free_queries.push_back(resolved_end->m_begin_query);
+            m_free_queries.push_back(resolved_end->m_end_query);
+        }
+        m_pending_gpu_queries.erase(m_pending_gpu_queries.begin(), resolved_end);
+    }
+
+    void Profiler::onFrameEnd()
+    {
+        drainThreadBuffers();
+        resolveGpuQueries();
+        m_last_frame_start_ns = m_frame_start_ns;
+        m_last_frame_end_ns = m_frame_start_ns = now();
+
+        if (m_capture_frames_left > 0)
+        {
+            m_capture.insert(m_capture.end(), m_current_frame_events.begin(), m_current_frame_events.end());
+            if (--m_capture_frames_left == 0)
+            {
+                writeChromeTrace();
+                m_capture.clear();
+            }
+        }
+        m_last_frame_events.swap(m_current_frame_events);
+        m_current_frame_events.clear();
+    }
+
+    void Profiler::startCapture(int frame_count, char const * output_path)
+    {
+        m_capture.clear();
+        m_capture_frames_left = frame_count;
+        m_capture_path = output_path;
+    }
+
+    bool Profiler::isCapturing() const
+    {
+        return m_capture_frames_left > 0;
+    }
+
+    void Profiler::writeChromeTrace() const
+    {
+        std::scoped_lock lock(m_registration_mutex);
+        std::ofstream stream(m_capture_path, std::ios::out);
+        if (!stream)
+        {
+            ENG_LOG_F("Failed to open %s for writing!", m_capture_path.c_str());
+            return;
+        }
+        stream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_TRACK_ID << ",\"args\":{\"name\":\"GPU\"}}";
+        for (auto const & buffer : m_thread_buffers)
+        {
+            stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->m_thread_id << ",\"args\":{\"name\":\"" << buffer->m_name << "\"}}";
+        }
+        for (auto const & [event, thread_id] : m_capture)
+        {
+            stream << ",\n{\"name\":\"" << event.m_name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_id
+                << ",\"ts\":" << event.m_start_ns / 1000.0 << ",\"dur\":" << (event.m_end_ns - event.m_start_ns) / 1000.0 << "}";
+        }
+        stream << "\n]}\n";
+        ENG_LOG_F("Wrote %zu profiler events to %s", m_capture.size(), m_capture_path.c_str());
+    }
+
+    void Profiler::renderImGui()
+    {
+        if (!ImGui::CollapsingHeader("Profiler")) return;
+
+        if (ImGui::Button("Capture 120 Frames")) startCapture(120, "profile_capture.json");
+        if (isCapturing())
+        {
+            ImGui::SameLine();
+            ImGui::Text("Capturing, %d frames left", m_capture_frames_left);
+        }
+        ImGui::Text("Frame: %.3f ms", (m_last_frame_end_ns - m_last_frame_start_ns) / 1'000'000.0);
+
+        // One flame graph row group per track. CPU tracks span the last frame, the GPU track spans the queries that
+        // resolved during it, which lag a few frames behind.
+        std::vector<uint32_t> tracks;
+        for (auto const & tracked_event : m_last_frame_events)
+        {
+            if (std::find(tracks.begin(), tracks.end(), tracked_event.m_thread_id) == tracks.end()) tracks.push_back(tracked_event.m_thread_id);
+        }
+        std::sort(tracks.begin(), tracks.end());
+
+        std::scoped_lock lock(m_registration_mutex);
+        ImDrawList * draw_list = ImGui::GetWindowDrawList();
+        float const width = ImGui::GetContentRegionAvail().x, row_height = ImGui::GetTextLineHeight() + 2.0f;
+        for (uint32_t track : tracks)
+        {
+            int64_t range_start = m_last_frame_start_ns, range_end = m_last_frame_end_ns;
+            uint32_t max_depth = 0;
+            if (track == GPU_TRACK_ID)
+            {
+                range_start = INT64_MAX;
+                range_end = INT64_MIN;
+            }
+            for (auto const & [event, thread_id] : m_last_frame_events)
+            {
+                if (thread_id != track) continue;
+                max_depth = std::max(max_depth, event.m_depth);
+                if (track == GPU_TRACK_ID)
+                {
+                    range_start = std::min(range_start, event.m_start_ns);
+                    range_end = std::max(range_end, event.m_end_ns);
+                }
+            }
+            double const range = static_cast<double>(std::max<int64_t>(range_end - range_start, 1));
+
+            if (track == GPU_TRACK_ID) ImGui::Text("GPU (%.3f ms)", range / 1'000'000.0);
+            else ImGui::Text("%s", m_thread_buffers[track]->m_name.c_str());
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            for (auto const & [event, thread_id] : m_last_frame_events)
+            {
+                if (thread_id != track) continue;
+                float x_min = origin.x + static_cast<float>(std::clamp((event.m_start_ns - range_start) / range, 0.0, 1.0)) * width;
+                float x_max = origin.x + static_cast<float>(std::clamp((event.m_end_ns - range_start) / range, 0.0, 1.0)) * width;
+                ImVec2 min{ x_min, origin.y + event.m_depth * row_height }, max{ std::max(x_max, x_min + 1.0f), min.y + row_height - 1.0f };
+
+                size_t hash = std::hash<std::string_view>{}(event.m_name);
+                draw_list->AddRectFilled(min, max, IM_COL32(90 + hash % 120, 90 + (hash >> 8) % 120, 90 + (hash >> 16) % 120, 255));
+                if (ImGui::CalcTextSize(event.m_name).x < max.x - min.x) draw_list->AddText({ min.x + 2.0f, min.y }, IM_COL32_WHITE, event.m_name);
+                if (ImGui::IsMouseHoveringRect(min, max)) ImGui::SetTooltip("%s: %.3f ms", event.m_name, (event.m_end_ns - event.m_start_ns) / 1'000'000.0);
+            }
+            ImGui::Dummy({ width, (max_depth + 1) * row_height });
+        }
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#ifdef ENG_PROFILE_ENABLED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace eng
+{
+    struct ProfileEvent
+    {
+        char const * m_name; // Must be a string with static lifetime, only the pointer is stored
+        int64_t m_start_ns, m_end_ns;
+        uint32_t m_depth;
+    };
+
+    class Profiler
+    {
+    private:
+        size_t constexpr static THREAD_BUFFER_CAPACITY = 1 << 14;
+        uint32_t constexpr static GPU_TRACK_ID = 0xFFFF;
+
+        // Single producer (the owning thread), single consumer (the thread calling onFrameEnd)
+        struct ThreadBuffer
+        {
+            std::unique_ptr<ProfileEvent[]> m_events{ std::make_unique<ProfileEvent[]>(THREAD_BUFFER_CAPACITY) };
+            std::atomic<size_t> m_write_index{};
+            size_t m_read_index{};
+            uint32_t m_depth{}, m_thread_id{};
+            std::string m_name;
+        };
+
+        struct TrackedEvent
+        {
+            ProfileEvent m_event;
+            uint32_t m_thread_id;
+        };
+
+        struct PendingGpuQuery
+        {
+            char const * m_name;
+            GLuint m_begin_query, m_end_query;
+            uint32_t m_depth;
+        };
+
+    private:
+        std::chrono::steady_clock::time_point const m_epoch{ std::chrono::steady_clock::now() };
+        std::mutex mutable m_registration_mutex; // Producers only take it once, when registering their thread
+        std::vector<std::unique_ptr<ThreadBuffer>> m_thread_buffers;
+
+        std::vector<GLuint> m_free_queries;
+        std::vector<PendingGpuQuery> m_pending_gpu_queries;
+        int64_t m_gpu_clock_offset_ns{};
+        bool m_gpu_clock_calibrated{};
+        uint32_t m_gpu_depth{};
+
+        int64_t m_frame_start_ns{}, m_last_frame_start_ns{}, m_last_frame_end_ns{};
+        std::vector<TrackedEvent> m_last_frame_events, m_current_frame_events;
+
+        std::vector<TrackedEvent> m_capture;
+        int m_capture_frames_left{};
+        std::string m_capture_path;
+
+    private:
+        Profiler() = default;
+        ThreadBuffer & getThreadBuffer();
+        void drainThreadBuffers();
+        void resolveGpuQueries();
+        void writeChromeTrace() const;
+
+    public:
+        static Profiler & get();
+
+        int64_t now() const;
+        void setThreadName(char const * name);
+
+        uint32_t beginEvent();
+        void endEvent(char const * name, int64_t start_ns, uint32_t depth);
+
+        void beginGpuEvent(GLuint & out_begin_query, uint32_t & out_depth);
+        void endGpuEvent(char const * name, GLuint begin_query, uint32_t depth);
+
+        void onFrameEnd();
+        void startCapture(int frame_count, char const * output_path);
+        bool isCapturing() const;
+
+        void renderImGui();
+    };
+
+    class ProfileScope
+    {
+    private:
+        char const * m_name;
+        uint32_t m_depth;
+        int64_t m_start_ns;
+
+    public:
+        explicit ProfileScope(char const * name) : m_name(name), m_depth(Profiler::get().beginEvent()), m_start_ns(Profiler::get().now()) {}
+        ~ProfileScope() { Profiler::get().endEvent(m_name, m_start_ns, m_depth); }
+        ProfileScope(ProfileScope const &) = delete;
+        ProfileScope & operator=(ProfileScope const &) = delete;
+    };
+
+    // Brackets GL commands with timestamp queries, has to be used on the thread owning the context
+    class GpuProfileScope
+    {
+    private:
+        char const * m_name;
+        GLuint m_begin_query;
+        uint32_t m_depth;
+
+    public:
+        explicit GpuProfileScope(char const * name) : m_name(name) { Profiler::get().beginGpuEvent(m_begin_query, m_depth); }
+        ~GpuProfileScope() { Profiler::get().endGpuEvent(m_name, m_begin_query, m_depth); }
+        GpuProfileScope(GpuProfileScope const &) = delete;
+        GpuProfileScope & operator=(GpuProfileScope const &) = delete;
+    };
+}
+
+    #define ENG_PROFILE_CONCAT_IMPL(a, b) a##b
+    #define ENG_PROFILE_CONCAT(a, b) ENG_PROFILE_CONCAT_IMPL(a, b)
+    #define ENG_PROFILE_SCOPE(name) ::eng::ProfileScope ENG_PROFILE_CONCAT(eng_profile_scope_, __LINE__)(name)
+    #define ENG_PROFILE_GPU_SCOPE(name) ::eng::GpuProfileScope ENG_PROFILE_CONCAT(eng_gpu_profile_scope_, __LINE__)(name)
+    #define ENG_PROFILE_THREAD(name) ::eng::Profiler::get().setThreadName(name)
+    #define ENG_PROFILE_FRAME() ::eng::Profiler::get().onFrameEnd()
+#else
+    #define ENG_PROFILE_SCOPE(name)
+    #define ENG_PROFILE_GPU_SCOPE(name)
+    #define ENG_PROFILE_THREAD(name)
+    #define ENG_PROFILE_FRAME()
+#endif
\ No newline at end of file
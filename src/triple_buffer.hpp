@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace eng
+{
+    // Lock-free single producer, single consumer hand-off of the latest value. The producer and the consumer each own
+    // one slot and swap it with the shared middle slot, so neither ever waits on the other and the consumer always sees
+    // a complete value.
+    template<typename T>
+    class TripleBuffer
+    {
+    private:
+        uint8_t constexpr static INDEX_MASK = 0b011, DIRTY_BIT = 0b100;
+
+        T m_slots[3]{};
+        std::atomic<uint8_t> m_middle{ 1 };
+        uint8_t m_back{ 0 }, m_front{ 2 };
+
+    public:
+        // Producer
+        T & getWriteBuffer()
+        {
+            return m_slots[m_back];
+        }
+
+        void publish()
+        {
+            m_back = m_middle.exchange(m_back | DIRTY_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        // Consumer, returns whether a new value was published since the last call
+        bool update()
+        {
+            if (!(m_middle.load(std::memory_order_relaxed) & DIRTY_BIT)) return false;
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+        T const & getReadBuffer() const
+        {
+            return m_slots[m_front];
+        }
+    };
+}
\ No newline at end of file
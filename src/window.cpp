@@ -50,59 +50,32 @@ namespace eng
         // Event Callbacks
         glfwSetKeyCallback(m_window_handle, [](GLFWwindow * window_handle, int key, int, int action, int)
         {
-            auto const & user_pointer = *static_cast<UserPointer*>(glfwGetWindowUserPointer(window_handle));
-            switch (action)
-            {
-                case GLFW_PRESS:
-                {
-                    user_pointer.m_event_callback(KeyPressedEvent(key, user_pointer.m_window));
-                    break;
-                }
-                case GLFW_RELEASE:
-                {
-                    user_pointer.m_event_callback(KeyReleasedEvent(key, user_pointer.m_window));
-                    break;
-                }
-            }
+            auto & window = static_cast<UserPointer *>(glfwGetWindowUserPointer(window_handle))->m_window;
+            if (!window.m_external_input && action != GLFW_REPEAT) window.dispatchKey(key, action == GLFW_PRESS);
         });
 
         glfwSetMouseButtonCallback(m_window_handle, [](GLFWwindow * window_handle, int button, int action, int)
         {
-            auto const & user_pointer = *static_cast<UserPointer*>(glfwGetWindowUserPointer(window_handle));
-            switch (action)
-            {
-                case GLFW_PRESS:
-                {
-                    user_pointer.m_event_callback(MousePressedEvent(button, user_pointer.m_window));
-                    break;
-                }
-                case GLFW_RELEASE:
-                {
-                    user_pointer.m_event_callback(MouseReleasedEvent(button, user_pointer.m_window));
-                    break;
-                }
-            }
+            auto & window = static_cast<UserPointer *>(glfwGetWindowUserPointer(window_handle))->m_window;
+            if (!window.m_external_input) window.dispatchMouseButton(button, action == GLFW_PRESS);
         });
 
         glfwSetScrollCallback(m_window_handle, [](GLFWwindow * window_handle, double x_offset, double y_offset)
         {
-            auto const & user_pointer = *static_cast<UserPointer*>(glfwGetWindowUserPointer(window_handle));
-            user_pointer.m_event_callback(MouseScrolledEvent(x_offset, y_offset, user_pointer.m_window));
+            auto & window = static_cast<UserPointer *>(glfwGetWindowUserPointer(window_handle))->m_window;
+            if (!window.m_external_input) window.dispatchScroll(x_offset, y_offset);
         });
 
         glfwSetCursorPosCallback(m_window_handle, [](GLFWwindow * window_handle, double x_pos, double y_pos)
         {
-            auto const & user_pointer = *static_cast<UserPointer*>(glfwGetWindowUserPointer(window_handle));
-            user_pointer.m_event_callback(MouseMovedEvent(x_pos, y_pos, user_pointer.m_window));
-            user_pointer.m_window.m_mouse_x = x_pos;
-            user_pointer.m_window.m_mouse_y = y_pos;
+            auto & window = static_cast<UserPointer *>(glfwGetWindowUserPointer(window_handle))->m_window;
+            if (!window.m_external_input) window.dispatchCursorPosition(x_pos, y_pos);
         });
 
         glfwSetFramebufferSizeCallback(m_window_handle, [](GLFWwindow * window_handle, int width, int height)
         {
-            auto const & user_pointer = *static_cast<UserPointer*>(glfwGetWindowUserPointer(window_handle));
-            user_pointer.m_window.setSize(width, height);
-            user_pointer.m_event_callback(WindowResizedEvent(width, height, user_pointer.m_window));
+            auto & window = static_cast<UserPointer *>(glfwGetWindowUserPointer(window_handle))->m_window;
+            window.dispatchResize(width, height);
         });
 
         glfwSetWindowMaximizeCallback(m_window_handle, [](GLFWwindow * window_handle, int state)
@@ -198,4 +171,51 @@ namespace eng
     {
         return m_window_handle;
     }
+
+    bool Window::isKeyDown(int key) const
+    {
+        return key >= 0 && key < static_cast<int>(m_keys_down.size()) && m_keys_down[key];
+    }
+
+    bool Window::isMouseButtonDown(int button) const
+    {
+        return button >= 0 && button < static_cast<int>(m_mouse_buttons_down.size()) && m_mouse_buttons_down[button];
+    }
+
+    void Window::setExternalInput(bool external_input)
+    {
+        m_external_input = external_input;
+    }
+
+    void Window::dispatchKey(int key, bool pressed)
+    {
+        if (key >= 0 && key < static_cast<int>(m_keys_down.size())) m_keys_down[key] = pressed;
+        if (pressed) m_user_pointer.m_event_callback(KeyPressedEvent(key, *this));
+        else m_user_pointer.m_event_callback(KeyReleasedEvent(key, *this));
+    }
+
+    void Window::dispatchMouseButton(int button, bool pressed)
+    {
+        if (button >= 0 && button < static_cast<int>(m_mouse_buttons_down.size())) m_mouse_buttons_down[button] = pressed;
+        if (pressed) m_user_pointer.m_event_callback(MousePressedEvent(button, *this));
+        else m_user_pointer.m_event_callback(MouseReleasedEvent(button, *this));
+    }
+
+    void Window::dispatchScroll(double x_offset, double y_offset)
+    {
+        m_user_pointer.m_event_callback(MouseScrolledEvent(x_offset, y_offset, *this));
+    }
+
+    void Window::dispatchCursorPosition(double x_pos, double y_pos)
+    {
+        m_user_pointer.m_event_callback(MouseMovedEvent(x_pos, y_pos, *this));
+        m_mouse_x = x_pos;
+        m_mouse_y = y_pos;
+    }
+
+    void Window::dispatchResize(int width, int height)
+    {
+        setSize(width, height);
+        m_user_pointer.m_event_callback(WindowResizedEvent(width, height, *this));
+    }
 }
\ No newline at end of file
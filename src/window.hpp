@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -22,6 +23,9 @@ namespace eng
         bool m_cursor_visible, m_maximized, m_fullscreen;
         double m_mouse_x, m_mouse_y;
         int m_width, m_height, m_init_width, m_init_height;
+        bool m_external_input{};
+        std::array<bool, GLFW_KEY_LAST + 1> m_keys_down{};
+        std::array<bool, GLFW_MOUSE_BUTTON_LAST + 1> m_mouse_buttons_down{};
 
         struct UserPointer
         {
@@ -56,5 +60,19 @@ namespace eng
         std::pair<double, double> getCursorPosition() const;
 
         GLFWwindow * getWindowHandle() const;
+
+        // Input is tracked from the dispatched events rather than queried from GLFW, so that replayed input drives the
+        // game exactly like live input does
+        bool isKeyDown(int key) const;
+        bool isMouseButtonDown(int button) const;
+
+        // Ignores GLFW input events while enabled, input is then only received through the dispatch functions
+        void setExternalInput(bool external_input);
+
+        void dispatchKey(int key, bool pressed);
+        void dispatchMouseButton(int button, bool pressed);
+        void dispatchScroll(double x_offset, double y_offset);
+        void dispatchCursorPosition(double x_pos, double y_pos);
+        void dispatchResize(int width, int height);
     };
 }
\ No newline at end of file
@@ -4,12 +4,25 @@
 
 #include "graphics/vertex_buffer_layout.hpp"
 #include "logger.hpp"
+#include "world/density_layout.hpp"
+#include "world/terrain_material.hpp"
 #include "world/world.hpp"
 
 #include "world/chunk.hpp"
 
 namespace eng
 {
+    GLsizeiptr alignStorageOffset(GLsizeiptr size)
+    {
+        static GLsizeiptr const alignment = []
+        {
+            GLint value = 1;
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &value);
+            return static_cast<GLsizeiptr>(value);
+        }();
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
     void Chunk::generateIndices(size_t count)
     {
         s_indices.clear();
@@ -18,11 +31,12 @@ namespace eng
         s_indices.shrink_to_fit();
     }
 
-    Chunk::Chunk(GameSystem & game_system, int unsigned base_lod_point_width) : r_game_system(game_system), m_next_unused(nullptr)
+    Chunk::Chunk(GameSystem & game_system, int unsigned base_lod_point_width, uint32_t index, uint32_t slot, uint32_t generation, BufferRange const & density, BufferRange const & materials)
+        : m_density_distribution_ss(density), m_material_ss(materials), m_index(index), m_slot(slot), m_generation(generation), r_game_system(game_system)
     {
         m_mesh_vb = r_game_system.getAssetManager().createBuffer();
-        m_density_distribution_ss = r_game_system.getAssetManager().createBuffer();
-        setMeshConfig(base_lod_point_width);
+        m_material_vb = r_game_system.getAssetManager().createBuffer();
+        releaseMesh(); // Storage is reserved once it's meshed
 
         m_draw_indirect_buffer = r_game_system.getAssetManager().createBuffer();
         glNamedBufferStorage(m_draw_indirect_buffer, sizeof(World::INITIAL_INDIRECT_DRAW_CONFIG), &World::INITIAL_INDIRECT_DRAW_CONFIG, GL_DYNAMIC_STORAGE_BIT | GL_CLIENT_STORAGE_BIT);
@@ -34,22 +48,69 @@ namespace eng
     {
         m_static_rigid_body->release();
     }
+
+    void Chunk::release()
+    {
+        releasePhysics();
+        AssetManager & asset_manager = r_game_system.getAssetManager();
+        asset_manager.deleteBuffer(m_mesh_vb);
+        asset_manager.deleteBuffer(m_material_vb);
+        asset_manager.deleteBuffer(m_draw_indirect_buffer);
+    }
     
-    void Chunk::setMeshConfig(int unsigned point_width)
+    void Chunk::reserveMesh(int unsigned point_width)
     {
-        glNamedBufferData(m_mesh_vb, maxChunkTriangles(point_width) * sizeof(float) * 18, nullptr, GL_DYNAMIC_COPY);
-        glNamedBufferData(m_density_distribution_ss, point_width * point_width * point_width * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+        if (m_triangle_capacity >= maxChunkTriangles(point_width)) return;
+        m_triangle_capacity = maxChunkTriangles(point_width);
+        glNamedBufferData(m_mesh_vb, m_triangle_capacity * sizeof(float) * 18, nullptr, GL_DYNAMIC_COPY);
+        glNamedBufferData(m_material_vb, m_triangle_capacity * 3 * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
     }
 
-#define COOK_REALTIME 0
+    void Chunk::fitMesh(int unsigned vertex_count)
+    {
+        // Never empty, so the buffers can always be bound
+        int unsigned const triangle_count = std::max(vertex_count / 3, 1u);
+        int unsigned const capacity = (triangle_count + MESH_CAPACITY_GRANULARITY - 1) / MESH_CAPACITY_GRANULARITY * MESH_CAPACITY_GRANULARITY;
+        if (capacity >= m_triangle_capacity) return;
+
+        AssetManager & asset_manager = r_game_system.getAssetManager();
+        GLuint const mesh_vb = asset_manager.createBuffer(), material_vb = asset_manager.createBuffer();
+        glNamedBufferData(mesh_vb, capacity * sizeof(float) * 18, nullptr, GL_DYNAMIC_COPY);
+        glNamedBufferData(material_vb, capacity * 3 * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
+        if (vertex_count > 0)
+        {
+            glCopyNamedBufferSubData(m_mesh_vb, mesh_vb, 0, 0, vertex_count * sizeof(float) * 6);
+            glCopyNamedBufferSubData(m_material_vb, material_vb, 0, 0, vertex_count * sizeof(uint32_t));
+        }
+        asset_manager.deleteBuffer(m_mesh_vb);
+        asset_manager.deleteBuffer(m_material_vb);
+        m_mesh_vb = mesh_vb;
+        m_material_vb = material_vb;
+        m_triangle_capacity = capacity;
+    }
 
-    void Chunk::setMeshCollider(std::vector<float> const & mesh, physx::PxMaterial * material, float chunk_size)
+    void Chunk::releaseMesh()
     {
-        if (m_has_valid_collider) return;
+        m_triangle_capacity = 0;
+        glNamedBufferData(m_mesh_vb, 0, nullptr, GL_DYNAMIC_COPY);
+        glNamedBufferData(m_material_vb, 0, nullptr, GL_DYNAMIC_COPY);
+    }
 
-        removeCollider();
+    size_t Chunk::getMeshBytes() const
+    {
+        return m_triangle_capacity * MESH_BYTES_PER_TRIANGLE;
+    }
+
+#define COOK_REALTIME 0
+
+    bool Chunk::needsCollider() const
+    {
+        return !m_has_valid_collider;
+    }
 
-        if (m_vertex_count == 0) return;
+    physx::PxTriangleMesh * Chunk::cookCollider(std::vector<float> const & mesh) const
+    {
+        if (m_vertex_count == 0) return nullptr;
 #if COOK_REALTIME
         physx::PxTolerancesScale tolerances_scale;
         physx::PxCookingParams params(tolerances_scale);
@@ -66,19 +127,25 @@ namespace eng
         mesh_desc.points.data = mesh.data();
         mesh_desc.triangles.count = m_vertex_count / 3;
         mesh_desc.triangles.stride = 3 * sizeof(physx::PxU32);
-        auto sub_indices = std::vector<uint32_t>(s_indices.begin(), s_indices.begin() + m_vertex_count);
-        mesh_desc.triangles.data = sub_indices.data();
+        mesh_desc.triangles.data = s_indices.data(); // Vertices aren't shared, so the first vertex_count sequential indices are the index buffer
 
 #if COOK_REALTIME
-        physx::PxTriangleMesh * triangle_mesh = r_game_system.getPhysxCooking()->createTriangleMesh(mesh_desc, r_game_system.getPhysx()->getPhysicsInsertionCallback());
+        return r_game_system.getPhysxCooking()->createTriangleMesh(mesh_desc, r_game_system.getPhysx()->getPhysicsInsertionCallback());
 #else
         physx::PxDefaultMemoryOutputStream write_buffer;
         physx::PxTriangleMeshCookingResult::Enum result;
         bool status = r_game_system.getPhysxCooking()->cookTriangleMesh(mesh_desc, write_buffer, &result);
         if (!status) ENG_LOG_F("Failed to cook triangle mesh of chunk at (%d, %d, %d)", m_position.x, m_position.y, m_position.z);
         physx::PxDefaultMemoryInputData read_buffer(write_buffer.getData(), write_buffer.getSize());
-        physx::PxTriangleMesh * triangle_mesh = r_game_system.getPhysx()->createTriangleMesh(read_buffer);
+        return r_game_system.getPhysx()->createTriangleMesh(read_buffer);
 #endif
+    }
+
+    void Chunk::setCollider(physx::PxTriangleMesh * triangle_mesh, physx::PxMaterial * material, float chunk_size)
+    {
+        removeCollider();
+        if (!triangle_mesh) return;
+
         physx::PxMeshScale scale({ chunk_size });
         physx::PxTriangleMeshGeometry geometry(triangle_mesh, scale);
 
@@ -103,23 +170,50 @@ namespace eng
         m_vertex_count = vertex_count;
     }
 
+    void Chunk::setApronEdited()
+    {
+        m_apron_edited = true;
+    }
+
+    bool Chunk::isApronEdited() const
+    {
+        return m_apron_edited;
+    }
+
+    void Chunk::setEdited()
+    {
+        m_edited = true;
+    }
+
+    bool Chunk::isEdited() const
+    {
+        return m_edited;
+    }
+
     void Chunk::activate(glm::ivec3 position, float chunk_size)
     {
         m_position = position;
+        m_apron_edited = false;
+        m_edited = false;
+        restore(chunk_size);
+    }
+
+    void Chunk::restore(float chunk_size)
+    {
         m_active = true;
-        m_static_rigid_body->setGlobalPose(physx::PxTransform(physx::PxVec3{ static_cast<float>(position.x), static_cast<float>(position.y), static_cast<float>(position.z) } * chunk_size));
+        m_static_rigid_body->setGlobalPose(physx::PxTransform(physx::PxVec3{ static_cast<float>(m_position.x), static_cast<float>(m_position.y), static_cast<float>(m_position.z) } * chunk_size));
     }
 
-    void Chunk::deactivate(Chunk * next_unused)
+    void Chunk::deactivate()
     {
-        m_next_unused = next_unused;
         m_active = false;
+        ++m_generation;
         removeCollider();
     }
 
-    Chunk * Chunk::getNextUnused() const
+    ChunkHandle Chunk::getHandle() const
     {
-        return m_active ? nullptr : m_next_unused;
+        return { m_index, m_generation };
     }
     
     bool Chunk::isActive() const
@@ -132,7 +226,17 @@ namespace eng
         return m_mesh_vb;
     }
 
-    GLuint Chunk::getDensityDistributionBuffer() const
+    uint32_t Chunk::getSlot() const
+    {
+        return m_slot;
+    }
+
+    uint32_t Chunk::getGeneration() const
+    {
+        return m_generation;
+    }
+
+    BufferRange const & Chunk::getDensityDistributionBuffer() const
     {
         return m_density_distribution_ss;
     }
@@ -142,6 +246,16 @@ namespace eng
         return m_draw_indirect_buffer;
     }
 
+    BufferRange const & Chunk::getMaterialBuffer() const
+    {
+        return m_material_ss;
+    }
+
+    GLuint Chunk::getMaterialVB() const
+    {
+        return m_material_vb;
+    }
+
     glm::ivec3 const & Chunk::getPosition() const
     {
         return m_position;
@@ -154,78 +268,432 @@ namespace eng
     
     //ChunkPool
 
+    ChunkPool::Iterator::Iterator(std::vector<std::unique_ptr<Slab>> const & slabs, size_t slab) : m_slabs(&slabs), m_slab(slab)
+    {
+        skipReleasedSlabs();
+    }
+
+    void ChunkPool::Iterator::skipReleasedSlabs()
+    {
+        while (m_slab < m_slabs->size() && !(*m_slabs)[m_slab]) ++m_slab;
+    }
+
+    Chunk & ChunkPool::Iterator::operator*() const
+    {
+        return (*m_slabs)[m_slab]->m_chunks[m_slot];
+    }
+
+    ChunkPool::Iterator & ChunkPool::Iterator::operator++()
+    {
+        if (++m_slot == (*m_slabs)[m_slab]->m_chunks.size())
+        {
+            m_slot = 0;
+            ++m_slab;
+            skipReleasedSlabs();
+        }
+        return *this;
+    }
+
+    bool ChunkPool::Iterator::operator!=(Iterator const & other) const
+    {
+        return m_slab != other.m_slab || m_slot != other.m_slot;
+    }
+
     ChunkPool::ChunkPool(GameSystem & game_system) : r_game_system(game_system)
     {
     }
 
     ChunkPool::~ChunkPool()
     {
-        for (auto & chunk : m_chunks)
+        // The scene is gone by now, releasing the actors is all that's left
+        for (auto & slab : m_slabs)
         {
-            chunk.releasePhysics();
+            if (!slab) continue;
+            for (auto & chunk : slab->m_chunks) chunk.releasePhysics();
         }
     }
 
-    void ChunkPool::initialize(size_t initial_size, int unsigned base_lod_point_width)
+    void ChunkPool::initialize(int unsigned base_lod_point_width, physx::PxScene * scene)
     {
-        setPoolSize(initial_size);
         m_base_lod_point_width = base_lod_point_width;
+        m_scene = scene;
+        // Sized for the bricked layout, which is never smaller than the linear one, so the layout can change at runtime
+        size_t const point_count = getDensityStorageCount(DensityLayout::BRICKED, m_base_lod_point_width);
+        m_density_stride = alignStorageOffset(static_cast<GLsizeiptr>(point_count * sizeof(float)));
+        m_material_stride = alignStorageOffset(static_cast<GLsizeiptr>(TerrainMaterial::getPackedWordCount(point_count) * sizeof(uint32_t)));
         Chunk::generateIndices(3 * maxChunkTriangles(base_lod_point_width));
     }
 
-    void ChunkPool::setPoolSize(size_t size)
+    void ChunkPool::setTargetCapacity(size_t chunk_count)
+    {
+        m_target_capacity = chunk_count;
+    }
+
+    void ChunkPool::setMemoryBudget(size_t bytes)
+    {
+        m_memory_budget = bytes;
+        m_out_of_budget = false;
+        trim();
+    }
+
+    void ChunkPool::setCacheBudget(size_t bytes)
     {
-        m_chunks.clear();
-        m_chunks.reserve(size);
-        // Allocate all chunks and setup free list
-        for (size_t i = 0; i < size; ++i)
+        m_cache_budget = bytes;
+        while (!m_parked_order.empty() && m_parked_bytes > m_cache_budget)
         {
-            Chunk & chunk = m_chunks.emplace_back(r_game_system, m_base_lod_point_width);
-            if (i > 0) m_chunks[i - 1].deactivate(&chunk);
+            evictParkedChunk(m_parked_order.begin());
+            ++m_cache_evictions;
         }
-        m_first_unused = &m_chunks[0];
-        m_chunks[size - 1].deactivate(nullptr);
     }
 
-    bool ChunkPool::activateChunk(Chunk *& out_chunk, glm::ivec3 position, float chunk_size)
+    Chunk & ChunkPool::getChunk(uint32_t index) const
+    {
+        return m_slabs[index / SLAB_SIZE]->m_chunks[index % SLAB_SIZE];
+    }
+
+    bool ChunkPool::allocateSlab()
     {
-        if (m_first_unused == nullptr) return false;
-        out_chunk = m_first_unused;
-        m_first_unused = out_chunk->getNextUnused();
-        out_chunk->activate(position, chunk_size);
+        if (getMemoryUsage() + SLAB_SIZE * getChunkBytes() > m_memory_budget)
+        {
+            if (!m_out_of_budget) recordEvent(Event::OUT_OF_BUDGET, m_slabs.size());
+            m_out_of_budget = true;
+            return false;
+        }
+
+        // Reuse the first gap so indices stay low and the pool can shrink from the end
+        size_t const slab_index = std::find(m_slabs.begin(), m_slabs.end(), nullptr) - m_slabs.begin();
+        if (slab_index == m_slabs.size()) m_slabs.emplace_back();
+        if (slab_index == m_slab_generations.size()) m_slab_generations.push_back(0);
+        auto & slab = m_slabs[slab_index];
+        slab = std::make_unique<Slab>();
+
+        AssetManager & asset_manager = r_game_system.getAssetManager();
+        slab->m_density_ss = asset_manager.createBuffer();
+        glNamedBufferData(slab->m_density_ss, m_density_stride * SLAB_SIZE, nullptr, GL_DYNAMIC_COPY);
+        slab->m_material_ss = asset_manager.createBuffer();
+        glNamedBufferData(slab->m_material_ss, m_material_stride * SLAB_SIZE, nullptr, GL_DYNAMIC_COPY);
+
+        slab->m_chunks.reserve(SLAB_SIZE);
+        slab->m_free_slots.reserve(SLAB_SIZE);
+        for (size_t slot = 0; slot < SLAB_SIZE; ++slot)
+        {
+            BufferRange const density{ slab->m_density_ss, static_cast<GLintptr>(m_density_stride * slot), m_density_stride };
+            BufferRange const materials{ slab->m_material_ss, static_cast<GLintptr>(m_material_stride * slot), m_material_stride };
+            uint32_t const index = static_cast<uint32_t>(slab_index * SLAB_SIZE + slot);
+            Chunk & chunk = slab->m_chunks.emplace_back(r_game_system, m_base_lod_point_width, index, static_cast<uint32_t>(slot), m_slab_generations[slab_index], density, materials);
+            m_scene->addActor(*chunk.getRigidBody());
+            slab->m_free_slots.push_back(static_cast<uint32_t>(SLAB_SIZE - 1 - slot)); // Popped from the back, lowest slot first
+        }
+        recordEvent(Event::SLAB_ALLOCATED, slab_index);
         return true;
     }
 
-    void ChunkPool::deactivateChunk(Chunk * chunk)
+    void ChunkPool::releaseSlab(size_t slab_index)
+    {
+        auto & slab = m_slabs[slab_index];
+        uint32_t next_generation = m_slab_generations[slab_index];
+        for (auto & chunk : slab->m_chunks)
+        {
+            next_generation = std::max(next_generation, chunk.getGeneration() + 1);
+            m_mesh_bytes -= chunk.getMeshBytes();
+            m_meshed_count -= chunk.getMeshBytes() > 0;
+            chunk.release(); // Also removes the rigid body from the scene
+        }
+        // A later slab at this index continues the generations, so handles into this one stay stale
+        m_slab_generations[slab_index] = next_generation;
+
+        AssetManager & asset_manager = r_game_system.getAssetManager();
+        asset_manager.deleteBuffer(slab->m_density_ss);
+        asset_manager.deleteBuffer(slab->m_material_ss);
+        slab.reset();
+        while (!m_slabs.empty() && !m_slabs.back()) m_slabs.pop_back();
+        m_out_of_budget = false;
+        recordEvent(Event::SLAB_RELEASED, slab_index);
+    }
+
+    void ChunkPool::recordEvent(Event::Type type, size_t slab_index)
+    {
+        m_events.push_back({ type, slab_index, getCapacity() });
+        if (m_events.size() > MAX_EVENTS) m_events.pop_front();
+        char const * const names[] = { "Allocated", "Released", "Out of budget for" };
+        ENG_LOG_F("%s chunk slab %zu, %zu of %zu chunks active, %.1f MiB", names[type], slab_index, getActiveCount(), getCapacity(), getMemoryUsage() / 1048576.0);
+    }
+
+    void ChunkPool::trim()
+    {
+        for (size_t slab_index = m_slabs.size(); slab_index-- > 0;)
+        {
+            // Parked chunks keep their share of the capacity, they are only dropped with a slab otherwise unused
+            bool const over_target = getCapacity() >= m_target_capacity + m_parked_order.size() + SLAB_SIZE;
+            if (!over_target && getMemoryUsage() <= m_memory_budget) break;
+            if (slab_index >= m_slabs.size()) continue; // Gaps before a released slab are dropped with it
+            Slab const * slab = m_slabs[slab_index].get();
+            if (!slab || slab->m_free_slots.size() + slab->m_parked_count < SLAB_SIZE) continue;
+            for (auto parked = m_parked_order.begin(); parked != m_parked_order.end();)
+            {
+                auto const next = std::next(parked);
+                if (*parked / SLAB_SIZE == slab_index) evictParkedChunk(parked);
+                parked = next;
+            }
+            releaseSlab(slab_index);
+        }
+    }
+
+    ChunkHandle ChunkPool::activateChunk(glm::ivec3 const & position, float chunk_size)
     {
-        chunk->deactivate(m_first_unused);
-        m_first_unused = chunk;
+        if (auto const parked = m_parked_chunks.find(position); parked != m_parked_chunks.end()) evictParkedChunk(parked->second);
+
+        auto const has_free_slot = [](auto const & slab) { return slab && !slab->m_free_slots.empty(); };
+        auto slab = std::find_if(m_slabs.begin(), m_slabs.end(), has_free_slot);
+        if (slab == m_slabs.end())
+        {
+            // Parked chunks are only given up for new ones once the pool can't grow anymore
+            if (getMemoryUsage() + SLAB_SIZE * getChunkBytes() > m_memory_budget && !m_parked_order.empty())
+            {
+                evictParkedChunk(m_parked_order.begin());
+                ++m_cache_evictions;
+            }
+            else if (!allocateSlab()) return {};
+            slab = std::find_if(m_slabs.begin(), m_slabs.end(), has_free_slot);
+        }
+
+        uint32_t const slot = (*slab)->m_free_slots.back();
+        (*slab)->m_free_slots.pop_back();
+        Chunk & chunk = (*slab)->m_chunks[slot];
+        chunk.activate(position, chunk_size);
+        m_active_chunks[position] = chunk.getHandle().m_index;
+        return chunk.getHandle();
     }
 
-    bool ChunkPool::getChunkAt(glm::ivec3 const & position, std::vector<Chunk>::iterator & out_chunk)
+    void ChunkPool::deactivateChunk(ChunkHandle handle)
     {
-        auto result = std::find_if(begin(), end(), [&](Chunk chunk)
+        Chunk * chunk = get(handle);
+        if (!chunk) return;
+        m_active_chunks.erase(chunk->getPosition());
+        chunk->deactivate();
+        size_t const mesh_bytes = chunk->getMeshBytes();
+        chunk->releaseMesh();
+        updateMeshBytes(*chunk, mesh_bytes);
+        m_slabs[handle.m_index / SLAB_SIZE]->m_free_slots.push_back(chunk->getSlot());
+    }
+
+    void ChunkPool::parkChunk(ChunkHandle handle)
+    {
+        Chunk * chunk = get(handle);
+        if (!chunk) return;
+        size_t const chunk_bytes = getSlotBytes() + chunk->getMeshBytes();
+        if (m_cache_budget < chunk_bytes)
         {
-            return chunk.isActive() && chunk.getPosition() == position;
-        });
-        if (result != end())
+            deactivateChunk(handle);
+            return;
+        }
+        m_active_chunks.erase(chunk->getPosition());
+        chunk->deactivate();
+        ++m_slabs[handle.m_index / SLAB_SIZE]->m_parked_count;
+        m_parked_chunks[chunk->getPosition()] = m_parked_order.insert(m_parked_order.end(), handle.m_index);
+        m_parked_bytes += chunk_bytes;
+        while (m_parked_bytes > m_cache_budget)
         {
-            out_chunk = result;
-            return true;
+            evictParkedChunk(m_parked_order.begin());
+            ++m_cache_evictions;
         }
-        return false;
     }
 
-    bool ChunkPool::hasChunkAt(glm::ivec3 const & position)
+    ChunkHandle ChunkPool::restoreChunk(glm::ivec3 const & position, float chunk_size, bool prefetched)
     {
-        return std::find_if(begin(), end(), [&](Chunk chunk)
+        auto const parked = m_parked_chunks.find(position);
+        if (parked == m_parked_chunks.end())
         {
-            return chunk.isActive() && chunk.getPosition() == position;
-        }) != end();
+            if (!prefetched) ++m_cache_misses;
+            return {};
+        }
+        uint32_t const index = *parked->second;
+        m_parked_order.erase(parked->second);
+        m_parked_chunks.erase(parked);
+        --m_slabs[index / SLAB_SIZE]->m_parked_count;
+
+        Chunk & chunk = getChunk(index);
+        m_parked_bytes -= getSlotBytes() + chunk.getMeshBytes();
+        chunk.restore(chunk_size);
+        m_active_chunks[position] = index;
+        if (!prefetched) ++m_cache_hits;
+        return chunk.getHandle();
+    }
+
+    void ChunkPool::evictParkedChunk(std::list<uint32_t>::iterator parked)
+    {
+        uint32_t const index = *parked;
+        Chunk & chunk = getChunk(index);
+        m_parked_chunks.erase(chunk.getPosition());
+        m_parked_order.erase(parked);
+        size_t const mesh_bytes = chunk.getMeshBytes();
+        m_parked_bytes -= getSlotBytes() + mesh_bytes;
+        chunk.releaseMesh();
+        updateMeshBytes(chunk, mesh_bytes);
+        Slab & slab = *m_slabs[index / SLAB_SIZE];
+        --slab.m_parked_count;
+        slab.m_free_slots.push_back(chunk.getSlot());
+    }
+
+    bool ChunkPool::isParked(Chunk const & chunk) const
+    {
+        auto const parked = m_parked_chunks.find(chunk.getPosition());
+        return !chunk.isActive() && parked != m_parked_chunks.end() && &getChunk(*parked->second) == &chunk;
+    }
+
+    void ChunkPool::updateMeshBytes(Chunk const & chunk, size_t previous_bytes)
+    {
+        size_t const mesh_bytes = chunk.getMeshBytes();
+        m_mesh_bytes = m_mesh_bytes + mesh_bytes - previous_bytes;
+        m_meshed_count = m_meshed_count + (mesh_bytes > 0) - (previous_bytes > 0);
+        if (isParked(chunk)) m_parked_bytes = m_parked_bytes + mesh_bytes - previous_bytes;
+    }
+
+    void ChunkPool::reserveMesh(Chunk & chunk)
+    {
+        size_t const previous_bytes = chunk.getMeshBytes();
+        chunk.reserveMesh(m_base_lod_point_width);
+        updateMeshBytes(chunk, previous_bytes);
+    }
+
+    void ChunkPool::fitMesh(Chunk & chunk, int unsigned vertex_count)
+    {
+        size_t const previous_bytes = chunk.getMeshBytes();
+        chunk.fitMesh(vertex_count);
+        updateMeshBytes(chunk, previous_bytes);
+    }
+
+    void ChunkPool::clearCache()
+    {
+        while (!m_parked_order.empty()) evictParkedChunk(m_parked_order.begin());
+    }
+
+    ChunkHandle ChunkPool::findChunk(glm::ivec3 const & position) const
+    {
+        auto const result = m_active_chunks.find(position);
+        if (result == m_active_chunks.end()) return {};
+        return getChunk(result->second).getHandle();
+    }
+
+    Chunk * ChunkPool::get(ChunkHandle handle) const
+    {
+        if (!handle.isValid()) return nullptr;
+        size_t const slab_index = handle.m_index / SLAB_SIZE;
+        if (slab_index >= m_slabs.size() || !m_slabs[slab_index]) return nullptr;
+        Chunk & chunk = getChunk(handle.m_index);
+        return chunk.isActive() && chunk.getGeneration() == handle.m_generation ? &chunk : nullptr;
+    }
+
+    Chunk * ChunkPool::getChunkAt(glm::ivec3 const & position) const
+    {
+        return get(findChunk(position));
+    }
+
+    bool ChunkPool::hasChunkAt(glm::ivec3 const & position) const
+    {
+        return m_active_chunks.contains(position);
+    }
+
+    Chunk * ChunkPool::getResidentChunkAt(glm::ivec3 const & position) const
+    {
+        if (Chunk * chunk = getChunkAt(position)) return chunk;
+        auto const parked = m_parked_chunks.find(position);
+        return parked == m_parked_chunks.end() ? nullptr : &getChunk(*parked->second);
     }
 
     int unsigned ChunkPool::getBaseLodPointWidth() const
     {
         return m_base_lod_point_width;
     }
+
+    GLsizeiptr ChunkPool::getDensityStride() const
+    {
+        return m_density_stride;
+    }
+
+    GLsizeiptr ChunkPool::getMaterialStride() const
+    {
+        return m_material_stride;
+    }
+
+    size_t ChunkPool::getActiveCount() const
+    {
+        return m_active_chunks.size();
+    }
+
+    size_t ChunkPool::getCapacity() const
+    {
+        return getSlabCount() * SLAB_SIZE;
+    }
+
+    size_t ChunkPool::getSlabCount() const
+    {
+        return std::count_if(m_slabs.begin(), m_slabs.end(), [](auto const & slab) { return slab != nullptr; });
+    }
+
+    size_t ChunkPool::getSlotBytes() const
+    {
+        return sizeof(World::INITIAL_INDIRECT_DRAW_CONFIG) + m_density_stride + m_material_stride;
+    }
+
+    size_t ChunkPool::getChunkBytes() const
+    {
+        size_t const mesh_bytes = m_meshed_count > 0 ? m_mesh_bytes / m_meshed_count : maxChunkTriangles(m_base_lod_point_width) * Chunk::MESH_BYTES_PER_TRIANGLE;
+        return getSlotBytes() + mesh_bytes;
+    }
+
+    size_t ChunkPool::getMemoryUsage() const
+    {
+        return getCapacity() * getSlotBytes() + m_mesh_bytes;
+    }
+
+    size_t ChunkPool::getMemoryBudget() const
+    {
+        return m_memory_budget;
+    }
+
+    bool ChunkPool::isOutOfBudget() const
+    {
+        return m_out_of_budget;
+    }
+
+    size_t ChunkPool::getParkedCount() const
+    {
+        return m_parked_order.size();
+    }
+
+    size_t ChunkPool::getCacheBudget() const
+    {
+        return m_cache_budget;
+    }
+
+    size_t ChunkPool::getCacheHits() const
+    {
+        return m_cache_hits;
+    }
+
+    size_t ChunkPool::getCacheMisses() const
+    {
+        return m_cache_misses;
+    }
+
+    size_t ChunkPool::getCacheEvictions() const
+    {
+        return m_cache_evictions;
+    }
+
+    std::deque<ChunkPool::Event> const & ChunkPool::getEvents() const
+    {
+        return m_events;
+    }
+
+    ChunkPool::Iterator ChunkPool::begin() const
+    {
+        return { m_slabs, 0 };
+    }
+
+    ChunkPool::Iterator ChunkPool::end() const
+    {
+        return { m_slabs, m_slabs.size() };
+    }
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -18,8 +23,50 @@ namespace eng
         return (point_width - 1) * (point_width - 1) * (point_width - 1) * 5;
     }
 
+    // Rounds size up so consecutive slices of a buffer can be bound as shader storage ranges
+    GLsizeiptr alignStorageOffset(GLsizeiptr size);
+
+    // A chunk's slice of one of the pool wide buffers, or a whole buffer at offset 0
+    struct BufferRange
+    {
+        GLuint m_buffer{};
+        GLintptr m_offset{};
+        GLsizeiptr m_size{};
+
+        void bindStorage(GLuint binding) const
+        {
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, m_buffer, m_offset, m_size);
+        }
+    };
+
+    // Refers to a pool chunk across frames. Goes stale once the chunk is deactivated, even after its slot is reused.
+    struct ChunkHandle
+    {
+        uint32_t constexpr static INVALID_INDEX = UINT32_MAX;
+
+        uint32_t m_index{ INVALID_INDEX }; // Slab * ChunkPool::SLAB_SIZE + slot
+        uint32_t m_generation{};
+
+        bool isValid() const { return m_index != INVALID_INDEX; }
+        bool operator==(ChunkHandle const & other) const = default;
+    };
+
+    struct ChunkPositionHash
+    {
+        size_t operator()(glm::ivec3 const & position) const
+        {
+            // 21 bits per axis, coordinates far enough out to wrap just share buckets
+            uint64_t const packed = (static_cast<uint64_t>(position.x) & 0x1FFFFF) | (static_cast<uint64_t>(position.y) & 0x1FFFFF) << 21 | (static_cast<uint64_t>(position.z) & 0x1FFFFF) << 42;
+            return std::hash<uint64_t>{}(packed);
+        }
+    };
+
     class Chunk
     {
+    public:
+        int unsigned constexpr static MESH_CAPACITY_GRANULARITY = 64; // Triangles, fitted meshes are rounded up to it
+        size_t constexpr static MESH_BYTES_PER_TRIANGLE = 18 * sizeof(float) + 3 * sizeof(uint32_t); // Vertices and their materials
+
     private:
         std::vector<uint32_t> inline static s_indices{};
 
@@ -27,65 +74,208 @@ namespace eng
         static void generateIndices(size_t count);
 
     private:
-        GLuint m_mesh_vb, m_density_distribution_ss, m_draw_indirect_buffer;
+        GLuint m_mesh_vb, m_draw_indirect_buffer;
+        BufferRange m_density_distribution_ss;
+        BufferRange m_material_ss; // TerrainMaterial ids of the density points, packed
+        uint32_t m_index; // In the pool, see ChunkHandle
+        uint32_t m_slot; // Of the slices of its slab's density and material buffers
+        uint32_t m_generation; // Bumped on deactivation so handles to the previous occupant go stale
+        GLuint m_material_vb; // One id per mesh vertex, a separate stream so colliders and raycasts keep reading the mesh as is
         int unsigned m_vertex_count{};
+        int unsigned m_triangle_capacity{}; // Of the mesh and material vertex buffers
         bool m_active{}, m_has_valid_collider{};
+        bool m_apron_edited{}; // The apron holds edits of a neighbour and may no longer match freshly generated terrain
+        bool m_edited{}; // Points it owns were terraformed, so chunks generated below it have to copy them into their aprons
         physx::PxRigidStatic * m_static_rigid_body;
 
         GameSystem & r_game_system;
-        union
-        {
-            glm::ivec3 m_position{};
-            Chunk * m_next_unused;
-        };
+        glm::ivec3 m_position{};
 
     public:
-        Chunk(GameSystem & game_system, int unsigned base_lod_point_width);
+        Chunk(GameSystem & game_system, int unsigned base_lod_point_width, uint32_t index, uint32_t slot, uint32_t generation, BufferRange const & density, BufferRange const & materials);
 
         void releasePhysics();
-        void setMeshConfig(int unsigned point_width);
-        void setMeshCollider(std::vector<float> const & mesh, physx::PxMaterial * material, float chunk_size);
+        // Physics and the chunk's own buffers, the density and material slices belong to the slab
+        void release();
+        // Worst case storage for meshing at point_width, the current mesh is discarded if the buffers have to grow
+        void reserveMesh(int unsigned point_width);
+        // Shrinks the buffers to the vertex_count vertices of the current mesh, which is kept
+        void fitMesh(int unsigned vertex_count);
+        void releaseMesh();
+        size_t getMeshBytes() const;
+        // Cooking is thread-safe and can run on the job system, setCollider has to hold the scene write lock
+        bool needsCollider() const;
+        physx::PxTriangleMesh * cookCollider(std::vector<float> const & mesh) const;
+        void setCollider(physx::PxTriangleMesh * triangle_mesh, physx::PxMaterial * material, float chunk_size);
         void removeCollider();
         void setMeshInfo(int unsigned vertex_count);
+        void setApronEdited();
+        bool isApronEdited() const;
+        void setEdited();
+        bool isEdited() const;
 
         void activate(glm::ivec3 position, float chunk_size);
-        void deactivate(Chunk * chunk);
+        // Reactivates a parked chunk at its old position, its density, aprons and mesh are still valid
+        void restore(float chunk_size);
+        void deactivate();
 
         glm::ivec3 const & getPosition() const;
-        Chunk * getNextUnused() const;
+        ChunkHandle getHandle() const;
 
         bool isActive() const;
 
         GLuint getMeshVB() const;
-        GLuint getDensityDistributionBuffer() const;
+        uint32_t getSlot() const;
+        uint32_t getGeneration() const;
+        BufferRange const & getDensityDistributionBuffer() const;
         GLuint getDrawIndirectBuffer() const;
+        BufferRange const & getMaterialBuffer() const;
+        GLuint getMaterialVB() const;
 
         physx::PxRigidStatic * getRigidBody() const;
     };
 
+    // Chunks are allocated in slabs of SLAB_SIZE that share one density and one material buffer, so a batched kernel
+    // can reach every chunk of a slab. The pool grows a slab at a time when it runs out of chunks and releases slabs
+    // without active chunks once it's above its target capacity or memory budget. Live chunks never move, so their
+    // addresses stay valid while they're active, anything kept across frames should hold a ChunkHandle instead.
+    // Unloaded chunks can be parked instead of freed: they keep their slot with its density and mesh untouched until
+    // restoreChunk brings them back, or until the least recently parked ones are evicted to stay within the cache
+    // budget or to make room for new chunks once the pool can't grow.
     class ChunkPool
     {
+    public:
+        size_t constexpr static SLAB_SIZE = 64;
+        size_t constexpr static DEFAULT_MEMORY_BUDGET = size_t{ 1 } << 30;
+        size_t constexpr static DEFAULT_CACHE_BUDGET = size_t{ 256 } << 20;
+        size_t constexpr static MAX_EVENTS = 16;
+
+        struct Event
+        {
+            enum Type : uint8_t
+            {
+                SLAB_ALLOCATED,
+                SLAB_RELEASED,
+                OUT_OF_BUDGET // An activation failed because another slab would exceed the budget, recorded once until a
+                              // slab is released or the budget changes
+            };
+            Type m_type;
+            size_t m_slab;
+            size_t m_capacity; // Chunks after the event
+        };
+
     private:
-        std::vector<Chunk> m_chunks;
-        Chunk * m_first_unused{};
+        struct Slab
+        {
+            GLuint m_density_ss{}, m_material_ss{};
+            std::vector<Chunk> m_chunks; // Reserved up front and never reallocated
+            std::vector<uint32_t> m_free_slots;
+            size_t m_parked_count{};
+        };
+
+        // Released slabs leave a gap, indices of the other slabs' chunks don't change
+        std::vector<std::unique_ptr<Slab>> m_slabs;
+        std::vector<uint32_t> m_slab_generations; // First generation of a slab's chunks, outlives released slabs
+        std::unordered_map<glm::ivec3, uint32_t, ChunkPositionHash> m_active_chunks; // Position to index
+        std::list<uint32_t> m_parked_order; // Indices of the parked chunks, least recently parked first
+        std::unordered_map<glm::ivec3, std::list<uint32_t>::iterator, ChunkPositionHash> m_parked_chunks;
+        size_t m_cache_budget{ DEFAULT_CACHE_BUDGET };
+        size_t m_parked_bytes{}; // Slots and meshes of the parked chunks
+        size_t m_mesh_bytes{}, m_meshed_count{}; // Mesh storage of all chunks and how many hold any
+        size_t m_cache_hits{}, m_cache_misses{}, m_cache_evictions{};
         int unsigned m_base_lod_point_width{ 16 };
+        GLsizeiptr m_density_stride{}, m_material_stride{}; // Bytes per slot
+        size_t m_target_capacity{}, m_memory_budget{ DEFAULT_MEMORY_BUDGET };
+        bool m_out_of_budget{}; // OUT_OF_BUDGET was recorded since the last release or budget change
+        std::deque<Event> m_events; // The last MAX_EVENTS
 
         GameSystem & r_game_system;
+        physx::PxScene * m_scene{};
+
+    private:
+        Chunk & getChunk(uint32_t index) const;
+        bool allocateSlab();
+        void releaseSlab(size_t slab_index);
+        void evictParkedChunk(std::list<uint32_t>::iterator parked);
+        bool isParked(Chunk const & chunk) const;
+        void updateMeshBytes(Chunk const & chunk, size_t previous_bytes);
+        void recordEvent(Event::Type type, size_t slab_index);
+
     public:
+        class Iterator
+        {
+        private:
+            std::vector<std::unique_ptr<Slab>> const * m_slabs;
+            size_t m_slab, m_slot{};
+
+            void skipReleasedSlabs();
+        public:
+            Iterator(std::vector<std::unique_ptr<Slab>> const & slabs, size_t slab);
+            Chunk & operator*() const;
+            Iterator & operator++();
+            bool operator!=(Iterator const & other) const;
+        };
+
         ChunkPool(GameSystem & game_system);
         ~ChunkPool();
-        void initialize(size_t initial_size, int unsigned base_lod_point_width);
-        void setPoolSize(size_t size);
-        bool activateChunk(Chunk *& out_chunk, glm::ivec3 position, float chunk_size);
-        void deactivateChunk(Chunk * chunk);
-        bool getChunkAt(glm::ivec3 const & position, std::vector<Chunk>::iterator & out_chunk);
-        bool hasChunkAt(glm::ivec3 const & position);
+        // Chunk rigid bodies are added to scene as their slabs are allocated, the caller holds its write lock
+        void initialize(int unsigned base_lod_point_width, physx::PxScene * scene);
+        // The capacity trim shrinks the pool to, growing past it happens on demand
+        void setTargetCapacity(size_t chunk_count);
+        // Trims the pool to the new budget, the caller holds the scene's write lock
+        void setMemoryBudget(size_t bytes);
+        // 0 disables parking, parkChunk then deactivates right away
+        void setCacheBudget(size_t bytes);
+        // Releases slabs without active chunks while the capacity is above the target or the budget. Activation fills
+        // the lowest slabs first, so the ones at the end empty out as the loaded area moves.
+        void trim();
+
+        // Invalid if the pool is full and can't grow within its budget
+        ChunkHandle activateChunk(glm::ivec3 const & position, float chunk_size);
+        // Frees the chunk's slot and its mesh storage
+        void deactivateChunk(ChunkHandle handle);
+        // Deactivates the chunk but keeps its data around for restoreChunk, the handle goes stale either way
+        void parkChunk(ChunkHandle handle);
+        // Invalid if nothing is parked at position, counted as a cache hit or miss unless the chunk was parked by the
+        // prefetcher, whose hits are counted by the world
+        ChunkHandle restoreChunk(glm::ivec3 const & position, float chunk_size, bool prefetched);
+        void clearCache();
+        ChunkHandle findChunk(glm::ivec3 const & position) const;
+        // nullptr if the handle is stale
+        Chunk * get(ChunkHandle handle) const;
+        Chunk * getChunkAt(glm::ivec3 const & position) const;
+        bool hasChunkAt(glm::ivec3 const & position) const;
+        // Active or parked, for work that has to keep parked data consistent with its neighbours
+        Chunk * getResidentChunkAt(glm::ivec3 const & position) const;
+        // Chunks only hold worst case mesh storage from meshing until the GPU is done with it and the exact size is
+        // known, these keep the memory usage and the cache in step with the resizes
+        void reserveMesh(Chunk & chunk);
+        void fitMesh(Chunk & chunk, int unsigned vertex_count);
 
         int unsigned getBaseLodPointWidth() const;
+        GLsizeiptr getDensityStride() const;
+        GLsizeiptr getMaterialStride() const;
+        // Occupancy
+        size_t getActiveCount() const;
+        size_t getCapacity() const;
+        size_t getSlabCount() const;
+        // GPU memory of a chunk without its mesh: its slices of the slab buffers and the draw command
+        size_t getSlotBytes() const;
+        // Slot plus the average mesh of the chunks holding one, the worst case mesh before anything was meshed
+        size_t getChunkBytes() const;
+        size_t getMemoryUsage() const;
+        size_t getMemoryBudget() const;
+        // Activations fail until a slab is released or the budget changes
+        bool isOutOfBudget() const;
+        size_t getParkedCount() const;
+        size_t getCacheBudget() const;
+        size_t getCacheHits() const;
+        size_t getCacheMisses() const;
+        size_t getCacheEvictions() const;
+        std::deque<Event> const & getEvents() const;
 
-        std::vector<Chunk>::iterator begin() { return m_chunks.begin(); }
-        std::vector<Chunk>::iterator end() { return m_chunks.end(); }
-        std::vector<Chunk>::const_iterator begin() const { return m_chunks.begin(); }
-        std::vector<Chunk>::const_iterator end() const { return m_chunks.end(); }
+        // Every chunk of the allocated slabs, active or not
+        Iterator begin() const;
+        Iterator end() const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,608 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include "world/marching_cubes_tables.hpp"
+#include "world/simplex_noise.hpp"
+
+#include "world/cpu_terrain.hpp"
+
+namespace eng::cpu
+{
+    struct ConfigField
+    {
+        char const * m_name;
+        void * m_value;
+        bool m_is_int;
+    };
+
+    static std::array<ConfigField, GENERATION_CONFIG_FIELD_COUNT> getConfigFields(GenerationConfig & config)
+    {
+        return
+        { {
+            { "u_octaves_2d", &config.m_octaves_2d, true },                 { "u_octaves_3d", &config.m_octaves_3d, true },
+            { "u_frequency_2d", &config.m_frequency_2d, false },            { "u_lacunarity_2d", &config.m_lacunarity_2d, false },
+            { "u_persistence_2d", &config.m_persistence_2d, false },        { "u_amplitude_2d", &config.m_amplitude_2d, false },
+            { "u_exponent_2d", &config.m_exponent_2d, false },              { "u_frequency_3d", &config.m_frequency_3d, false },
+            { "u_lacunarity_3d", &config.m_lacunarity_3d, false },          { "u_persistence_3d", &config.m_persistence_3d, false },
+            { "u_amplitude_3d", &config.m_amplitude_3d, false },            { "u_exponent_3d", &config.m_exponent_3d, false },
+            { "u_weight_multiplier_3d", &config.m_weight_multiplier_3d, false }, { "u_noise_weight_3d", &config.m_noise_weight_3d, false }
+        } };
+    }
+
+    bool loadGenerationConfig(char const * file_path, GenerationConfig & out_config)
+    {
+        auto const fields = getConfigFields(out_config);
+        std::ifstream stream(file_path, std::ios::in);
+        if (!stream) return false;
+        std::string line;
+        while (std::getline(stream, line, '\n'))
+        {
+            size_t colon_pos{ line.find(":", 0) };
+            if (colon_pos == std::string::npos) continue;
+            std::string name = line.substr(0, colon_pos), value = line.substr(colon_pos + 1);
+            for (auto const & field : fields)
+            {
+                if (name != field.m_name) continue;
+                if (field.m_is_int) *static_cast<int *>(field.m_value) = std::stoi(value);
+                else *static_cast<float *>(field.m_value) = std::stof(value);
+            }
+        }
+        return true;
+    }
+
+    bool setGenerationConfigField(GenerationConfig & config, std::string_view name, void const * value)
+    {
+        for (auto const & field : getConfigFields(config))
+        {
+            if (name != field.m_name) continue;
+            std::memcpy(field.m_value, value, field.m_is_int ? sizeof(int) : sizeof(float));
+            return true;
+        }
+        return false;
+    }
+
+    template<typename Noise>
+    static float sampleLayeredDensity(GenerationConfig const & config, glm::vec3 const & sample_position, Noise noise_function)
+    {
+        float total_noise = 0.0f, amplitude = 1.0f, weight = 1.0f, frequency = config.m_frequency_3d;
+        for (int i = 0; i < config.m_octaves_3d; ++i)
+        {
+            float noise = 1.0f - std::abs(noise_function(sample_position * frequency));
+            noise = noise * noise * weight;
+            weight = std::clamp(noise * config.m_weight_multiplier_3d, 0.0f, 1.0f);
+            total_noise += amplitude * noise;
+            frequency *= config.m_lacunarity_3d;
+            amplitude *= config.m_persistence_3d;
+        }
+        return sample_position.y - total_noise * config.m_noise_weight_3d;
+    }
+
+    float sampleDensity(GenerationConfig const & config, glm::vec3 const & sample_position)
+    {
+        return sampleLayeredDensity(config, sample_position, [](glm::vec3 const & p) { return SimplexNoise::noise(p.x, p.y, p.z); });
+    }
+
+    float simplexNoiseGlsl(glm::vec3 const & v)
+    {
+        auto const permute = [](glm::vec4 const & x) { return glm::mod((x * 34.0f + 1.0f) * x, 289.0f); };
+        glm::vec2 const C(1.0f / 6.0f, 1.0f / 3.0f);
+
+        // First corner
+        glm::vec3 i = glm::floor(v + glm::dot(v, glm::vec3(C.y)));
+        glm::vec3 const x0 = v - i + glm::dot(i, glm::vec3(C.x));
+
+        // Other corners
+        glm::vec3 const g = glm::step(glm::vec3(x0.y, x0.z, x0.x), x0);
+        glm::vec3 const l = 1.0f - g;
+        glm::vec3 const i1 = glm::min(g, glm::vec3(l.z, l.x, l.y));
+        glm::vec3 const i2 = glm::max(g, glm::vec3(l.z, l.x, l.y));
+        glm::vec3 const x1 = x0 - i1 + C.x;
+        glm::vec3 const x2 = x0 - i2 + 2.0f * C.x;
+        glm::vec3 const x3 = x0 - 1.0f + 3.0f * C.x;
+
+        // Permutations
+        i = glm::mod(i, 289.0f);
+        glm::vec4 const p = permute(permute(permute(i.z + glm::vec4(0.0f, i1.z, i2.z, 1.0f)) + i.y + glm::vec4(0.0f, i1.y, i2.y, 1.0f)) + i.x + glm::vec4(0.0f, i1.x, i2.x, 1.0f));
+
+        // Gradients, 7x7 points over a square mapped onto an octahedron
+        float const n_ = 1.0f / 7.0f;
+        glm::vec3 const ns = n_ * glm::vec3(2.0f, 0.5f, 1.0f) - glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec4 const j = p - 49.0f * glm::floor(p * ns.z * ns.z);
+        glm::vec4 const x_ = glm::floor(j * ns.z);
+        glm::vec4 const y_ = glm::floor(j - 7.0f * x_);
+        glm::vec4 const x = x_ * ns.x + ns.y;
+        glm::vec4 const y = y_ * ns.x + ns.y;
+        glm::vec4 const h = 1.0f - glm::abs(x) - glm::abs(y);
+        glm::vec4 const b0(x.x, x.y, y.x, y.y);
+        glm::vec4 const b1(x.z, x.w, y.z, y.w);
+        glm::vec4 const s0 = glm::floor(b0) * 2.0f + 1.0f;
+        glm::vec4 const s1 = glm::floor(b1) * 2.0f + 1.0f;
+        glm::vec4 const sh = -glm::step(h, glm::vec4(0.0f));
+        glm::vec4 const a0 = glm::vec4(b0.x, b0.z, b0.y, b0.w) + glm::vec4(s0.x, s0.z, s0.y, s0.w) * glm::vec4(sh.x, sh.x, sh.y, sh.y);
+        glm::vec4 const a1 = glm::vec4(b1.x, b1.z, b1.y, b1.w) + glm::vec4(s1.x, s1.z, s1.y, s1.w) * glm::vec4(sh.z, sh.z, sh.w, sh.w);
+        glm::vec3 p0(a0.x, a0.y, h.x), p1(a0.z, a0.w, h.y), p2(a1.x, a1.y, h.z), p3(a1.z, a1.w, h.w);
+
+        // Normalise gradients
+        glm::vec4 const norm = 1.79284291400159f - 0.85373472095314f * glm::vec4(glm::dot(p0, p0), glm::dot(p1, p1), glm::dot(p2, p2), glm::dot(p3, p3));
+        p0 *= norm.x;
+        p1 *= norm.y;
+        p2 *= norm.z;
+        p3 *= norm.w;
+
+        // Mix final noise value
+        glm::vec4 m = glm::max(0.6f - glm::vec4(glm::dot(x0, x0), glm::dot(x1, x1), glm::dot(x2, x2), glm::dot(x3, x3)), 0.0f);
+        m *= m;
+        return 42.0f * glm::dot(m * m, glm::vec4(glm::dot(p0, x0), glm::dot(p1, x1), glm::dot(p2, x2), glm::dot(p3, x3)));
+    }
+
+    float sampleGlslDensity(GenerationConfig const & config, glm::vec3 const & sample_position)
+    {
+        return sampleLayeredDensity(config, sample_position, simplexNoiseGlsl);
+    }
+
+    struct Interval
+    {
+        float m_min, m_max;
+    };
+
+    static Interval multiply(Interval const & a, Interval const & b)
+    {
+        float const products[] = { a.m_min * b.m_min, a.m_min * b.m_max, a.m_max * b.m_min, a.m_max * b.m_max };
+        return { *std::min_element(std::begin(products), std::end(products)), *std::max_element(std::begin(products), std::end(products)) };
+    }
+
+    // Bounds how far sampleGlslDensity displaces the surface from y = 0 over an axis aligned box of sample positions.
+    // Each octave's noise is the value at the box center widened by how far it can change within the box.
+    static Interval boundDisplacement(GenerationConfig const & config, glm::vec3 const & box_min, glm::vec3 const & box_max)
+    {
+        glm::vec3 const center = 0.5f * (box_min + box_max);
+        float const half_diagonal = 0.5f * glm::length(box_max - box_min);
+        Interval total_noise{ 0.0f, 0.0f }, weight{ 1.0f, 1.0f };
+        float amplitude = 1.0f, frequency = config.m_frequency_3d;
+        for (int i = 0; i < config.m_octaves_3d; ++i)
+        {
+            float const value = simplexNoiseGlsl(center * frequency);
+            float const spread = NOISE_SLOPE_BOUND * std::abs(frequency) * half_diagonal + NOISE_JUMP_BOUND;
+            Interval const noise{ std::max(value - spread, -1.0f), std::min(value + spread, 1.0f) };
+            // 1 - |noise| squared falls as |noise| grows
+            Interval const magnitude = noise.m_min >= 0.0f ? noise : noise.m_max <= 0.0f ? Interval{ -noise.m_max, -noise.m_min } : Interval{ 0.0f, std::max(-noise.m_min, noise.m_max) };
+            Interval const ridge = multiply({ (1.0f - magnitude.m_max) * (1.0f - magnitude.m_max), (1.0f - magnitude.m_min) * (1.0f - magnitude.m_min) }, weight);
+            Interval const next_weight = multiply(ridge, { config.m_weight_multiplier_3d, config.m_weight_multiplier_3d });
+            weight = { std::clamp(next_weight.m_min, 0.0f, 1.0f), std::clamp(next_weight.m_max, 0.0f, 1.0f) };
+            Interval const octave = multiply(ridge, { amplitude, amplitude });
+            total_noise = { total_noise.m_min + octave.m_min, total_noise.m_max + octave.m_max };
+            frequency *= config.m_lacunarity_3d;
+            amplitude *= config.m_persistence_3d;
+        }
+        return multiply(total_noise, { config.m_noise_weight_3d, config.m_noise_weight_3d });
+    }
+
+    static Interval boundDensity(GenerationConfig const & config, glm::vec3 const & box_min, glm::vec3 const & box_max)
+    {
+        Interval const displacement = boundDisplacement(config, box_min, box_max);
+        return { box_min.y - displacement.m_max, box_max.y - displacement.m_min };
+    }
+
+    // False if the point is on the other side of the threshold than in_out_class, which starts out as SURFACE
+    static bool classifyPoint(GenerationConfig const & config, glm::ivec3 const & point, float spacing, float threshold, ChunkClass & in_out_class)
+    {
+        float const value = sampleGlslDensity(config, glm::vec3(point) * spacing);
+        // The GPU doesn't round exactly the same way
+        if (std::abs(value - threshold) < CLASSIFY_SAMPLE_MARGIN) return false;
+        ChunkClass const point_class = value < threshold ? ChunkClass::SOLID : ChunkClass::EMPTY;
+        if (in_out_class != ChunkClass::SURFACE && point_class != in_out_class) return false;
+        in_out_class = point_class;
+        return true;
+    }
+
+    // Whether the grid points first..last are all of the expected class. Boxes the bounds can't decide are split along
+    // every axis until they're small enough that sampling their points is as cheap as bounding the halves. False once
+    // in_out_budget runs out, every bound and sample costs one evaluation.
+    static bool arePointsUniform(GenerationConfig const & config, float spacing, glm::ivec3 const & first, glm::ivec3 const & last, float threshold, ChunkClass expected_class, int & in_out_budget)
+    {
+        if (--in_out_budget < 0) return false;
+        Interval const density = boundDensity(config, glm::vec3(first) * spacing, glm::vec3(last) * spacing);
+        if (density.m_min > threshold) return expected_class == ChunkClass::EMPTY;
+        if (density.m_max < threshold) return expected_class == ChunkClass::SOLID;
+
+        glm::ivec3 const extent = last - first;
+        if (std::max({ extent.x, extent.y, extent.z }) < CLASSIFY_LEAF_WIDTH)
+        {
+            for (int z = first.z; z <= last.z; ++z)
+            {
+                for (int y = first.y; y <= last.y; ++y)
+                {
+                    for (int x = first.x; x <= last.x; ++x)
+                    {
+                        if (--in_out_budget < 0 || !classifyPoint(config, { x, y, z }, spacing, threshold, expected_class)) return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        glm::ivec3 const middle = first + extent / 2;
+        for (int octant = 0; octant < 8; ++octant)
+        {
+            glm::ivec3 const upper(octant & 1, octant >> 1 & 1, octant >> 2 & 1);
+            if ((upper.x && !extent.x) || (upper.y && !extent.y) || (upper.z && !extent.z)) continue; // Axis can't be split
+            glm::ivec3 child_first, child_last;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                child_first[axis] = upper[axis] ? middle[axis] + 1 : first[axis];
+                child_last[axis] = upper[axis] || !extent[axis] ? last[axis] : middle[axis];
+            }
+            if (!arePointsUniform(config, spacing, child_first, child_last, threshold, expected_class, in_out_budget)) return false;
+        }
+        return true;
+    }
+
+    ChunkClass classifyChunk(GenerationConfig const & config, glm::ivec3 const & chunk_position, int unsigned point_width, float threshold)
+    {
+        int const points_from_zero = static_cast<int>(point_width) - 1;
+        float const spacing = CHUNK_NOISE_EXTENT / static_cast<float>(points_from_zero);
+        glm::ivec3 const first = chunk_position * points_from_zero;
+        // The corners run into the surface of most chunks before anything has to be bounded
+        ChunkClass chunk_class = ChunkClass::SURFACE;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::ivec3 const offset(corner & 1, corner >> 1 & 1, corner >> 2 & 1);
+            if (!classifyPoint(config, first + offset * points_from_zero, spacing, threshold, chunk_class)) return ChunkClass::SURFACE;
+        }
+        int budget = CLASSIFY_EVALUATION_BUDGET;
+        return arePointsUniform(config, spacing, first, first + points_from_zero, threshold, chunk_class, budget) ? chunk_class : ChunkClass::SURFACE;
+    }
+
+    void estimateSurfaceRange(GenerationConfig const & config, glm::ivec2 const & column, float threshold, int & out_min_y, int & out_max_y)
+    {
+        // Without a box to speak of every octave's noise is only bounded by [-1, 1], which holds for any column
+        float constexpr UNBOUNDED = std::numeric_limits<float>::max() / 4.0f;
+        Interval const displacement = boundDisplacement(config, glm::vec3(-UNBOUNDED), glm::vec3(UNBOUNDED));
+        // Points are solid below threshold + displacement and air above it, a chunk spans its points from y * extent
+        // to (y + 1) * extent
+        float const lowest_surface = (threshold + displacement.m_min) / CHUNK_NOISE_EXTENT, highest_surface = (threshold + displacement.m_max) / CHUNK_NOISE_EXTENT;
+        float constexpr Y_LIMIT = static_cast<float>(std::numeric_limits<int>::max() / 2);
+        out_min_y = static_cast<int>(std::clamp(std::ceil(lowest_surface) - 1.0f, -Y_LIMIT, Y_LIMIT));
+        out_max_y = static_cast<int>(std::clamp(std::floor(highest_surface), -Y_LIMIT, Y_LIMIT));
+
+        // The bounds of the column's own chunks are tighter, mostly for low frequencies
+        auto const bound_chunk = [&](int y)
+        {
+            glm::vec3 const box_min = glm::vec3(column.x, y, column.y) * CHUNK_NOISE_EXTENT;
+            return boundDensity(config, box_min, box_min + CHUNK_NOISE_EXTENT);
+        };
+        while (out_min_y < out_max_y && bound_chunk(out_min_y).m_max < threshold) ++out_min_y;
+        while (out_max_y > out_min_y && bound_chunk(out_max_y).m_min > threshold) --out_max_y;
+    }
+
+    void generateDensity(GenerationConfig const & config, glm::ivec3 const & chunk_position, int unsigned point_width, std::vector<float> & out_density, DensityLayout layout)
+    {
+        out_density.resize(getDensityStorageCount(layout, point_width));
+        float const points_from_zero = static_cast<float>(point_width - 1);
+        float const sample_spacing = CHUNK_NOISE_EXTENT / points_from_zero;
+        glm::vec3 const offset = glm::vec3(chunk_position) * points_from_zero;
+        for (int unsigned z = 0; z < point_width; ++z)
+        {
+            for (int unsigned y = 0; y < point_width; ++y)
+            {
+                for (int unsigned x = 0; x < point_width; ++x)
+                {
+                    out_density[getDensityIndex(layout, point_width, x, y, z)] = sampleDensity(config, (glm::vec3(x, y, z) + offset) * sample_spacing);
+                }
+            }
+        }
+    }
+
+    void convertDensityLayout(std::vector<float> const & density, int unsigned point_width, DensityLayout from, DensityLayout to, std::vector<float> & out_density)
+    {
+        out_density.assign(getDensityStorageCount(to, point_width), 0.0f);
+        for (int unsigned z = 0; z < point_width; ++z)
+        {
+            for (int unsigned y = 0; y < point_width; ++y)
+            {
+                for (int unsigned x = 0; x < point_width; ++x)
+                {
+                    out_density[getDensityIndex(to, point_width, x, y, z)] = density[getDensityIndex(from, point_width, x, y, z)];
+                }
+            }
+        }
+    }
+
+    TerrainMaterial::Id sampleMaterial(glm::vec3 const & sample_position)
+    {
+        glm::vec3 const p = sample_position * TerrainMaterial::NOISE_FREQUENCY + TerrainMaterial::NOISE_OFFSET;
+        return TerrainMaterial::select(simplexNoiseGlsl(p));
+    }
+
+    void generateMaterials(glm::ivec3 const & chunk_position, int unsigned point_width, std::vector<uint32_t> & out_materials, DensityLayout layout)
+    {
+        out_materials.assign(TerrainMaterial::getPackedWordCount(getDensityStorageCount(layout, point_width)), 0);
+        float const points_from_zero = static_cast<float>(point_width - 1);
+        float const sample_spacing = CHUNK_NOISE_EXTENT / points_from_zero;
+        glm::vec3 const offset = glm::vec3(chunk_position) * points_from_zero;
+        for (int unsigned z = 0; z < point_width; ++z)
+        {
+            for (int unsigned y = 0; y < point_width; ++y)
+            {
+                for (int unsigned x = 0; x < point_width; ++x)
+                {
+                    size_t const index = getDensityIndex(layout, point_width, x, y, z);
+                    TerrainMaterial::pack(out_materials.data(), index, sampleMaterial((glm::vec3(x, y, z) + offset) * sample_spacing));
+                }
+            }
+        }
+    }
+
+    static glm::vec3 interpolateVertices(glm::vec4 const & v1, glm::vec4 const & v2, float threshold)
+    {
+        float t = (threshold - v1.w) / (v2.w - v1.w);
+        return glm::vec3(v1) + t * (glm::vec3(v2) - glm::vec3(v1));
+    }
+
+    // Corner densities in the order of marching_cubes.glsl
+    static void meshCell(float const (&corner_densities)[8], glm::vec3 const & p, float step_size, float threshold, std::vector<float> & out_triangles)
+    {
+        glm::vec4 const cube_corners[8] =
+        {
+            { p,                                                corner_densities[0] },
+            { p + glm::vec3(step_size, 0.0f, 0.0f),             corner_densities[1] },
+            { p + glm::vec3(step_size, 0.0f, step_size),        corner_densities[2] },
+            { p + glm::vec3(0.0f, 0.0f, step_size),             corner_densities[3] },
+            { p + glm::vec3(0.0f, step_size, 0.0f),             corner_densities[4] },
+            { p + glm::vec3(step_size, step_size, 0.0f),        corner_densities[5] },
+            { p + glm::vec3(step_size, step_size, step_size),   corner_densities[6] },
+            { p + glm::vec3(0.0f, step_size, step_size),        corner_densities[7] }
+        };
+
+        int unsigned cube_index = 0;
+        for (int unsigned i = 0; i < 8; ++i) if (cube_corners[i].w < threshold) cube_index |= 1 << i;
+        if (cube_index == 0 || cube_index == 255) return;
+
+        int const * index_configuration = TRIANGULATION_TABLE[cube_index];
+        for (int i = 0; index_configuration[i] != -1; i += 3)
+        {
+            glm::vec3 vertices[3];
+            for (int v = 0; v < 3; ++v)
+            {
+                int edge = index_configuration[i + v];
+                vertices[v] = interpolateVertices(cube_corners[CORNER_INDEX_A_FROM_EDGE[edge]], cube_corners[CORNER_INDEX_B_FROM_EDGE[edge]], threshold);
+            }
+            glm::vec3 normal = glm::normalize(glm::cross(vertices[1] - vertices[0], vertices[2] - vertices[0]));
+            for (auto const & vertex : vertices)
+            {
+                out_triangles.insert(out_triangles.end(), { vertex.x, vertex.y, vertex.z, normal.x, normal.y, normal.z });
+            }
+        }
+    }
+
+    void generateMesh(std::vector<float> const & density, int unsigned point_width, float threshold, std::vector<float> & out_triangles, DensityLayout layout)
+    {
+        out_triangles.clear();
+        int unsigned const cells = point_width - 1;
+        float const step_size = 1.0f / static_cast<float>(cells);
+        auto index = [point_width, layout](int unsigned x, int unsigned y, int unsigned z) { return getDensityIndex(layout, point_width, x, y, z); };
+
+        for (int unsigned z = 0; z < cells; ++z)
+        {
+            for (int unsigned y = 0; y < cells; ++y)
+            {
+                for (int unsigned x = 0; x < cells; ++x)
+                {
+                    float const corner_densities[8] =
+                    {
+                        density[index(x, y, z)],         density[index(x + 1, y, z)],         density[index(x + 1, y, z + 1)],         density[index(x, y, z + 1)],
+                        density[index(x, y + 1, z)],     density[index(x + 1, y + 1, z)],     density[index(x + 1, y + 1, z + 1)],     density[index(x, y + 1, z + 1)]
+                    };
+                    meshCell(corner_densities, glm::vec3(x, y, z) * step_size, step_size, threshold, out_triangles);
+                }
+            }
+        }
+    }
+
+    void generateMeshTiled(std::vector<float> const & density, int unsigned point_width, float threshold, int unsigned tile_width, std::vector<float> & out_triangles, DensityLayout layout)
+    {
+        out_triangles.clear();
+        int unsigned const cells = point_width - 1;
+        float const step_size = 1.0f / static_cast<float>(cells);
+        int unsigned const tile_points = tile_width + 1;
+        std::vector<float> tile(static_cast<size_t>(tile_points) * tile_points * tile_points);
+        auto tile_index = [tile_points](int unsigned x, int unsigned y, int unsigned z) { return (static_cast<size_t>(z) * tile_points + y) * tile_points + x; };
+
+        for (int unsigned tile_z = 0; tile_z < cells; tile_z += tile_width)
+        {
+            for (int unsigned tile_y = 0; tile_y < cells; tile_y += tile_width)
+            {
+                for (int unsigned tile_x = 0; tile_x < cells; tile_x += tile_width)
+                {
+                    // Stage the tile's points, clamped to the chunk like the GPU loader
+                    for (int unsigned z = 0; z < tile_points; ++z)
+                    {
+                        for (int unsigned y = 0; y < tile_points; ++y)
+                        {
+                            for (int unsigned x = 0; x < tile_points; ++x)
+                            {
+                                tile[tile_index(x, y, z)] = density[getDensityIndex(layout, point_width, std::min(tile_x + x, cells), std::min(tile_y + y, cells), std::min(tile_z + z, cells))];
+                            }
+                        }
+                    }
+
+                    int unsigned const end_x = std::min(tile_width, cells - tile_x), end_y = std::min(tile_width, cells - tile_y), end_z = std::min(tile_width, cells - tile_z);
+                    for (int unsigned z = 0; z < end_z; ++z)
+                    {
+                        for (int unsigned y = 0; y < end_y; ++y)
+                        {
+                            for (int unsigned x = 0; x < end_x; ++x)
+                            {
+                                float const corner_densities[8] =
+                                {
+                                    tile[tile_index(x, y, z)],       tile[tile_index(x + 1, y, z)],       tile[tile_index(x + 1, y, z + 1)],       tile[tile_index(x, y, z + 1)],
+                                    tile[tile_index(x, y + 1, z)],   tile[tile_index(x + 1, y + 1, z)],   tile[tile_index(x + 1, y + 1, z + 1)],   tile[tile_index(x, y + 1, z + 1)]
+                                };
+                                meshCell(corner_densities, glm::vec3(tile_x + x, tile_y + y, tile_z + z) * step_size, step_size, threshold, out_triangles);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void countCellTriangles(std::vector<float> const & density, int unsigned point_width, float threshold, std::vector<uint32_t> & out_counts, DensityLayout layout)
+    {
+        int unsigned const cells = point_width - 1;
+        out_counts.resize(static_cast<size_t>(cells) * cells * cells);
+        auto solid = [&](int unsigned x, int unsigned y, int unsigned z) { return density[getDensityIndex(layout, point_width, x, y, z)] < threshold; };
+
+        size_t cell = 0;
+        for (int unsigned z = 0; z < cells; ++z)
+        {
+            for (int unsigned y = 0; y < cells; ++y)
+            {
+                for (int unsigned x = 0; x < cells; ++x)
+                {
+                    // Same corner order as generateMesh
+                    int unsigned const cube_index = solid(x, y, z) | solid(x + 1, y, z) << 1 | solid(x + 1, y, z + 1) << 2 | solid(x, y, z + 1) << 3
+                        | solid(x, y + 1, z) << 4 | solid(x + 1, y + 1, z) << 5 | solid(x + 1, y + 1, z + 1) << 6 | solid(x, y + 1, z + 1) << 7;
+                    uint32_t triangle_count = 0;
+                    if (cube_index != 0 && cube_index != 255)
+                    {
+                        for (int i = 0; TRIANGULATION_TABLE[cube_index][i] != -1; i += 3) ++triangle_count;
+                    }
+                    out_counts[cell++] = triangle_count;
+                }
+            }
+        }
+    }
+
+    uint32_t exclusiveScan(std::vector<uint32_t> & values)
+    {
+        uint32_t total = 0;
+        for (auto & value : values)
+        {
+            uint32_t const count = value;
+            value = total;
+            total += count;
+        }
+        return total;
+    }
+
+    void TriangleBvh::build(std::vector<float> const & triangles, float scale, glm::vec3 const & translation)
+    {
+        size_t triangle_count = triangles.size() / FLOATS_PER_TRIANGLE;
+        m_vertices.resize(triangle_count * 3);
+        m_triangle_indices.resize(triangle_count);
+        m_nodes.clear();
+        m_nodes.reserve(2 * triangle_count / MAX_LEAF_SIZE + 1);
+
+        std::vector<glm::vec3> centroids(triangle_count);
+        for (size_t triangle = 0; triangle < triangle_count; ++triangle)
+        {
+            for (size_t vertex = 0; vertex < 3; ++vertex)
+            {
+                float const * data = &triangles[triangle * FLOATS_PER_TRIANGLE + vertex * 6];
+                m_vertices[triangle * 3 + vertex] = (glm::vec3(data[0], data[1], data[2]) + translation) * scale;
+            }
+            centroids[triangle] = (m_vertices[triangle * 3] + m_vertices[triangle * 3 + 1] + m_vertices[triangle * 3 + 2]) / 3.0f;
+            m_triangle_indices[triangle] = static_cast<uint32_t>(triangle);
+        }
+        if (triangle_count > 0) buildNode(centroids, 0, static_cast<uint32_t>(triangle_count));
+    }
+
+    uint32_t TriangleBvh::buildNode(std::vector<glm::vec3> const & centroids, uint32_t first, uint32_t count)
+    {
+        uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back({ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()), first, count });
+
+        glm::vec3 bounds_min = m_nodes[node_index].m_min, bounds_max = m_nodes[node_index].m_max;
+        glm::vec3 centroid_min = bounds_min, centroid_max = bounds_max;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            uint32_t triangle = m_triangle_indices[i];
+            for (uint32_t vertex = 0; vertex < 3; ++vertex)
+            {
+                bounds_min = glm::min(bounds_min, m_vertices[triangle * 3 + vertex]);
+                bounds_max = glm::max(bounds_max, m_vertices[triangle * 3 + vertex]);
+            }
+            centroid_min = glm::min(centroid_min, centroids[triangle]);
+            centroid_max = glm::max(centroid_max, centroids[triangle]);
+        }
+        m_nodes[node_index].m_min = bounds_min;
+        m_nodes[node_index].m_max = bounds_max;
+        if (count <= MAX_LEAF_SIZE) return node_index;
+
+        // Median split along the longest centroid axis
+        glm::vec3 extent = centroid_max - centroid_min;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        uint32_t half = count / 2;
+        std::nth_element(m_triangle_indices.begin() + first, m_triangle_indices.begin() + first + half, m_triangle_indices.begin() + first + count,
+            [&centroids, axis](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+        buildNode(centroids, first, half);
+        uint32_t right = buildNode(centroids, first + half, count - half);
+        m_nodes[node_index].m_first = right;
+        m_nodes[node_index].m_count = 0;
+        return node_index;
+    }
+
+    bool TriangleBvh::intersect(glm::vec3 const & origin, glm::vec3 const & direction, float & out_distance) const
+    {
+        if (m_nodes.empty()) return false;
+        float constexpr EPSILON = 0.0000001f;
+        glm::vec3 const inverse_direction = 1.0f / direction;
+        float closest = std::numeric_limits<float>::max();
+
+        uint32_t stack[64];
+        int stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            Node const & node = m_nodes[stack[--stack_size]];
+            glm::vec3 t_0 = (node.m_min - origin) * inverse_direction, t_1 = (node.m_max - origin) * inverse_direction;
+            glm::vec3 t_near = glm::min(t_0, t_1), t_far = glm::max(t_0, t_1);
+            float t_enter = std::max(std::max(t_near.x, t_near.y), t_near.z), t_exit = std::min(std::min(t_far.x, t_far.y), t_far.z);
+            if (t_enter > t_exit || t_exit < 0.0f || t_enter > closest) continue;
+
+            if (node.m_count == 0)
+            {
+                stack[stack_size++] = node.m_first;
+                stack[stack_size++] = static_cast<uint32_t>(&node - m_nodes.data()) + 1;
+                continue;
+            }
+            // Möller-Trumbore, same as mesh_ray_intersect.glsl
+            for (uint32_t i = node.m_first; i < node.m_first + node.m_count; ++i)
+            {
+                glm::vec3 const * vertices = &m_vertices[m_triangle_indices[i] * 3];
+                glm::vec3 edge1 = vertices[1] - vertices[0], edge2 = vertices[2] - vertices[0], h = glm::cross(direction, edge2);
+                float a = glm::dot(edge1, h);
+                if (a > -EPSILON && a < EPSILON) continue;
+                float f = 1.0f / a;
+                glm::vec3 s = origin - vertices[0];
+                float u = f * glm::dot(s, h);
+                if (u < 0.0f || u > 1.0f) continue;
+                glm::vec3 q = glm::cross(s, edge1);
+                float v = f * glm::dot(direction, q);
+                if (v < 0.0f || u + v > 1.0f) continue;
+                float t = f * glm::dot(edge2, q);
+                if (t > EPSILON && t < closest) closest = t;
+            }
+        }
+        if (closest == std::numeric_limits<float>::max()) return false;
+        out_distance = closest;
+        return true;
+    }
+
+    size_t TriangleBvh::getNodeCount() const
+    {
+        return m_nodes.size();
+    }
+
+    size_t TriangleBvh::getTriangleCount() const
+    {
+        return m_triangle_indices.size();
+    }
+}
\ No newline at end of file
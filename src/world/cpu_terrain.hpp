@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "world/density_layout.hpp"
+#include "world/terrain_material.hpp"
+
+namespace eng::cpu
+{
+    // CPU backends of the terrain pipeline. They mirror the compute shaders closely enough to be used as reference
+    // implementations and to benchmark the pipeline without a GPU or window.
+
+    int unsigned constexpr FLOATS_PER_TRIANGLE = 18;
+    // Noise space units a chunk spans along each axis, independent of its point width. World injects it into
+    // generate_points.glsl.
+    float constexpr CHUNK_NOISE_EXTENT = 7.5f;
+
+    // Same layout as the std140 WorldGenerationConfig block in generate_points.glsl
+    struct GenerationConfig
+    {
+        int m_octaves_2d{}, m_octaves_3d{ 6 };
+        float m_frequency_2d{}, m_lacunarity_2d{}, m_persistence_2d{}, m_amplitude_2d{}, m_exponent_2d{};
+        float m_frequency_3d{ 0.015f }, m_lacunarity_3d{ 1.925f }, m_persistence_3d{ 0.44f }, m_amplitude_3d{}, m_exponent_3d{}, m_weight_multiplier_3d{ 3.65f }, m_noise_weight_3d{ 7.27f };
+    };
+
+    size_t constexpr GENERATION_CONFIG_FIELD_COUNT = 14;
+
+    bool loadGenerationConfig(char const * file_path, GenerationConfig & out_config);
+    // Sets the field named after the block variable name to the int or float at value, false if none is
+    bool setGenerationConfigField(GenerationConfig & config, std::string_view name, void const * value);
+
+    // Sample coordinates are scaled the same way as in generate_points.glsl
+    float sampleDensity(GenerationConfig const & config, glm::vec3 const & sample_position);
+    void generateDensity(GenerationConfig const & config, glm::ivec3 const & chunk_position, int unsigned point_width, std::vector<float> & out_density, DensityLayout layout = DensityLayout::LINEAR);
+
+    // Port of simplexNoise3d in simplex_noise.glsl, which isn't the SimplexNoise::noise the reference above uses.
+    // Anything that has to hold for the density the GPU generates is evaluated with it.
+    float simplexNoiseGlsl(glm::vec3 const & position);
+    float sampleGlslDensity(GenerationConfig const & config, glm::vec3 const & sample_position);
+
+    // How far simplexNoiseGlsl can change per unit of distance: four corner kernels 42 (0.6 - r^2)^4 (g . d) with
+    // |g| <= 1.1 change by at most 42 * 1.1 * 0.1633 each. The kernels reach past their simplex, which shows up as
+    // jumps well below the jump bound where the containing simplex changes.
+    float constexpr NOISE_SLOPE_BOUND = 30.2f, NOISE_JUMP_BOUND = 0.01f;
+    // Boxes of classifyChunk narrower than this many points along every axis are sampled instead of split further.
+    // Samples closer to the threshold than the margin count as surface. Once a chunk has used up the evaluation
+    // budget, density samples and box bounds alike, the boxes still left unproven count as surface too.
+    int constexpr CLASSIFY_LEAF_WIDTH = 2, CLASSIFY_EVALUATION_BUDGET = 32;
+    float constexpr CLASSIFY_SAMPLE_MARGIN = 1e-3f;
+
+    enum class ChunkClass : uint8_t
+    {
+        EMPTY,  // Above the threshold everywhere, air
+        SOLID,  // Below it everywhere
+        SURFACE // May cross it
+    };
+
+    // Whether all point_width^3 points the GPU generates for the chunk, aprons included, are on one side of the
+    // threshold. Samples at the corners reject most surface chunks, then interval bounds of the density settle
+    // boxes of points and are refined over halves where they're inconclusive, the points of the smallest boxes are
+    // sampled. Never classifies a chunk with triangles as EMPTY or SOLID, but may call a uniform one SURFACE, which
+    // it does for every chunk it can't settle within CLASSIFY_EVALUATION_BUDGET.
+    ChunkClass classifyChunk(GenerationConfig const & config, glm::ivec3 const & chunk_position, int unsigned point_width, float threshold);
+
+    // Range of chunk y coordinates in the column of chunks at (x, z) whose points may be on both sides of the
+    // threshold. Every chunk below it is solid and every chunk above it air. The global range follows from the config
+    // alone and is trimmed by the bounds of the column's own chunks.
+    void estimateSurfaceRange(GenerationConfig const & config, glm::ivec2 const & column, float threshold, int & out_min_y, int & out_max_y);
+
+    // Reorders density between layouts, e.g. to keep saved or read back density independent of the layout in use
+    void convertDensityLayout(std::vector<float> const & density, int unsigned point_width, DensityLayout from, DensityLayout to, std::vector<float> & out_density);
+
+    // Packed the same way as the chunk material buffers, see TerrainMaterial::pack. Uses simplexNoiseGlsl like
+    // generate_points.glsl, so the ids match the ones the GPU generates.
+    TerrainMaterial::Id sampleMaterial(glm::vec3 const & sample_position);
+    void generateMaterials(glm::ivec3 const & chunk_position, int unsigned point_width, std::vector<uint32_t> & out_materials, DensityLayout layout = DensityLayout::LINEAR);
+
+    // Emits UnpaddedTriangles (position + flat normal per vertex) in cell order, positions in [0, 1] chunk space
+    void generateMesh(std::vector<float> const & density, int unsigned point_width, float threshold, std::vector<float> & out_triangles, DensityLayout layout = DensityLayout::LINEAR);
+    // Same cells as generateMesh visited in tiles of tile_width^3, each first copied into a local (tile_width + 1)^3 block
+    // like the tiled marching cubes kernel. Triangles come out in tile order rather than cell order.
+    void generateMeshTiled(std::vector<float> const & density, int unsigned point_width, float threshold, int unsigned tile_width, std::vector<float> & out_triangles, DensityLayout layout = DensityLayout::LINEAR);
+
+    // Reference for the compacting marching cubes passes: triangle count per cell in cell order, and the exclusive
+    // prefix sum scan_triangle_counts.glsl computes over them. exclusiveScan works in place and returns the total.
+    void countCellTriangles(std::vector<float> const & density, int unsigned point_width, float threshold, std::vector<uint32_t> & out_counts, DensityLayout layout = DensityLayout::LINEAR);
+    uint32_t exclusiveScan(std::vector<uint32_t> & values);
+
+    class TriangleBvh
+    {
+    private:
+        struct Node
+        {
+            glm::vec3 m_min, m_max;
+            uint32_t m_first; // First triangle for leaves, right child for inner nodes (left child is always next)
+            uint32_t m_count; // 0 for inner nodes
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_triangle_indices;
+        std::vector<glm::vec3> m_vertices; // Three per triangle
+
+    private:
+        uint32_t buildNode(std::vector<glm::vec3> const & centroids, uint32_t first, uint32_t count);
+
+    public:
+        uint32_t constexpr static MAX_LEAF_SIZE = 4;
+
+        void build(std::vector<float> const & triangles, float scale, glm::vec3 const & translation);
+        bool intersect(glm::vec3 const & origin, glm::vec3 const & direction, float & out_distance) const;
+
+        size_t getNodeCount() const;
+        size_t getTriangleCount() const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace eng
+{
+    // Order of the points in a chunk's density and material storage. Linear is z-major, so the 8 corners of a cell
+    // are spread over 4 rows in 2 planes. Bricked stores 4x4x4 bricks contiguously, the corners of most cells then lie
+    // in one 256 byte brick. Matches density_layout.glsl.
+    enum class DensityLayout : uint8_t
+    {
+        LINEAR,
+        BRICKED
+    };
+
+    uint32_t constexpr DENSITY_BRICK_WIDTH = 4;
+
+    constexpr uint32_t getBricksPerAxis(uint32_t point_width)
+    {
+        return (point_width + DENSITY_BRICK_WIDTH - 1) / DENSITY_BRICK_WIDTH;
+    }
+
+    // Bricked storage rounds every axis up to whole bricks, the padding is never written
+    constexpr size_t getDensityStorageCount(DensityLayout layout, uint32_t point_width)
+    {
+        size_t const width = layout == DensityLayout::BRICKED ? static_cast<size_t>(getBricksPerAxis(point_width)) * DENSITY_BRICK_WIDTH : point_width;
+        return width * width * width;
+    }
+
+    constexpr size_t getDensityIndex(DensityLayout layout, uint32_t point_width, uint32_t x, uint32_t y, uint32_t z)
+    {
+        if (layout == DensityLayout::LINEAR) return (static_cast<size_t>(z) * point_width + y) * point_width + x;
+        size_t const bricks_per_axis = getBricksPerAxis(point_width);
+        size_t const brick = (z / DENSITY_BRICK_WIDTH * bricks_per_axis + y / DENSITY_BRICK_WIDTH) * bricks_per_axis + x / DENSITY_BRICK_WIDTH;
+        size_t const local = (z % DENSITY_BRICK_WIDTH * DENSITY_BRICK_WIDTH + y % DENSITY_BRICK_WIDTH) * DENSITY_BRICK_WIDTH + x % DENSITY_BRICK_WIDTH;
+        return brick * DENSITY_BRICK_WIDTH * DENSITY_BRICK_WIDTH * DENSITY_BRICK_WIDTH + local;
+    }
+}
\ No newline at end of file
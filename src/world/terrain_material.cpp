@@ -0,0 +1,30 @@
+#include "world/terrain_material.hpp"
+
+namespace eng::TerrainMaterial
+{
+    namespace
+    {
+        Description const DESCRIPTIONS[COUNT] =
+        {
+            { "GRASS",  0, 1, 1.0f },
+            { "DIRT",   1, 1, 0.75f },
+            { "ROCK",   2, 2, 4.0f }
+        };
+    }
+
+    Description const & getDescription(Id id)
+    {
+        return DESCRIPTIONS[id];
+    }
+
+    std::vector<std::string> const & getLayerPaths()
+    {
+        static std::vector<std::string> const layer_paths
+        {
+            "res/textures/TexturesCom_Grass0157_1_seamless_S.jpg",
+            "res/textures/TexturesCom_SoilMud0044_1_seamless_S.jpg",
+            "res/textures/TexturesCom_Cliffs0356_1_seamless_S.jpg"
+        };
+        return layer_paths;
+    }
+}
\ No newline at end of file
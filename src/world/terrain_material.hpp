@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace eng::TerrainMaterial
+{
+    // Every density point stores one of these as an 8 bit index into the material palette. The terrain shaders get the
+    // ids and selection constants as defines, see World::makeMaterialDefines, and the palette as a uniform block.
+    enum Id : uint8_t
+    {
+        GRASS,
+        DIRT,
+        ROCK,
+        COUNT
+    };
+
+    struct Description
+    {
+        char const * m_name;
+        uint32_t m_top_layer, m_side_layer; // Layers of the material texture array, top is used for upward facing surfaces
+        float m_hardness; // Digging strength is divided by it, placing material ignores it
+    };
+
+    // Patches follow a low frequency noise field that is independent of the density, sampled at the same coordinates
+    float constexpr NOISE_FREQUENCY = 0.05f, NOISE_OFFSET = 101.0f;
+    float constexpr ROCK_THRESHOLD = 0.35f, DIRT_THRESHOLD = -0.35f;
+
+    constexpr Id select(float noise)
+    {
+        return noise > ROCK_THRESHOLD ? ROCK : noise < DIRT_THRESHOLD ? DIRT : GRASS;
+    }
+
+    // Chunks store ids packed four to a word in point index order, a quarter of the size of the density
+    uint32_t constexpr IDS_PER_WORD = 4, BITS_PER_ID = 8;
+
+    constexpr size_t getPackedWordCount(size_t point_count)
+    {
+        return (point_count + IDS_PER_WORD - 1) / IDS_PER_WORD;
+    }
+
+    constexpr Id unpack(uint32_t const * packed, size_t index)
+    {
+        return static_cast<Id>(packed[index / IDS_PER_WORD] >> (index % IDS_PER_WORD * BITS_PER_ID) & 0xFF);
+    }
+
+    // Expects the id's bits to be cleared, like the generation shader which ORs into a zeroed buffer
+    constexpr void pack(uint32_t * packed, size_t index, Id id)
+    {
+        packed[index / IDS_PER_WORD] |= static_cast<uint32_t>(id) << (index % IDS_PER_WORD * BITS_PER_ID);
+    }
+
+    Description const & getDescription(Id id);
+    // One texture per layer, in layer order
+    std::vector<std::string> const & getLayerPaths();
+}
\ No newline at end of file
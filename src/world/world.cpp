@@ -1,293 +1,53 @@
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_set>
 
 #include "glm/gtc/type_ptr.hpp"
 
+#include "profiler.hpp"
+#include "world/cpu_terrain.hpp"
+#include "world/marching_cubes_tables.hpp"
+
 #include "world/world.hpp"
 
 namespace eng
 {
     World::World(GameSystem & game_system) : r_game_system(game_system), m_chunk_pool(game_system)
     {
-        m_density_generator     = game_system.getAssetManager().getShader("res/shaders/generate_points.glsl");
-        m_marching_cubes        = game_system.getAssetManager().getShader("res/shaders/marching_cubes.glsl");
-        m_chunk_renderer        = game_system.getAssetManager().getShader("res/shaders/chunk.glsl");
+        auto start = std::chrono::steady_clock::now();
+        m_scan_triangle_counts  = game_system.getAssetManager().getShader("res/shaders/scan_triangle_counts.glsl");
+        m_scan_block_totals     = game_system.getAssetManager().getShader("res/shaders/scan_triangle_counts.glsl", withDefine({}, "SCAN_BLOCK_TOTALS"));
+        m_chunk_renderer        = game_system.getAssetManager().getShader("res/shaders/chunk.glsl", makeMaterialDefines());
         m_mesh_ray_intersect    = game_system.getAssetManager().getShader("res/shaders/mesh_ray_intersect.glsl");
         m_ray_mesh_command      = game_system.getAssetManager().getShader("res/shaders/ray_mesh_command.glsl");
-        m_terraform             = game_system.getAssetManager().getShader("res/shaders/terraform.glsl");
-        
-        m_grass_texture         = game_system.getAssetManager().getTexture("res/textures/TexturesCom_Grass0157_1_seamless_S.jpg");
-        m_dirt_texture          = game_system.getAssetManager().getTexture("res/textures/TexturesCom_SoilMud0044_1_seamless_S.jpg");
-
-        auto tri_table = new int[256][16]
-        {
-            { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 3, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 2, 10, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 8, 3, 2, 10, 8, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 11, 2, 8, 11, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 9, 0, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 11, 2, 1, 9, 11, 9, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 10, 1, 11, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 10, 1, 0, 8, 10, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 9, 0, 3, 11, 9, 11, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 10, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 4, 7, 3, 0, 4, 1, 2, 10, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 2, 10, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 10, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
-            { 8, 4, 7, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 11, 4, 7, 11, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 0, 1, 8, 4, 7, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 7, 11, 9, 4, 11, 9, 11, 2, 9, 2, 1, -1, -1, -1, -1 },
-            { 3, 10, 1, 3, 11, 10, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 11, 10, 1, 4, 11, 1, 0, 4, 7, 11, 4, -1, -1, -1, -1 },
-            { 4, 7, 8, 9, 0, 11, 9, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
-            { 4, 7, 11, 4, 11, 9, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 10, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 0, 8, 1, 2, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 2, 10, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 10, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1 },
-            { 9, 5, 4, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 11, 2, 0, 8, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 5, 4, 0, 1, 5, 2, 3, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 1, 5, 2, 5, 8, 2, 8, 11, 4, 8, 5, -1, -1, -1, -1 },
-            { 10, 3, 11, 10, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 9, 5, 0, 8, 1, 8, 10, 1, 8, 11, 10, -1, -1, -1, -1 },
-            { 5, 4, 0, 5, 0, 11, 5, 11, 10, 11, 0, 3, -1, -1, -1, -1 },
-            { 5, 4, 8, 5, 8, 10, 10, 8, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 7, 8, 9, 5, 7, 10, 1, 2, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1 },
-            { 8, 0, 2, 8, 2, 5, 8, 5, 7, 10, 5, 2, -1, -1, -1, -1 },
-            { 2, 10, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 7, 9, 5, 7, 8, 9, 3, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
-            { 2, 3, 11, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1 },
-            { 11, 2, 1, 11, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 5, 8, 8, 5, 7, 10, 1, 3, 10, 3, 11, -1, -1, -1, -1 },
-            { 5, 7, 0, 5, 0, 9, 7, 11, 0, 1, 0, 10, 11, 10, 0, -1 },
-            { 11, 10, 0, 11, 0, 3, 10, 5, 0, 8, 0, 7, 5, 7, 0, -1 },
-            { 11, 10, 5, 7, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 0, 1, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 8, 3, 1, 9, 8, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1 },
-            { 2, 3, 11, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 11, 0, 8, 11, 2, 0, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 1, 9, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 10, 6, 1, 9, 2, 9, 11, 2, 9, 8, 11, -1, -1, -1, -1 },
-            { 6, 3, 11, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 11, 0, 11, 5, 0, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
-            { 3, 11, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1 },
-            { 6, 5, 9, 6, 9, 11, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 10, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 3, 0, 4, 7, 3, 6, 5, 10, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 9, 0, 5, 10, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1 },
-            { 6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1 },
-            { 8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1 },
-            { 7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1 },
-            { 3, 11, 2, 7, 8, 4, 10, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 10, 6, 4, 7, 2, 4, 2, 0, 2, 7, 11, -1, -1, -1, -1 },
-            { 0, 1, 9, 4, 7, 8, 2, 3, 11, 5, 10, 6, -1, -1, -1, -1 },
-            { 9, 2, 1, 9, 11, 2, 9, 4, 11, 7, 11, 4, 5, 10, 6, -1 },
-            { 8, 4, 7, 3, 11, 5, 3, 5, 1, 5, 11, 6, -1, -1, -1, -1 },
-            { 5, 1, 11, 5, 11, 6, 1, 0, 11, 7, 11, 4, 0, 4, 11, -1 },
-            { 0, 5, 9, 0, 6, 5, 0, 3, 6, 11, 6, 3, 8, 4, 7, -1 },
-            { 6, 5, 9, 6, 9, 11, 4, 7, 9, 7, 11, 9, -1, -1, -1, -1 },
-            { 10, 4, 9, 6, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 10, 6, 4, 9, 10, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 0, 1, 10, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
-            { 1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1 },
-            { 0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 4, 9, 10, 6, 4, 11, 2, 3, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 2, 2, 8, 11, 4, 9, 10, 4, 10, 6, -1, -1, -1, -1 },
-            { 3, 11, 2, 0, 1, 6, 0, 6, 4, 6, 1, 10, -1, -1, -1, -1 },
-            { 6, 4, 1, 6, 1, 10, 4, 8, 1, 2, 1, 11, 8, 11, 1, -1 },
-            { 9, 6, 4, 9, 3, 6, 9, 1, 3, 11, 6, 3, -1, -1, -1, -1 },
-            { 8, 11, 1, 8, 1, 0, 11, 6, 1, 9, 1, 4, 6, 4, 1, -1 },
-            { 3, 11, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
-            { 6, 4, 8, 11, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 7, 10, 6, 7, 8, 10, 8, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 7, 3, 0, 10, 7, 0, 9, 10, 6, 7, 10, -1, -1, -1, -1 },
-            { 10, 6, 7, 1, 10, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1 },
-            { 10, 6, 7, 10, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
-            { 2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1 },
-            { 7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1 },
-            { 7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 3, 11, 10, 6, 8, 10, 8, 9, 8, 6, 7, -1, -1, -1, -1 },
-            { 2, 0, 7, 2, 7, 11, 0, 9, 7, 6, 7, 10, 9, 10, 7, -1 },
-            { 1, 8, 0, 1, 7, 8, 1, 10, 7, 6, 7, 10, 2, 3, 11, -1 },
-            { 11, 2, 1, 11, 1, 7, 10, 6, 1, 6, 7, 1, -1, -1, -1, -1 },
-            { 8, 9, 6, 8, 6, 7, 9, 1, 6, 11, 6, 3, 1, 3, 6, -1 },
-            { 0, 9, 1, 11, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 7, 8, 0, 7, 0, 6, 3, 11, 0, 11, 6, 0, -1, -1, -1, -1 },
-            { 7, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 0, 8, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 1, 9, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 1, 9, 8, 3, 1, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 1, 2, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 10, 3, 0, 8, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 9, 0, 2, 10, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 6, 11, 7, 2, 10, 3, 10, 8, 3, 10, 9, 8, -1, -1, -1, -1 },
-            { 7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1 },
-            { 10, 7, 6, 10, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 7, 6, 1, 7, 10, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1 },
-            { 0, 3, 7, 0, 7, 10, 0, 10, 9, 6, 10, 7, -1, -1, -1, -1 },
-            { 7, 6, 10, 7, 10, 8, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
-            { 6, 8, 4, 11, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 6, 11, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 6, 11, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 4, 6, 9, 6, 3, 9, 3, 1, 11, 3, 6, -1, -1, -1, -1 },
-            { 6, 8, 4, 6, 11, 8, 2, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 10, 3, 0, 11, 0, 6, 11, 0, 4, 6, -1, -1, -1, -1 },
-            { 4, 11, 8, 4, 6, 11, 0, 2, 9, 2, 10, 9, -1, -1, -1, -1 },
-            { 10, 9, 3, 10, 3, 2, 9, 4, 3, 11, 3, 6, 4, 6, 3, -1 },
-            { 8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1 },
-            { 1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 10, 1, -1, -1, -1, -1 },
-            { 10, 1, 0, 10, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 6, 3, 4, 3, 8, 6, 10, 3, 0, 3, 9, 10, 9, 3, -1 },
-            { 10, 9, 4, 6, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 9, 5, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 3, 4, 9, 5, 11, 7, 6, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 0, 1, 5, 4, 0, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 11, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1 },
-            { 9, 5, 4, 10, 1, 2, 7, 6, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 6, 11, 7, 1, 2, 10, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1 },
-            { 7, 6, 11, 5, 4, 10, 4, 2, 10, 4, 0, 2, -1, -1, -1, -1 },
-            { 3, 4, 8, 3, 5, 4, 3, 2, 5, 10, 5, 2, 11, 7, 6, -1 },
-            { 7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1 },
-            { 3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1 },
-            { 6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1 },
-            { 9, 5, 4, 10, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1 },
-            { 1, 6, 10, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1 },
-            { 4, 0, 10, 4, 10, 5, 0, 3, 10, 6, 10, 7, 3, 7, 10, -1 },
-            { 7, 6, 10, 7, 10, 8, 5, 4, 10, 4, 8, 10, -1, -1, -1, -1 },
-            { 6, 9, 5, 6, 11, 9, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 6, 11, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1 },
-            { 0, 11, 8, 0, 5, 11, 0, 1, 5, 5, 6, 11, -1, -1, -1, -1 },
-            { 6, 11, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 10, 9, 5, 11, 9, 11, 8, 11, 5, 6, -1, -1, -1, -1 },
-            { 0, 11, 3, 0, 6, 11, 0, 9, 6, 5, 6, 9, 1, 2, 10, -1 },
-            { 11, 8, 5, 11, 5, 6, 8, 0, 5, 10, 5, 2, 0, 2, 5, -1 },
-            { 6, 11, 3, 6, 3, 5, 2, 10, 3, 10, 5, 3, -1, -1, -1, -1 },
-            { 5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1 },
-            { 9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1 },
-            { 1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 3, 6, 1, 6, 10, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1 },
-            { 10, 1, 0, 10, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1 },
-            { 0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 11, 5, 10, 7, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 11, 5, 10, 11, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 11, 7, 5, 10, 11, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1 },
-            { 10, 7, 5, 10, 11, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1 },
-            { 11, 1, 2, 11, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 11, -1, -1, -1, -1 },
-            { 9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 11, 7, -1, -1, -1, -1 },
-            { 7, 5, 2, 7, 2, 11, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1 },
-            { 2, 5, 10, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 2, 0, 8, 5, 2, 8, 7, 5, 10, 2, 5, -1, -1, -1, -1 },
-            { 9, 0, 1, 5, 10, 3, 5, 3, 7, 3, 10, 2, -1, -1, -1, -1 },
-            { 9, 8, 2, 9, 2, 1, 8, 7, 2, 10, 2, 5, 7, 5, 2, -1 },
-            { 1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 8, 4, 5, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
-            { 5, 0, 4, 5, 11, 0, 5, 10, 11, 11, 3, 0, -1, -1, -1, -1 },
-            { 0, 1, 9, 8, 4, 10, 8, 10, 11, 10, 4, 5, -1, -1, -1, -1 },
-            { 10, 11, 4, 10, 4, 5, 11, 3, 4, 9, 4, 1, 3, 1, 4, -1 },
-            { 2, 5, 1, 2, 8, 5, 2, 11, 8, 4, 5, 8, -1, -1, -1, -1 },
-            { 0, 4, 11, 0, 11, 3, 4, 5, 11, 2, 11, 1, 5, 1, 11, -1 },
-            { 0, 2, 5, 0, 5, 9, 2, 11, 5, 4, 5, 8, 11, 8, 5, -1 },
-            { 9, 4, 5, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 5, 10, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1 },
-            { 5, 10, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 10, 2, 3, 5, 10, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1 },
-            { 5, 10, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1 },
-            { 8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1 },
-            { 9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 11, 7, 4, 9, 11, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 8, 3, 4, 9, 7, 9, 11, 7, 9, 10, 11, -1, -1, -1, -1 },
-            { 1, 10, 11, 1, 11, 4, 1, 4, 0, 7, 4, 11, -1, -1, -1, -1 },
-            { 3, 1, 4, 3, 4, 8, 1, 10, 4, 7, 4, 11, 10, 11, 4, -1 },
-            { 4, 11, 7, 9, 11, 4, 9, 2, 11, 9, 1, 2, -1, -1, -1, -1 },
-            { 9, 7, 4, 9, 11, 7, 9, 1, 11, 2, 11, 1, 0, 8, 3, -1 },
-            { 11, 7, 4, 11, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1 },
-            { 11, 7, 4, 11, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1 },
-            { 2, 9, 10, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1 },
-            { 9, 10, 7, 9, 7, 4, 10, 2, 7, 8, 7, 0, 2, 0, 7, -1 },
-            { 3, 7, 10, 3, 10, 2, 7, 4, 10, 1, 10, 0, 4, 0, 10, -1 },
-            { 1, 10, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1 },
-            { 4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 10, 8, 10, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 0, 9, 3, 9, 11, 11, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 1, 10, 0, 10, 8, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 1, 10, 11, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 2, 11, 1, 11, 9, 9, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 0, 9, 3, 9, 11, 1, 2, 9, 2, 11, 9, -1, -1, -1, -1 },
-            { 0, 2, 11, 8, 0, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 3, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 3, 8, 2, 8, 10, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
-            { 9, 10, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 2, 3, 8, 2, 8, 10, 0, 1, 8, 1, 10, 8, -1, -1, -1, -1 },
-            { 1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { 0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
-            { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }
-        };
+
+        m_material_textures     = game_system.getAssetManager().getTextureArray("terrain_materials", TerrainMaterial::getLayerPaths());
+        for (int id = 0; id < TerrainMaterial::COUNT; ++id)
+        {
+            TerrainMaterial::Description const & description = TerrainMaterial::getDescription(static_cast<TerrainMaterial::Id>(id));
+            m_material_palette[id] = { description.m_top_layer, description.m_side_layer, description.m_hardness, 0.0f };
+        }
+        m_material_palette_u = game_system.getAssetManager().createBuffer();
+        glNamedBufferStorage(m_material_palette_u, sizeof(m_material_palette), m_material_palette, GL_DYNAMIC_STORAGE_BIT);
 
         m_triangulation_table_ss = game_system.getAssetManager().createBuffer();
-        glNamedBufferStorage(m_triangulation_table_ss, sizeof(int) * 256 * 16, tri_table, 0);
+        glNamedBufferStorage(m_triangulation_table_ss, sizeof(TRIANGULATION_TABLE), TRIANGULATION_TABLE, 0);
 
         refreshGenerationSpec();
         size_t config_buffer_size{};
         for (auto const & block_variable : m_generation_spec) config_buffer_size += GLTypeToSize(block_variable.m_type);
 
+        // Zeroed, flat terrain, until a config is uploaded, so that the CPU copy classifyChunk reads matches from the start
+        std::vector<char> const zeroed_config(config_buffer_size);
         m_generation_config_u = game_system.getAssetManager().createBuffer();
-        glNamedBufferStorage(m_generation_config_u, config_buffer_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glNamedBufferStorage(m_generation_config_u, config_buffer_size, zeroed_config.data(), GL_DYNAMIC_STORAGE_BIT);
+        mirrorGenerationConfig(zeroed_config.data());
+
+        m_frame_data_u = game_system.getAssetManager().createBuffer();
+        glNamedBufferStorage(m_frame_data_u, sizeof(FrameData), nullptr, GL_DYNAMIC_STORAGE_BIT);
 
         m_ray_hit_data_ss = game_system.getAssetManager().createBuffer();
         glNamedBufferStorage(m_ray_hit_data_ss, sizeof(float) * RAY_HIT_DATA_SIZE, nullptr, GL_DYNAMIC_STORAGE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
@@ -295,6 +55,9 @@ namespace eng
 
         m_chunk_va = game_system.getAssetManager().createVertexArray();
         VertexArray::setVertexArrayFormat(m_chunk_va, VertexDataLayout::POSITION_NORMAL_3F);
+        glEnableVertexArrayAttrib(m_chunk_va, MATERIAL_ATTRIBUTE);
+        glVertexArrayAttribIFormat(m_chunk_va, MATERIAL_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0);
+        glVertexArrayAttribBinding(m_chunk_va, MATERIAL_ATTRIBUTE, MATERIAL_VERTEX_BINDING);
 
         m_dispatch_indirect_buffer = game_system.getAssetManager().createBuffer();
         glNamedBufferStorage(m_dispatch_indirect_buffer, sizeof(int unsigned) * 3, nullptr, GL_DYNAMIC_STORAGE_BIT);
@@ -311,146 +74,603 @@ namespace eng
         m_controller_manager = PxCreateControllerManager(*m_scene);
         m_player.initCharacterController(m_controller_manager, game_system, { 0.0f, 15.0f, 0.0f });
 
-        m_chunk_pool.initialize(static_cast<size_t>((2 * m_render_distance + 1) * (2 * m_render_distance + 1) * 2), 16);
-        for (auto const & chunk : m_chunk_pool)
-        {
-            m_scene->addActor(*chunk.getRigidBody());
-        }
-
-        delete[] tri_table;
+        m_chunk_pool.initialize(16, m_scene);
+        m_chunk_pool.setTargetCapacity(getTargetPoolCapacity());
+        size_t const cell_count = static_cast<size_t>(maxChunkTriangles(m_chunk_pool.getBaseLodPointWidth()) / 5);
+        m_cell_triangle_offsets_stride = alignStorageOffset(cell_count * sizeof(uint32_t));
+        m_cell_triangle_offsets_ss = game_system.getAssetManager().createBuffer();
+        glNamedBufferStorage(m_cell_triangle_offsets_ss, MAX_BATCH_SIZE * m_cell_triangle_offsets_stride, nullptr, 0);
+        m_block_triangle_offsets_stride = alignStorageOffset((cell_count + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE * sizeof(uint32_t));
+        m_block_triangle_offsets_ss = game_system.getAssetManager().createBuffer();
+        glNamedBufferStorage(m_block_triangle_offsets_ss, MAX_BATCH_SIZE * m_block_triangle_offsets_stride, nullptr, 0);
+        m_chunk_batch_ss = game_system.getAssetManager().createBuffer();
+        glNamedBufferStorage(m_chunk_batch_ss, MAX_BATCH_SIZE * sizeof(glm::ivec4), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        autotuneWorkGroupSizes(false); // Loads the compute kernels
+        ENG_LOG_F("World initialized in %.1f ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
     }
     
     World::~World()
     {
+        clearStressBodies();
         m_controller_manager->release();
         m_scene->release();
         m_chunk_collider_material->release();
     }
 
+    Shader::Defines World::makeMaterialDefines()
+    {
+        Shader::Defines defines;
+        for (int id = 0; id < TerrainMaterial::COUNT; ++id)
+        {
+            defines.emplace_back(std::string("MATERIAL_") + TerrainMaterial::getDescription(static_cast<TerrainMaterial::Id>(id)).m_name, std::to_string(id) + "u");
+        }
+        defines.emplace_back("MATERIAL_COUNT", std::to_string(TerrainMaterial::COUNT));
+        defines.emplace_back("MATERIAL_NOISE_FREQUENCY", std::to_string(TerrainMaterial::NOISE_FREQUENCY));
+        defines.emplace_back("MATERIAL_NOISE_OFFSET", std::to_string(TerrainMaterial::NOISE_OFFSET));
+        defines.emplace_back("MATERIAL_ROCK_THRESHOLD", std::to_string(TerrainMaterial::ROCK_THRESHOLD));
+        defines.emplace_back("MATERIAL_DIRT_THRESHOLD", std::to_string(TerrainMaterial::DIRT_THRESHOLD));
+        return defines;
+    }
+
+    Shader::Defines World::makeComputeDefines() const
+    {
+        Shader::Defines defines = makeMaterialDefines();
+        if (m_density_layout == DensityLayout::BRICKED) defines.emplace_back("DENSITY_BRICKED", "1");
+        return defines;
+    }
+
+    Shader::Defines World::makeKernelDefines(ComputeKernel kernel, int unsigned work_group_size) const
+    {
+        Shader::Defines defines = makeComputeDefines();
+        defines.emplace_back("WORK_GROUP_SIZE", std::to_string(work_group_size));
+        if (kernel == DENSITY_GENERATION) defines.emplace_back("CHUNK_NOISE_EXTENT", std::to_string(cpu::CHUNK_NOISE_EXTENT));
+        if (kernel == MARCHING_CUBES && m_tiled_meshing) defines.emplace_back("MARCHING_CUBES_TILED", "1");
+        return defines;
+    }
+
+    Shader::Defines World::withDefine(Shader::Defines defines, char const * name)
+    {
+        defines.emplace_back(name, "1");
+        return defines;
+    }
+
+    void World::loadComputeKernels()
+    {
+        AssetManager & asset_manager = r_game_system.getAssetManager();
+        Shader::Defines const generation_defines = makeKernelDefines(DENSITY_GENERATION, m_work_group_sizes[DENSITY_GENERATION]);
+        m_density_generator = asset_manager.getShader("res/shaders/generate_points.glsl", generation_defines);
+        m_batched_density_generator = asset_manager.getShader("res/shaders/generate_points.glsl", withDefine(generation_defines, "DENSITY_GENERATION_BATCHED"));
+        Shader::Defines const meshing_defines = makeKernelDefines(MARCHING_CUBES, m_work_group_sizes[MARCHING_CUBES]);
+        m_marching_cubes = asset_manager.getShader("res/shaders/marching_cubes.glsl", meshing_defines);
+        m_marching_cubes_count = asset_manager.getShader("res/shaders/marching_cubes.glsl", withDefine(meshing_defines, "MARCHING_CUBES_COUNT"));
+        m_terraform = asset_manager.getShader("res/shaders/terraform.glsl", makeKernelDefines(TERRAFORM, m_work_group_sizes[TERRAFORM]));
+        m_apron_copy = asset_manager.getShader("res/shaders/copy_apron.glsl", makeComputeDefines());
+        specializeKernels(m_specialized_octaves);
+    }
+
     void World::debugRecompile()
     {
+        // All of them are submitted before any of them is used, so they compile in parallel where supported
         m_density_generator->compile("res/shaders/generate_points.glsl");
         m_chunk_renderer->compile("res/shaders/chunk.glsl");
         m_marching_cubes->compile("res/shaders/marching_cubes.glsl");
+        m_marching_cubes_count->compile("res/shaders/marching_cubes.glsl");
+        m_specialized_density_generator->compile("res/shaders/generate_points.glsl");
+        m_batched_density_generator->compile("res/shaders/generate_points.glsl");
+        m_specialized_batched_density_generator->compile("res/shaders/generate_points.glsl");
+        m_specialized_marching_cubes->compile("res/shaders/marching_cubes.glsl");
+        m_specialized_marching_cubes_count->compile("res/shaders/marching_cubes.glsl");
 
         refreshGenerationSpec();
         invalidateAllChunks();
         generateChunks();
     }
 
-    void World::onPlayerMoved(glm::vec3 const & position)
+    void World::collectVisibleColumns(glm::ivec3 const & center, int render_distance, std::vector<glm::ivec2> & out_columns)
     {
-        auto chunk_coords = static_cast<glm::ivec3>(glm::floor(position / static_cast<float>(m_chunk_size_in_units)));
-        if (m_last_chunk_coords != chunk_coords)
+        out_columns.clear();
+        for (int x_i = -render_distance; x_i <= render_distance; ++x_i)
         {
-            m_last_chunk_coords = chunk_coords;
-            generateChunks();
+            for (int z_i = -render_distance; z_i <= render_distance; ++z_i) out_columns.emplace_back(x_i + center.x, z_i + center.z);
         }
     }
 
+    size_t World::getTargetPoolCapacity() const
+    {
+        size_t const diameter = static_cast<size_t>(2 * (m_render_distance + UNLOAD_HYSTERESIS) + 1);
+        return diameter * diameter * POOL_CHUNKS_PER_COLUMN;
+    }
+
     void World::invalidateAllChunks()
     {
+        physx::PxSceneWriteLock scene_lock(*m_scene);
         for (auto & chunk : m_chunk_pool)
         {
-            m_chunk_pool.deactivateChunk(&chunk);
+            m_chunk_pool.deactivateChunk(chunk.getHandle());
         }
+        m_chunk_pool.clearCache();
+        m_skipped_chunks.clear();
+        m_edited_chunks.clear();
+        m_prefetch_queue = {};
+        m_prefetched_chunks.clear();
+        m_prefetch_target = glm::ivec3(INT_MAX); // Replanned for the new terrain
+        m_log_generation_time = true;
     }
     
-    void World::bindNeighborChunks(int unsigned starting_index, uint8_t neighbor_mask, glm::ivec3 const & chunk_coordinate)
+    void World::generateChunks()
+    {
+        collectVisibleColumns(m_last_chunk_coords, m_render_distance, m_visible_columns);
+        generateChunks(m_visible_columns, m_render_distance);
+    }
+
+    void World::generateChunks(std::span<glm::ivec2 const> visible_columns, int render_distance)
     {
-        std::vector<Chunk>::iterator neighbor{};
-        for (uint8_t i = 1; i <= 7; ++i)
+        ENG_PROFILE_SCOPE("World::generateChunks");
+        ++m_chunk_epoch;
+        // Park chunks out of render distance, they're restored from the pool's cache if the player comes back
+        int const unload_distance = render_distance + UNLOAD_HYSTERESIS;
         {
-            if ((neighbor_mask & i) == i) //0bxzy
+            physx::PxSceneWriteLock scene_lock(*m_scene);
+            for (auto & chunk : m_chunk_pool)
             {
-                m_chunk_pool.getChunkAt(chunk_coordinate - glm::ivec3{ (i & 0b001) == 0b001, (i & 0b100) == 0b100, (i & 0b010) == 0b010 }, neighbor);
-                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, starting_index + (i - 1), neighbor->getDensityDistributionBuffer());
+                if (!chunk.isActive()) continue;
+                glm::ivec3 const offset = glm::abs(chunk.getPosition() - m_last_chunk_coords);
+                if (std::max({ offset.x, offset.y, offset.z }) > unload_distance)
+                {
+                    m_chunk_pool.parkChunk(chunk.getHandle());
+                }
             }
+            // Slabs emptied by the move are released only while the pool is larger than the render distance needs
+            m_chunk_pool.trim();
         }
-    }
+        std::erase_if(m_skipped_chunks, [&](glm::ivec3 const & position)
+        {
+            glm::ivec3 const offset = glm::abs(position - m_last_chunk_coords);
+            return std::max({ offset.x, offset.y, offset.z }) > unload_distance;
+        });
 
-    void World::generateChunks()
-    {
-        // Deactivate chunks out of render distance
-        for (auto & chunk : m_chunk_pool)
+        std::vector<glm::ivec2> surface_ranges;
+        estimateSurfaceRanges(visible_columns, surface_ranges);
+        // Classify the chunks in range that aren't loaded yet, the ones without a surface aren't generated either
+        std::vector<glm::ivec3> missing_chunks;
+        m_visible_chunk_count = 0;
+        for (size_t column = 0; column < visible_columns.size(); ++column)
         {
-            if (!chunk.isActive()) continue;
-            if (std::abs(chunk.getPosition().x - m_last_chunk_coords.x) > m_render_distance || std::abs(chunk.getPosition().z - m_last_chunk_coords.z) > m_render_distance)
+            int const min_y = std::max(surface_ranges[column].x, m_last_chunk_coords.y - render_distance), max_y = std::min(surface_ranges[column].y, m_last_chunk_coords.y + render_distance);
+            for (int y = min_y; y <= max_y; ++y)
             {
-                m_chunk_pool.deactivateChunk(&chunk);
+                glm::ivec3 const chunk_coordinate(visible_columns[column].x, y, visible_columns[column].y);
+                ++m_visible_chunk_count;
+                if (m_chunk_pool.hasChunkAt(chunk_coordinate) || m_skipped_chunks.contains(chunk_coordinate)) continue;
+                missing_chunks.push_back(chunk_coordinate);
             }
         }
-        // Generate chunks in render distance if they're not active
-        glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_generation_config_u);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_triangulation_table_ss);
-        for (int x_i = -m_render_distance; x_i <= m_render_distance; ++x_i)
+        // Edits can reach past the surface range, like a cave dug below it, those chunks come back with the rest
+        if (!m_edited_chunks.empty())
+        {
+            std::unordered_set<glm::ivec3, ChunkPositionHash> const queued(missing_chunks.begin(), missing_chunks.end());
+            for (auto const & chunk_coordinate : m_edited_chunks)
+            {
+                glm::ivec3 const offset = glm::abs(chunk_coordinate - m_last_chunk_coords);
+                if (std::max({ offset.x, offset.y, offset.z }) > render_distance || m_chunk_pool.hasChunkAt(chunk_coordinate) || queued.contains(chunk_coordinate)) continue;
+                missing_chunks.push_back(chunk_coordinate);
+            }
+        }
+        // Parked chunks come back as they were unloaded, only the rest is classified and generated
+        std::erase_if(m_prefetched_chunks, [&](auto const & prefetched) { return !m_chunk_pool.getResidentChunkAt(prefetched.first); });
+        // Prefetched chunks were generated ahead of time rather than saved from being regenerated, they only count as
+        // prefetch hits
+        std::vector<Chunk *> restored_chunks;
+        size_t cache_restore_count = 0;
         {
-            for (int z_i = -m_render_distance; z_i <= m_render_distance; ++z_i)
+            physx::PxSceneWriteLock scene_lock(*m_scene);
+            std::erase_if(missing_chunks, [&](glm::ivec3 const & chunk_coordinate)
             {
-                for (int y_i = 0; y_i < 2; ++y_i)
+                auto const prefetched = m_prefetched_chunks.find(chunk_coordinate);
+                bool const is_prefetched = prefetched != m_prefetched_chunks.end();
+                Chunk * chunk = m_chunk_pool.get(m_chunk_pool.restoreChunk(chunk_coordinate, m_chunk_size_in_units, is_prefetched));
+                if (!chunk) return false;
+                restored_chunks.push_back(chunk);
+                if (is_prefetched)
                 {
-                    glm::ivec3 chunk_coordinate{ x_i + m_last_chunk_coords.x, y_i, z_i + m_last_chunk_coords.z };
-                    uint8_t has_neighbors = (x_i != -m_render_distance) | ((z_i != -m_render_distance) << 1) | ((y_i == 1) << 2);
-                    if (!m_chunk_pool.hasChunkAt(chunk_coordinate)) // If no chunk exists, create one
-                    {
-                        Chunk * chunk = nullptr;
-                        if (!m_chunk_pool.activateChunk(chunk, chunk_coordinate, m_chunk_size_in_units))
-                        {
-                            ENG_LOG_F("Couldn't create chunk at (%d, %d, %d)!", chunk_coordinate.x, chunk_coordinate.y, chunk_coordinate.z);
-                            continue;
-                        }
-                        generateDensityDistribution(*chunk);
-                        generateMesh(*chunk, has_neighbors);
-                    }
+                    // Its generation may still be running on the GPU
+                    m_visible_generation_ticket = std::max(m_visible_generation_ticket, prefetched->second);
+                    ++m_prefetch_hit_count;
+                    m_prefetched_chunks.erase(prefetched);
                 }
-            }
+                else ++cache_restore_count;
+                return true;
+            });
         }
+        // The edits of the ones evicted from the cache are gone, they're generated afresh
+        for (auto const & chunk_coordinate : missing_chunks) m_edited_chunks.erase(chunk_coordinate);
+        m_restored_chunk_count += cache_restore_count;
+        m_generation_ms_saved += static_cast<float>(cache_restore_count) * m_generation_ms_per_chunk;
+        classifyMissingChunks(missing_chunks, &m_skipped_chunks);
+
+        std::vector<Chunk *> new_chunks;
+        uint64_t const ticket = generateNewChunks(missing_chunks, restored_chunks, false, new_chunks);
+        if (!new_chunks.empty()) m_visible_generation_ticket = ticket;
         if (!m_spectating)
         {
-            // Setup colliders
-            r_game_system.getGpuSynchronizer().setBarrier([this]
+            // Colliders of the chunks around the player, cooked once their meshes are done
+            std::vector<ChunkHandle> collider_chunks;
+            for (auto const & chunk : m_chunk_pool)
+            {
+                if (!chunk.isActive() || !chunk.needsCollider()) continue;
+                glm::ivec3 const offset = glm::abs(chunk.getPosition() - m_last_chunk_coords);
+                if (std::max({ offset.x, offset.y, offset.z }) <= 1) collider_chunks.push_back(chunk.getHandle());
+            }
+            r_game_system.getGpuSynchronizer().setBarrier([this, epoch = m_chunk_epoch, collider_chunks = std::move(collider_chunks)]
             {
+                // The player moved on or the chunks were regenerated, the newer generation queued its own colliders
+                if (epoch != m_chunk_epoch)
+                {
+                    m_cancelled_chunk_jobs[COLLIDER_COOKING] += collider_chunks.size();
+                    return;
+                }
                 std::vector<int unsigned> mesh_info(6);
-                std::vector<float> mesh(maxChunkTriangles(m_chunk_pool.getBaseLodPointWidth()) * 18);
-                for (auto & chunk : m_chunk_pool)
+                std::vector<Chunk *> chunks;
+                std::vector<std::vector<float>> meshes;
+                for (ChunkHandle const handle : collider_chunks)
+                {
+                    // Unloaded since, its slot may hold another chunk whose mesh isn't done yet
+                    Chunk * chunk = m_chunk_pool.get(handle);
+                    if (!chunk || !chunk->needsCollider())
+                    {
+                        ++m_cancelled_chunk_jobs[COLLIDER_COOKING];
+                        continue;
+                    }
+                    glGetNamedBufferSubData(chunk->getDrawIndirectBuffer(), 0, sizeof(int unsigned) * 6, mesh_info.data());
+                    chunk->setMeshInfo(mesh_info[0]);
+                    // The draw count is exact, so only the emitted triangles are read back
+                    std::vector<float> & mesh = meshes.emplace_back(static_cast<size_t>(mesh_info[0]) * 6);
+                    glGetNamedBufferSubData(chunk->getMeshVB(), 0, mesh.size() * sizeof(float), mesh.data());
+                    chunks.push_back(chunk);
+                }
+
+                std::vector<physx::PxTriangleMesh *> triangle_meshes(chunks.size());
                 {
-                    glGetNamedBufferSubData(chunk.getDrawIndirectBuffer(), 0, sizeof(int unsigned) * 6, mesh_info.data());
-                    chunk.setMeshInfo(mesh_info[0]);
-                    if (std::abs(chunk.getPosition().x - m_last_chunk_coords.x) > 1 || std::abs(chunk.getPosition().z - m_last_chunk_coords.z) > 1) continue;
-                    glGetNamedBufferSubData(chunk.getMeshVB(), 0, maxChunkTriangles(m_chunk_pool.getBaseLodPointWidth()) * sizeof(float) * 18, mesh.data());
-                    chunk.setMeshCollider(mesh, m_chunk_collider_material, m_chunk_size_in_units);
+                    ENG_PROFILE_SCOPE("Collider cooking");
+                    r_game_system.getJobSystem().parallelFor(chunks.size(), [&](size_t i)
+                    {
+                        triangle_meshes[i] = chunks[i]->cookCollider(meshes[i]);
+                    });
                 }
+                physx::PxSceneWriteLock scene_lock(*m_scene);
+                for (size_t i = 0; i < chunks.size(); ++i) chunks[i]->setCollider(triangle_meshes[i], m_chunk_collider_material, m_chunk_size_in_units);
+                m_completed_chunk_jobs[COLLIDER_COOKING] += chunks.size();
+            });
+        }
+    }
+
+    void World::estimateSurfaceRanges(std::span<glm::ivec2 const> columns, std::vector<glm::ivec2> & out_ranges) const
+    {
+        // Chunks of a column below its surface range are solid and the ones above it air, so neither is generated
+        out_ranges.assign(columns.size(), glm::ivec2(0, 1)); // Two chunks above y = 0 without a config
+        if (!m_generation_config_valid) return;
+        ENG_PROFILE_SCOPE("Column surface ranges");
+        r_game_system.getJobSystem().parallelFor(columns.size(), [&](size_t i)
+        {
+            cpu::estimateSurfaceRange(m_generation_config, columns[i], m_threshold, out_ranges[i].x, out_ranges[i].y);
+        });
+    }
+
+    void World::classifyMissingChunks(std::vector<glm::ivec3> & chunks, std::unordered_set<glm::ivec3, ChunkPositionHash> * out_skipped)
+    {
+        if (!m_skip_uniform_chunks || !m_generation_config_valid || chunks.empty()) return;
+        ENG_PROFILE_SCOPE("Chunk classification");
+        std::vector<cpu::ChunkClass> chunk_classes(chunks.size());
+        r_game_system.getJobSystem().parallelFor(chunks.size(), [&](size_t i)
+        {
+            chunk_classes[i] = cpu::classifyChunk(m_generation_config, chunks[i], m_chunk_pool.getBaseLodPointWidth(), m_threshold);
+        });
+        // Compacted in place to keep the generation order
+        size_t surface_count = 0;
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            if (chunk_classes[i] == cpu::ChunkClass::SURFACE) chunks[surface_count++] = chunks[i];
+            else if (out_skipped) out_skipped->insert(chunks[i]);
+        }
+        chunks.resize(surface_count);
+    }
+
+    uint64_t World::generateNewChunks(std::span<glm::ivec3 const> coordinates, std::span<Chunk * const> restored_chunks, bool prefetch, std::vector<Chunk *> & out_chunks)
+    {
+        uint64_t const ticket = ++m_generation_ticket;
+        glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_generation_config_u);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_triangulation_table_ss);
+        bool const was_out_of_budget = m_chunk_pool.isOutOfBudget();
+        size_t failed_count = 0;
+        for (auto const & chunk_coordinate : coordinates)
+        {
+            ChunkHandle handle;
+            {
+                physx::PxSceneWriteLock scene_lock(*m_scene);
+                handle = m_chunk_pool.activateChunk(chunk_coordinate, m_chunk_size_in_units);
+            }
+            if (!handle.isValid())
+            {
+                ++failed_count;
+                continue;
+            }
+            out_chunks.push_back(m_chunk_pool.get(handle));
+        }
+        // Activation only fails for the budget, logged when the pool runs out rather than for every chunk after
+        if (failed_count && !was_out_of_budget) ENG_LOG_F("Couldn't create %zu of %zu chunks!", failed_count, coordinates.size());
+
+        // The timestamps are read once the barrier below passes, so measuring never stalls
+        auto const submit_start = std::chrono::steady_clock::now();
+        GLuint timestamps[2];
+        glCreateQueries(GL_TIMESTAMP, 2, timestamps);
+        glQueryCounter(timestamps[0], GL_TIMESTAMP);
+        if (m_batched_generation)
+        {
+            // A batch shares the density and material buffers of one slab
+            std::stable_sort(out_chunks.begin(), out_chunks.end(), [](Chunk const * a, Chunk const * b)
+            {
+                return a->getDensityDistributionBuffer().m_buffer < b->getDensityDistributionBuffer().m_buffer;
             });
+            for (size_t first = 0; first < out_chunks.size();)
+            {
+                size_t last = first + 1;
+                GLuint const slab_buffer = out_chunks[first]->getDensityDistributionBuffer().m_buffer;
+                while (last < out_chunks.size() && last - first < MAX_BATCH_SIZE && out_chunks[last]->getDensityDistributionBuffer().m_buffer == slab_buffer) ++last;
+                std::span<Chunk * const> const batch(out_chunks.data() + first, last - first);
+                generateDensityDistributions(batch);
+                generateMeshes(batch);
+                first = last;
+            }
+        }
+        else
+        {
+            for (Chunk * chunk : out_chunks)
+            {
+                generateDensityDistribution(*chunk);
+                generateMesh(*chunk);
+            }
         }
+        std::vector<glm::ivec3> stale_chunks;
+        for (Chunk * chunk : out_chunks) propagateApron(*chunk, true, stale_chunks);
+        for (Chunk * chunk : restored_chunks) propagateApron(*chunk, true, stale_chunks);
+        // The lower neighbours of an edit may have been unloaded and evicted since, their fresh aprons predate it
+        for (Chunk * chunk : out_chunks) pullEditedAprons(*chunk, stale_chunks);
+        if (!stale_chunks.empty())
+        {
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            for (auto const & chunk_coordinate : stale_chunks)
+            {
+                if (Chunk * stale_chunk = m_chunk_pool.getResidentChunkAt(chunk_coordinate)) generateMesh(*stale_chunk);
+            }
+        }
+        glQueryCounter(timestamps[1], GL_TIMESTAMP);
+        float const submit_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - submit_start).count();
+        r_game_system.getGpuSynchronizer().setBarrier([this, ticket, prefetch, timestamps, submit_ms, chunk_count = out_chunks.size(), skipped_count = m_skipped_chunks.size(), restored_count = restored_chunks.size(), log = m_log_generation_time && !prefetch]
+        {
+            m_completed_generation_ticket = std::max(m_completed_generation_ticket, ticket); // Fences aren't checked in order
+            GLuint64 begin_ns = 0, end_ns = 0;
+            glGetQueryObjectui64v(timestamps[0], GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjectui64v(timestamps[1], GL_QUERY_RESULT, &end_ns);
+            glDeleteQueries(2, timestamps);
+            if (chunk_count == 0) return;
+            float const generation_time_ms = static_cast<float>(end_ns - begin_ns) / 1e6f;
+            m_generation_ms_per_chunk = generation_time_ms / static_cast<float>(chunk_count);
+            if (prefetch) return;
+            m_generation_time_ms = generation_time_ms;
+            m_generated_chunk_count = chunk_count;
+            if (log) ENG_LOG_F("Generated %zu chunks%s in %.2f ms on the GPU, %.2f ms to submit, %zu of %zu visible skipped as uniform, %zu restored from the cache", chunk_count, m_batched_generation ? " batched" : "", m_generation_time_ms, submit_ms, skipped_count, m_visible_chunk_count, restored_count);
+        });
+        if (!prefetch) m_log_generation_time = false;
+        return ticket;
     }
 
     void World::update(float delta_time, Window const & window, FirstPersonCamera & camera)
     {
-        m_player.update(delta_time, window, camera, m_spectating);
-        camera.setPosition(m_player.getPosition());
-        onPlayerMoved(m_player.getPosition());
-        //if (!m_spectating && (glfwGetMouseButton(window.getWindowHandle(), GLFW_MOUSE_BUTTON_1) == GLFW_PRESS || glfwGetMouseButton(window.getWindowHandle(), GLFW_MOUSE_BUTTON_2) == GLFW_PRESS))
-        //{
-        //    castRay(camera); // This is literally still 10x faster than PhysX raycasts
-        //}
-        m_scene->simulate(delta_time);
-        m_scene->fetchResults(true);
+        ENG_PROFILE_SCOPE("World::update");
+        simulate(delta_time, makeSimulationInput(window, camera), m_inline_snapshot);
+        present(m_inline_snapshot, 1.0f, camera);
+        sculpt(window, camera);
+    }
+
+    SimulationInput World::makeSimulationInput(Window const & window, FirstPersonCamera const & camera) const
+    {
+        return { PlayerInput::fromWindow(window, camera), m_render_distance, m_spectating, window.isCursorVisible() };
+    }
+
+    void World::simulate(float delta_time, SimulationInput const & input, WorldSnapshot & out_snapshot)
+    {
+        ENG_PROFILE_SCOPE("World::simulate");
+        {
+            physx::PxSceneWriteLock scene_lock(*m_scene);
+            out_snapshot.m_previous_player_position = m_player.getPosition();
+            if (!input.m_paused)
+            {
+                ENG_PROFILE_SCOPE("PhysX simulate");
+                m_player.update(delta_time, input.m_player, input.m_flight);
+                auto simulate_start = std::chrono::steady_clock::now();
+                m_scene->simulate(delta_time);
+                m_scene->fetchResults(true);
+                float simulate_time_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - simulate_start).count();
+                m_simulate_time_ms.store(0.9f * m_simulate_time_ms.load(std::memory_order_relaxed) + 0.1f * simulate_time_ms, std::memory_order_relaxed);
+            }
+            out_snapshot.m_player_position = m_player.getPosition();
+        }
+        out_snapshot.m_player_velocity = !input.m_paused && delta_time > 0.0f ? (out_snapshot.m_player_position - out_snapshot.m_previous_player_position) / delta_time : glm::vec3(0.0f);
+
+        auto chunk_coords = static_cast<glm::ivec3>(glm::floor(out_snapshot.m_player_position / m_chunk_size_in_units));
+        if (chunk_coords != m_simulated_chunk || input.m_render_distance != m_simulated_render_distance)
+        {
+            m_simulated_chunk = chunk_coords;
+            m_simulated_render_distance = input.m_render_distance;
+            collectVisibleColumns(chunk_coords, input.m_render_distance, m_simulated_visible_columns);
+        }
+        // Every slot of the snapshot buffer has to hold a complete list, so it's copied even if unchanged
+        out_snapshot.m_player_chunk = m_simulated_chunk;
+        out_snapshot.m_render_distance = m_simulated_render_distance;
+        out_snapshot.m_visible_columns = m_simulated_visible_columns;
+    }
+
+    void World::present(WorldSnapshot const & snapshot, float interpolation, FirstPersonCamera & camera)
+    {
+        camera.setPosition(glm::mix(snapshot.m_previous_player_position, snapshot.m_player_position, interpolation));
+        planPrefetch(snapshot);
+        if (snapshot.m_player_chunk != m_last_chunk_coords)
+        {
+            m_last_chunk_coords = snapshot.m_player_chunk;
+            generateChunks(snapshot.m_visible_columns, snapshot.m_render_distance);
+        }
+        // Prefetching only fills the frames without regular generation
+        else generatePrefetchedChunks();
+        fitMeshes();
+        ++m_presented_frame_count;
+        if (m_visible_generation_ticket > m_completed_generation_ticket) ++m_frames_with_missing_chunks;
+    }
+
+    void World::planPrefetch(WorldSnapshot const & snapshot)
+    {
+        glm::vec3 const position = snapshot.m_player_position / m_chunk_size_in_units;
+        glm::vec3 const velocity = snapshot.m_player_velocity / m_chunk_size_in_units; // Chunks per second
+        float const speed = glm::length(velocity);
+        int const step_count = m_prefetch && speed >= PREFETCH_MIN_SPEED ? std::min(PREFETCH_MAX_STEPS, static_cast<int>(speed * PREFETCH_HORIZON)) : 0;
+        std::vector<glm::ivec3> steps;
+        for (int step = 1; step <= step_count; ++step)
+        {
+            glm::ivec3 const chunk = static_cast<glm::ivec3>(glm::floor(position + velocity * (static_cast<float>(step) / speed)));
+            if (chunk != (steps.empty() ? snapshot.m_player_chunk : steps.back())) steps.push_back(chunk);
+        }
+        glm::ivec3 const target = steps.empty() ? snapshot.m_player_chunk : steps.back();
+        if (target == m_prefetch_target) return;
+        m_prefetch_target = target;
+
+        ENG_PROFILE_SCOPE("Prefetch planning");
+        // Surface ranges of every column in render distance of a step, each computed once
+        int const render_distance = snapshot.m_render_distance;
+        std::vector<glm::ivec2> columns, step_columns;
+        std::unordered_map<glm::ivec3, size_t, ChunkPositionHash> column_indices;
+        for (auto const & step : steps)
+        {
+            collectVisibleColumns(step, render_distance, step_columns);
+            for (auto const & column : step_columns)
+            {
+                if (column_indices.emplace(glm::ivec3(column.x, 0, column.y), columns.size()).second) columns.push_back(column);
+            }
+        }
+        std::vector<glm::ivec2> surface_ranges;
+        estimateSurfaceRanges(columns, surface_ranges);
+
+        // Each step adds the surface chunks its render distance reaches beyond the player's
+        std::vector<PrefetchRequest> requests;
+        std::unordered_set<glm::ivec3, ChunkPositionHash> planned;
+        for (size_t step = 0; step < steps.size(); ++step)
+        {
+            collectVisibleColumns(steps[step], render_distance, step_columns);
+            for (auto const & column : step_columns)
+            {
+                glm::ivec2 const range = surface_ranges[column_indices.at(glm::ivec3(column.x, 0, column.y))];
+                int const min_y = std::max(range.x, steps[step].y - render_distance), max_y = std::min(range.y, steps[step].y + render_distance);
+                for (int y = min_y; y <= max_y; ++y)
+                {
+                    glm::ivec3 const chunk_coordinate(column.x, y, column.y);
+                    glm::ivec3 const offset = glm::abs(chunk_coordinate - snapshot.m_player_chunk);
+                    if (std::max({ offset.x, offset.y, offset.z }) <= render_distance) continue;
+                    if (planned.insert(chunk_coordinate).second) requests.push_back({ chunk_coordinate, static_cast<int>(step) });
+                }
+            }
+        }
+        // Requests of the old path the new one doesn't share are cancelled, the rest are queued again
+        while (!m_prefetch_queue.empty())
+        {
+            if (!planned.contains(m_prefetch_queue.top().m_position)) ++m_cancelled_chunk_jobs[PREFETCH];
+            m_prefetch_queue.pop();
+        }
+        for (auto const & request : requests) m_prefetch_queue.push(request);
+    }
+
+    void World::generatePrefetchedChunks()
+    {
+        if (m_prefetch_queue.empty()) return;
+        // Half the cache is left to the chunks unloaded behind the player, prefetched chunks are parked before them
+        // and would be the first to be evicted otherwise
+        size_t const cache_capacity = m_chunk_pool.getCacheBudget() / m_chunk_pool.getChunkBytes();
+        std::vector<glm::ivec3> chunks;
+        while (!m_prefetch_queue.empty() && chunks.size() < PREFETCH_CHUNKS_PER_FRAME && m_chunk_pool.getParkedCount() + chunks.size() < cache_capacity / 2)
+        {
+            glm::ivec3 const position = m_prefetch_queue.top().m_position;
+            m_prefetch_queue.pop();
+            if (m_chunk_pool.getResidentChunkAt(position) || m_skipped_chunks.contains(position)) continue;
+            chunks.push_back(position);
+        }
+        if (chunks.empty()) return;
+
+        ENG_PROFILE_SCOPE("Chunk prefetch");
+        classifyMissingChunks(chunks, nullptr); // Uniform ones are classified again once they're in range
+        std::vector<Chunk *> new_chunks;
+        uint64_t const ticket = generateNewChunks(chunks, {}, true, new_chunks);
+        m_completed_chunk_jobs[PREFETCH] += new_chunks.size();
+        physx::PxSceneWriteLock scene_lock(*m_scene);
+        for (Chunk const * chunk : new_chunks)
+        {
+            m_prefetched_chunks[chunk->getPosition()] = ticket;
+            m_chunk_pool.parkChunk(chunk->getHandle());
+        }
+    }
+
+    void World::fitMeshes()
+    {
+        if (m_unfitted_meshes.empty()) return;
+        r_game_system.getGpuSynchronizer().setBarrier([this, positions = std::vector<glm::ivec3>(m_unfitted_meshes.begin(), m_unfitted_meshes.end())]
+        {
+            ENG_PROFILE_SCOPE("Mesh fitting");
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT); // The counts and meshes are written by shaders
+            for (auto const & position : positions)
+            {
+                // Parked chunks are fitted too, a chunk regenerated since is read once its newer mesh is done
+                Chunk * chunk = m_chunk_pool.getResidentChunkAt(position);
+                if (!chunk) continue;
+                int unsigned vertex_count = 0;
+                glGetNamedBufferSubData(chunk->getDrawIndirectBuffer(), 0, sizeof(vertex_count), &vertex_count);
+                m_chunk_pool.fitMesh(*chunk, vertex_count);
+            }
+        });
+        m_unfitted_meshes.clear();
+    }
+
+    void World::sculpt(Window const & window, FirstPersonCamera const & camera)
+    {
+        if (!m_spectating && (window.isMouseButtonDown(GLFW_MOUSE_BUTTON_1) || window.isMouseButtonDown(GLFW_MOUSE_BUTTON_2)))
+        {
+            castRay(camera); // This is literally still 10x faster than PhysX raycasts
+        }
     }
 
     void World::render(FirstPersonCamera const & camera)
     {
+        ENG_PROFILE_SCOPE("World::render");
+        ENG_PROFILE_GPU_SCOPE("Chunk rendering");
+        FrameData const frame_data{ camera.getViewMatrix(), camera.getProjectionMatrix(), glm::vec4(camera.getPosition(), 1.0f) };
+        UploadAllocator & upload_allocator = r_game_system.getUploadAllocator();
+        UploadAllocator::Allocation allocation;
+        if (upload_allocator.allocate(sizeof(FrameData), upload_allocator.getUniformAlignment(), allocation))
+        {
+            std::memcpy(allocation.m_data, &frame_data, sizeof(FrameData));
+            glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, allocation.m_buffer, allocation.m_offset, sizeof(FrameData));
+        }
+        else
+        {
+            glNamedBufferSubData(m_frame_data_u, 0, sizeof(FrameData), &frame_data);
+            glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, m_frame_data_u);
+        }
+
         m_chunk_renderer->bind();
-        m_chunk_renderer->setUniformMatrix4f("u_view", camera.getViewMatrix());
-        m_chunk_renderer->setUniformMatrix4f("u_projection", camera.getProjectionMatrix());
-        m_chunk_renderer->setUniformVector3f("u_camera_position_W", camera.getPosition());
-        m_grass_texture->bind(0); 
-        m_dirt_texture->bind(1);
+        m_material_textures->bind(0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_PALETTE_BINDING, m_material_palette_u);
         glBindVertexArray(m_chunk_va);
         for (auto & chunk : m_chunk_pool)
         {
             if (!chunk.isActive()) continue;
-            m_chunk_renderer->setUniformMatrix4f("u_model", glm::scale(glm::mat4(1.0f), glm::vec3(m_chunk_size_in_units)) * glm::translate(glm::mat4(1.0f), static_cast<glm::vec3>(chunk.getPosition())));
+            m_chunk_renderer->setUniformMatrix4f(U_MODEL, glm::scale(glm::mat4(1.0f), glm::vec3(m_chunk_size_in_units)) * glm::translate(glm::mat4(1.0f), static_cast<glm::vec3>(chunk.getPosition())));
             VertexArray::bindVertexBuffer(m_chunk_va, chunk.getMeshVB(), VertexDataLayout::POSITION_NORMAL_3F);
+            glVertexArrayVertexBuffer(m_chunk_va, MATERIAL_VERTEX_BINDING, chunk.getMaterialVB(), 0, sizeof(uint32_t));
             glBindBuffer(GL_DRAW_INDIRECT_BUFFER, chunk.getDrawIndirectBuffer());
             glDrawArraysIndirect(GL_TRIANGLES, nullptr);
         }
@@ -461,9 +681,95 @@ namespace eng
         m_generation_spec = m_density_generator->getBlockUniformInfo();
     }
 
+    void World::updateMaterialPalette()
+    {
+        r_game_system.getUploadAllocator().upload(m_material_palette_u, 0, m_material_palette, sizeof(m_material_palette));
+    }
+
     void World::updateGenerationConfig(float const * buffer_data)
     {
-        glNamedBufferSubData(m_generation_config_u, 0, m_generation_spec.size() * sizeof(float), buffer_data);
+        r_game_system.getUploadAllocator().upload(m_generation_config_u, 0, buffer_data, m_generation_spec.size() * sizeof(float));
+        mirrorGenerationConfig(reinterpret_cast<char const *>(buffer_data));
+
+        auto octaves = std::find_if(m_generation_spec.begin(), m_generation_spec.end(), [](Shader::BlockVariable const & variable) { return variable.m_name == "u_octaves_3d"; });
+        if (octaves == m_generation_spec.end()) return;
+        int octaves_3d;
+        std::memcpy(&octaves_3d, reinterpret_cast<char const *>(buffer_data) + octaves->m_buffer_offset, sizeof(octaves_3d));
+        if (octaves_3d != m_specialized_octaves) specializeKernels(octaves_3d);
+    }
+
+    void World::mirrorGenerationConfig(char const * buffer_data)
+    {
+        // Every field has to be in the block, otherwise the CPU copy would classify chunks with defaults
+        size_t field_count = 0;
+        for (auto const & variable : m_generation_spec)
+        {
+            field_count += cpu::setGenerationConfigField(m_generation_config, variable.m_name, buffer_data + variable.m_buffer_offset);
+        }
+        m_generation_config_valid = field_count == cpu::GENERATION_CONFIG_FIELD_COUNT;
+    }
+
+    void World::specializeKernels(int octaves_3d)
+    {
+        Shader::Defines meshing_defines = makeKernelDefines(MARCHING_CUBES, m_work_group_sizes[MARCHING_CUBES]);
+        meshing_defines.emplace_back("POINTS_PER_AXIS", std::to_string(m_chunk_pool.getBaseLodPointWidth()) + "u");
+        m_specialized_marching_cubes = r_game_system.getAssetManager().getShader("res/shaders/marching_cubes.glsl", meshing_defines);
+        m_specialized_marching_cubes_count = r_game_system.getAssetManager().getShader("res/shaders/marching_cubes.glsl", withDefine(meshing_defines, "MARCHING_CUBES_COUNT"));
+
+        Shader::Defines defines = makeKernelDefines(DENSITY_GENERATION, m_work_group_sizes[DENSITY_GENERATION]);
+        defines.emplace_back("POINTS_PER_AXIS", std::to_string(m_chunk_pool.getBaseLodPointWidth()) + "u");
+        if (octaves_3d > 0 && octaves_3d <= MAX_SPECIALIZED_OCTAVES) defines.emplace_back("OCTAVES_3D", std::to_string(octaves_3d));
+        m_specialized_density_generator = r_game_system.getAssetManager().getShader("res/shaders/generate_points.glsl", defines);
+        m_specialized_batched_density_generator = r_game_system.getAssetManager().getShader("res/shaders/generate_points.glsl", withDefine(defines, "DENSITY_GENERATION_BATCHED"));
+        m_specialized_octaves = octaves_3d;
+    }
+
+    void World::setDensityLayout(DensityLayout layout)
+    {
+        if (layout == m_density_layout) return;
+        m_density_layout = layout;
+        loadComputeKernels();
+        invalidateAllChunks();
+        generateChunks();
+    }
+
+    void World::setTiledMeshing(bool tiled)
+    {
+        if (tiled == m_tiled_meshing) return;
+        m_tiled_meshing = tiled;
+        loadComputeKernels();
+        invalidateAllChunks();
+        generateChunks();
+    }
+
+    void World::setSkipUniformChunks(bool skip)
+    {
+        if (skip == m_skip_uniform_chunks) return;
+        m_skip_uniform_chunks = skip;
+        invalidateAllChunks();
+        generateChunks();
+    }
+
+    int World::validateMeshCompaction()
+    {
+        int unsigned const point_width = m_chunk_pool.getBaseLodPointWidth();
+        std::vector<float> density(getDensityStorageCount(m_density_layout, point_width)), linear_density;
+        std::vector<uint32_t> cell_triangle_offsets;
+        int unsigned draw_config[6];
+        int mismatches = 0;
+        for (auto const & chunk : m_chunk_pool)
+        {
+            if (!chunk.isActive()) continue;
+            glGetNamedBufferSubData(chunk.getDensityDistributionBuffer().m_buffer, chunk.getDensityDistributionBuffer().m_offset, density.size() * sizeof(float), density.data());
+            glGetNamedBufferSubData(chunk.getDrawIndirectBuffer(), 0, sizeof(draw_config), draw_config);
+            cpu::convertDensityLayout(density, point_width, m_density_layout, DensityLayout::LINEAR, linear_density);
+            cpu::countCellTriangles(linear_density, point_width, m_threshold, cell_triangle_offsets);
+            uint32_t const triangle_count = cpu::exclusiveScan(cell_triangle_offsets);
+            if (triangle_count == draw_config[5] && triangle_count * 3 == draw_config[0]) continue;
+            ENG_LOG_F("Chunk (%d, %d, %d) has %u triangles on the GPU, the reference scan counts %u", chunk.getPosition().x, chunk.getPosition().y, chunk.getPosition().z, draw_config[5], triangle_count);
+            ++mismatches;
+        }
+        return mismatches;
     }
 
     void World::setSpectating(bool spectating)
@@ -479,10 +785,55 @@ namespace eng
     void World::setRenderDistance(int unsigned render_distance)
     {
         m_render_distance = render_distance;
+        m_chunk_pool.setTargetCapacity(getTargetPoolCapacity());
     }
 
     std::vector<Shader::BlockVariable> const & World::getGenerationSpec() const
     {
         return m_generation_spec;
     }
+
+    void World::spawnStressBodies(int count)
+    {
+        physx::PxSceneWriteLock scene_lock(*m_scene);
+        glm::vec3 const origin = m_player.getPosition() + glm::vec3{ 0.0f, 4.0f, 0.0f };
+        int const row_length = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count) / 4.0f)));
+        float constexpr half_extent = 0.15f, spacing = 0.4f;
+        for (int i = 0; i < count; ++i)
+        {
+            int x = i % row_length, z = i / row_length % row_length, y = i / (row_length * row_length);
+            physx::PxVec3 position{ origin.x + (x - row_length / 2) * spacing, origin.y + y * spacing, origin.z + (z - row_length / 2) * spacing };
+            physx::PxRigidDynamic * body = physx::PxCreateDynamic(*r_game_system.getPhysx(), physx::PxTransform(position), physx::PxBoxGeometry(half_extent, half_extent, half_extent), *m_chunk_collider_material, 10.0f);
+            m_scene->addActor(*body);
+            m_stress_bodies.push_back(body);
+        }
+        ENG_LOG_F("Spawned %d dynamic bodies, %zu total", count, m_stress_bodies.size());
+    }
+
+    void World::clearStressBodies()
+    {
+        physx::PxSceneWriteLock scene_lock(*m_scene);
+        for (auto body : m_stress_bodies) body->release();
+        m_stress_bodies.clear();
+    }
+
+    size_t World::getStressBodyCount() const
+    {
+        return m_stress_bodies.size();
+    }
+
+    float World::getSimulateTime() const
+    {
+        return m_simulate_time_ms.load(std::memory_order_relaxed);
+    }
+
+    size_t World::getPresentedFrameCount() const
+    {
+        return m_presented_frame_count;
+    }
+
+    size_t World::getFramesWithMissingChunks() const
+    {
+        return m_frames_with_missing_chunks;
+    }
 }
\ No newline at end of file
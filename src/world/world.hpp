@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <climits>
 #include <memory>
+#include <queue>
 #include <span>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -17,14 +22,101 @@
 #include "graphics/vertex_array.hpp"
 #include "player.hpp"
 #include "world/chunk.hpp"
+#include "world/cpu_terrain.hpp"
+#include "world/density_layout.hpp"
+#include "world/terrain_material.hpp"
 
 namespace eng
 {
+    struct SimulationInput
+    {
+        PlayerInput m_player;
+        int m_render_distance{};
+        bool m_flight{}, m_paused{ true };
+    };
+
+    // Result of a simulation tick, immutable once published to the render thread
+    struct WorldSnapshot
+    {
+        glm::vec3 m_previous_player_position{}, m_player_position{};
+        glm::vec3 m_player_velocity{}; // Units per second over the tick, zero while paused
+        double m_time{}; // When the tick finished, rendering interpolates between the two positions over the following tick
+        glm::ivec3 m_player_chunk{};
+        int m_render_distance{};
+        std::vector<glm::ivec2> m_visible_columns; // (x, z) of the chunk columns in render distance, see collectVisibleColumns
+    };
+
     class World
     {
         friend class DebugControls;
     private:
-        int unsigned constexpr static WORK_GROUP_SIZE = 10, RAY_HIT_DATA_SIZE = 22;
+        int unsigned constexpr static RAY_HIT_DATA_SIZE = 22, APRON_COPY_GROUP_SIZE = 64;
+        int unsigned constexpr static SCAN_BLOCK_SIZE = 1024; // Cells per workgroup of the triangle count scan, see scan.glsl
+        size_t constexpr static MAX_BATCH_SIZE = 64; // Chunks generated per batched dispatch
+        // Target pool capacity per column in render distance. Only the chunks around the surface are loaded, so the
+        // pool grows with the area in render distance rather than the volume.
+        size_t constexpr static POOL_CHUNKS_PER_COLUMN = 3;
+        // Chunks stay loaded this far past the render distance, so walking back and forth over a chunk boundary
+        // doesn't unload and reload the outer ring every time
+        int constexpr static UNLOAD_HYSTERESIS = 1;
+        // Chunks along the player's extrapolated path are generated ahead of time and parked in the pool's cache, so
+        // they're restored instead of generated once they come into render distance
+        float constexpr static PREFETCH_HORIZON = 1.5f; // Seconds of movement extrapolated
+        float constexpr static PREFETCH_MIN_SPEED = 1.0f; // Chunks per second, slower movement keeps up without prefetching
+        int constexpr static PREFETCH_MAX_STEPS = 4; // Chunks along the path whose render distance is prefetched
+        size_t constexpr static PREFETCH_CHUNKS_PER_FRAME = 16;
+        GLuint constexpr static CHUNK_BATCH_BINDING = 7;
+        GLuint constexpr static MATERIAL_ATTRIBUTE = 2, MATERIAL_VERTEX_BINDING = 1;
+        GLuint constexpr static FRAME_DATA_BINDING = 1, MATERIAL_PALETTE_BINDING = 2;
+        int constexpr static MAX_SPECIALIZED_OCTAVES = 16;
+
+        // The 3D compute passes, each compiled with its own cubic WORK_GROUP_SIZE picked by autotuneWorkGroupSizes
+        enum ComputeKernel : uint8_t
+        {
+            DENSITY_GENERATION,
+            MARCHING_CUBES, // Count and write pass
+            TERRAFORM,
+            COMPUTE_KERNEL_COUNT
+        };
+        inline static char const * const COMPUTE_KERNEL_NAMES[COMPUTE_KERNEL_COUNT] = { "density_generation", "marching_cubes", "terraform" };
+
+        // Deferred chunk work that may outlive the chunks it was queued for, counted per chunk and outcome
+        enum ChunkJob : uint8_t
+        {
+            COLLIDER_COOKING, // Cancelled once the chunk's handle is stale or a newer generation queued its own
+            PREFETCH, // Cancelled when the predicted path changes
+            TERRAFORM_EDIT, // Per ray hit, cancelled if the hit chunk was unloaded or regenerated meanwhile
+            CHUNK_JOB_COUNT
+        };
+        inline static char const * const CHUNK_JOB_NAMES[CHUNK_JOB_COUNT] = { "Collider cooking", "Prefetch", "Terraform edit" };
+
+        // Everything one run of the marching cubes passes reads and writes, a chunk's buffers plus its slice of the scratch
+        struct MeshingBuffers
+        {
+            BufferRange m_density, m_materials;
+            GLuint m_mesh, m_vertex_materials, m_draw_indirect;
+            BufferRange m_cell_triangle_offsets, m_block_triangle_offsets;
+        };
+
+        // std140 layout of the FrameData block in chunk.glsl
+        struct FrameData
+        {
+            glm::mat4 m_view, m_projection;
+            glm::vec4 m_camera_position_W;
+        };
+
+        // std140 layout of a PaletteEntry in terrain_material.glsl
+        struct MaterialPaletteEntry
+        {
+            uint32_t m_top_layer, m_side_layer;
+            float m_hardness, m_padding;
+        };
+
+        UniformId inline static const U_MODEL{ "u_model" }, U_POINTS_PER_AXIS{ "u_points_per_axis" }, U_POSITION_OFFSET{ "u_position_offset" };
+        UniformId inline static const U_THRESHOLD{ "u_threshold" }, U_STRENGTH{ "u_strength" }, U_RADIUS{ "u_radius" }, U_CURRENT_CHUNK{ "u_current_chunk" };
+        UniformId inline static const U_TRANSFORM{ "u_transform" }, U_CHUNK_COORDINATE{ "u_chunk_coordinate" }, U_RAY_ORIGIN{ "u_ray_origin" }, U_RAY_DIRECTION{ "u_ray_direction" };
+        UniformId inline static const U_BRUSH_MATERIAL{ "u_brush_material" }, U_DIRECTION_MASK{ "u_direction_mask" }, U_VALUE_COUNT{ "u_value_count" };
+        UniformId inline static const U_DENSITY_STRIDE{ "u_density_stride" }, U_MATERIAL_STRIDE{ "u_material_stride" };
     public:
         int unsigned constexpr static INITIAL_INDIRECT_DRAW_CONFIG[] = {0, 1, 0, 0, 0, 0};
     public:
@@ -36,25 +128,69 @@ namespace eng
         GameSystem & r_game_system;
 
         std::shared_ptr<Shader> m_density_generator;
+        std::shared_ptr<Shader> m_batched_density_generator; // Generates several chunks of the pool in one dispatch
         std::shared_ptr<Shader> m_marching_cubes;
+        std::shared_ptr<Shader> m_marching_cubes_count;
+        std::shared_ptr<Shader> m_scan_triangle_counts;
+        std::shared_ptr<Shader> m_scan_block_totals;
         std::shared_ptr<Shader> m_chunk_renderer;
         std::shared_ptr<Shader> m_mesh_ray_intersect;
         std::shared_ptr<Shader> m_ray_mesh_command;
         std::shared_ptr<Shader> m_terraform;
+        std::shared_ptr<Shader> m_apron_copy;
         std::shared_ptr<Shader> m_tesselated_chunk;
+        // Permutations with the point width and octave count compiled in, the generic ones above stay around for
+        // comparison and to query the generation config block from
+        std::shared_ptr<Shader> m_specialized_density_generator;
+        std::shared_ptr<Shader> m_specialized_batched_density_generator;
+        std::shared_ptr<Shader> m_specialized_marching_cubes;
+        std::shared_ptr<Shader> m_specialized_marching_cubes_count;
+        int m_specialized_octaves{ -1 };
+        bool m_specialized_kernels{ true };
+        bool m_tiled_meshing{ true }; // Marching cubes stages each workgroup's densities in shared memory
+        bool m_batched_generation{ true }; // New chunks are generated MAX_BATCH_SIZE at a time with a barrier per stage
+        DensityLayout m_density_layout{ DensityLayout::LINEAR };
+        int unsigned m_work_group_sizes[COMPUTE_KERNEL_COUNT]{ 10, 10, 10 };
+        float m_work_group_times_ms[COMPUTE_KERNEL_COUNT]{}; // Of the chosen sizes, 0 if they were loaded without timing
         GLuint m_triangulation_table_ss;
         GLuint m_generation_config_u;
+        GLuint m_frame_data_u; // Only used when the upload ring is full
         GLuint m_ray_hit_data_ss;
         GLuint m_chunk_va;
         GLuint m_dispatch_indirect_buffer;
+        // Scratch of the compacting marching cubes passes, a slice per chunk of a batch
+        GLuint m_cell_triangle_offsets_ss, m_block_triangle_offsets_ss;
+        GLsizeiptr m_cell_triangle_offsets_stride, m_block_triangle_offsets_stride;
+        GLuint m_chunk_batch_ss; // Position and slot of each chunk in a batched density dispatch
+
+        // Of the last generateChunks that created any, logged as well after invalidateAllChunks
+        float m_generation_time_ms{};
+        size_t m_generated_chunk_count{};
+        bool m_log_generation_time{};
+        // Chunks restored from the pool's cache instead of regenerated, the saved time is estimated from the
+        // per-chunk GPU time of the last generation
+        size_t m_restored_chunk_count{};
+        float m_generation_ms_per_chunk{}, m_generation_ms_saved{};
+
+        // CPU copy of the generation config block for classifyChunk, only valid once the block has a variable for
+        // every cpu::GenerationConfig field. Until then every chunk is treated as a surface chunk.
+        cpu::GenerationConfig m_generation_config;
+        bool m_generation_config_valid{};
+        bool m_skip_uniform_chunks{ true }; // Chunks proven empty or solid take no pool slot and are never meshed
+        std::unordered_set<glm::ivec3, ChunkPositionHash> m_skipped_chunks; // In the surface range but classified uniform, materialized when terraformed
+        std::unordered_set<glm::ivec3, ChunkPositionHash> m_unfitted_meshes; // Meshed with worst case storage this frame
+        std::unordered_set<glm::ivec3, ChunkPositionHash> m_edited_chunks; // Terraformed and still loaded or parked, restored in render distance even outside the surface range
+        size_t m_visible_chunk_count{};
 
         float * m_hit_info_ptr;
 
         ChunkPool m_chunk_pool;
         glm::ivec3 m_last_chunk_coords{};
         physx::PxMaterial * m_chunk_collider_material;
-        std::shared_ptr<Texture> m_grass_texture;
-        std::shared_ptr<Texture> m_dirt_texture;
+        std::shared_ptr<Texture> m_material_textures; // Array with the TerrainMaterial layers
+        MaterialPaletteEntry m_material_palette[TerrainMaterial::COUNT];
+        GLuint m_material_palette_u;
+        TerrainMaterial::Id m_brush_material{ TerrainMaterial::DIRT };
 
         physx::PxScene * m_scene;
 
@@ -64,36 +200,156 @@ namespace eng
 
         std::vector<Shader::BlockVariable> m_generation_spec;
 
+        std::vector<physx::PxRigidDynamic *> m_stress_bodies;
+        std::atomic<float> m_simulate_time_ms{};
+
+        std::vector<glm::ivec2> m_visible_columns;
+        WorldSnapshot m_inline_snapshot;
+
+        struct PrefetchRequest
+        {
+            glm::ivec3 m_position;
+            int m_step; // Along the predicted path, the earlier ones come into range first
+
+            bool operator<(PrefetchRequest const & other) const { return m_step > other.m_step; } // Lowest step on top
+        };
+        bool m_prefetch{ true };
+        glm::ivec3 m_prefetch_target{ INT_MAX }; // Predicted chunk the queue was planned for
+        std::priority_queue<PrefetchRequest> m_prefetch_queue;
+        std::unordered_map<glm::ivec3, uint64_t, ChunkPositionHash> m_prefetched_chunks; // Parked by the prefetcher, to their generation ticket
+        size_t m_prefetch_hit_count{};
+        // Every generation gets the next ticket, the completed one is the highest whose GPU work has finished. Frames
+        // presented while a ticket with chunks in render distance is pending show holes.
+        uint64_t m_generation_ticket{}, m_completed_generation_ticket{}, m_visible_generation_ticket{};
+        size_t m_presented_frame_count{}, m_frames_with_missing_chunks{};
+        // Bumped by every generateChunks, deferred work tagged with an older epoch was superseded by newer work
+        uint32_t m_chunk_epoch{};
+        size_t m_completed_chunk_jobs[CHUNK_JOB_COUNT]{}, m_cancelled_chunk_jobs[CHUNK_JOB_COUNT]{};
+
+        // Only touched by the thread running simulate
+        glm::ivec3 m_simulated_chunk{ INT_MAX };
+        int m_simulated_render_distance{};
+        std::vector<glm::ivec2> m_simulated_visible_columns;
+
+        // TerrainMaterial ids and selection constants for the terrain shaders
+        static Shader::Defines makeMaterialDefines();
+        // Material defines plus the density layout, for the kernels that index density storage
+        Shader::Defines makeComputeDefines() const;
+        // Compute defines plus the kernel's work group size and, for marching cubes, the tiling variant
+        Shader::Defines makeKernelDefines(ComputeKernel kernel, int unsigned work_group_size) const;
+        static Shader::Defines withDefine(Shader::Defines defines, char const * name);
+        // (Re)fetches every compute permutation for the current layout, tiling, work group sizes and octave count
+        void loadComputeKernels();
+
     public:
         World(GameSystem & game_system);
         ~World();
 
         void debugRecompile();
-        void onPlayerMoved(glm::vec3 const & position);
+
+        // Columns in render distance of center, ordered so that the lower x and z neighbours of a column precede it
+        static void collectVisibleColumns(glm::ivec3 const & center, int render_distance, std::vector<glm::ivec2> & out_columns);
+        // Chunks the pool shrinks back to, see POOL_CHUNKS_PER_COLUMN
+        size_t getTargetPoolCapacity() const;
 
         void invalidateAllChunks();
-        void bindNeighborChunks(int unsigned starting_index, uint8_t neighbor_mask, glm::ivec3 const & chunk_coordinate);
         void generateChunks();
+        // Loads the chunks of each column that may hold the surface and are within render_distance of the player
+        // vertically, bottom to top so that lower neighbours are generated first
+        void generateChunks(std::span<glm::ivec2 const> visible_columns, int render_distance);
+        void estimateSurfaceRanges(std::span<glm::ivec2 const> columns, std::vector<glm::ivec2> & out_ranges) const;
+        // Drops the chunks classified as uniform, appending them to out_skipped if given
+        void classifyMissingChunks(std::vector<glm::ivec3> & chunks, std::unordered_set<glm::ivec3, ChunkPositionHash> * out_skipped);
+        // Activates and generates the chunks at coordinates and propagates their aprons along with the restored ones.
+        // Returns the generation ticket, prefetched generations don't count as the last generation.
+        uint64_t generateNewChunks(std::span<glm::ivec3 const> coordinates, std::span<Chunk * const> restored_chunks, bool prefetch, std::vector<Chunk *> & out_chunks);
+        // Replans the prefetch queue when the predicted chunk changes, cancelling the requests the new path drops
+        void planPrefetch(WorldSnapshot const & snapshot);
+        void generatePrefetchedChunks();
+        // Shrinks the mesh buffers of the chunks meshed this frame to their triangle counts once the GPU is done
+        void fitMeshes();
 
+        // Runs update on a single thread. The threaded path calls simulate on the simulation thread and present and
+        // sculpt on the render thread instead, PhysX scene access is guarded by the scene lock.
         void update(float delta_time, Window const & window, FirstPersonCamera & camera);
+        SimulationInput makeSimulationInput(Window const & window, FirstPersonCamera const & camera) const;
+        void simulate(float delta_time, SimulationInput const & input, WorldSnapshot & out_snapshot);
+        void present(WorldSnapshot const & snapshot, float interpolation, FirstPersonCamera & camera);
+        void sculpt(Window const & window, FirstPersonCamera const & camera);
         void render(FirstPersonCamera const & camera);
         
         void refreshGenerationSpec();
+        // Call after changing m_material_palette
+        void updateMaterialPalette();
         void updateGenerationConfig(float const * buffer_data);
+        void mirrorGenerationConfig(char const * buffer_data);
+        // Octave counts outside of 1..MAX_SPECIALIZED_OCTAVES are read from the generation config block instead
+        void specializeKernels(int octaves_3d);
+        // Switches the kernels to the other permutation and regenerates every chunk
+        void setDensityLayout(DensityLayout layout);
+        void setTiledMeshing(bool tiled);
+        void setSkipUniformChunks(bool skip);
+        // Reads back every chunk's density and compares the GPU triangle counts with cpu::countCellTriangles, returns the mismatches
+        int validateMeshCompaction();
 
         void setSpectating(bool spectating);
         void setRenderDistance(int unsigned render_distance);
 
         std::vector<Shader::BlockVariable> const & getGenerationSpec() const;
 
+        // Drops a grid of dynamic boxes above the player to measure how simulate scales with the worker count
+        void spawnStressBodies(int count);
+        void clearStressBodies();
+        size_t getStressBodyCount() const;
+        float getSimulateTime() const;
+        size_t getPresentedFrameCount() const;
+        size_t getFramesWithMissingChunks() const;
+
         // world_mesh.cpp
-        int unsigned getComputeResolution(int unsigned point_width);
+        // Work groups per axis, marching cubes covers the cells and terraforming the owned points, so one less
+        int unsigned getComputeResolution(ComputeKernel kernel, int unsigned point_width, int unsigned work_group_size) const;
+        int unsigned getComputeResolution(ComputeKernel kernel, int unsigned point_width) const;
         void castRay(FirstPersonCamera const & camera);
         void chunkRayIntersection(glm::ivec3 const & chunk_coordinate, glm::vec3 const & origin, glm::vec3 const & direction);
 
+        // The generic kernels stand in while the specialized ones are still linking in the background
+        bool useSpecializedKernels() const;
         void generateDensityDistribution(Chunk const & chunk);
-        void generateMesh(Chunk const & chunk, uint8_t has_neighbors);
-        void terraform(glm::ivec3 const & chunk_coordinate);
+        void dispatchDensityGeneration(Shader & kernel, BufferRange const & density, BufferRange const & materials, glm::vec3 const & chunk_position, int unsigned point_width);
+        // Up to MAX_BATCH_SIZE chunks of one pool slab in a single dispatch, the chunks are stacked along z
+        void generateDensityDistributions(std::span<Chunk * const> chunks);
+        void generateMesh(Chunk & chunk);
+        // Up to MAX_BATCH_SIZE chunks, each pass is dispatched for all of them before a single barrier
+        void generateMeshes(std::span<Chunk * const> chunks);
+        MeshingBuffers getMeshingBuffers(Chunk const & chunk, size_t batch_index) const;
+        void dispatchMarchingCubes(std::span<MeshingBuffers const> batch, int unsigned point_width, Shader & count_kernel, Shader & write_kernel);
+        // Times the marching cubes passes with and without tiling at point widths 16, 32 and 64 on scratch buffers
+        // and logs the average dispatch times, independent of the chunk pool's point width
+        void benchmarkMeshing(int iterations);
+        // Chunk sized buffers outside the pool for benchmarks and tuning
+        MeshingBuffers createScratchBuffers(int unsigned point_width);
+        void deleteScratchBuffers(MeshingBuffers const & buffers);
+        // Only writes the points the chunk owns, false if it isn't loaded
+        bool terraform(glm::ivec3 const & chunk_coordinate);
+        // Generates an unloaded chunk in render distance so it can be edited, with the aprons of its loaded upper
+        // neighbours. Chunks outside the surface range or skipped as uniform are kept in m_edited_chunks once they're
+        // terraformed, so they're restored with the rest when the player comes back. False if it was already loaded, is out of render distance or the pool is full.
+        bool materializeChunk(glm::ivec3 const & chunk_coordinate);
+        void dispatchTerraform(Shader & kernel, BufferRange const & density, BufferRange const & materials, glm::vec3 const & chunk_coordinate, int unsigned point_width);
+        // direction_mask has a bit per axis (x, y, z) along which destination is the lower neighbour of source
+        void copyApron(Chunk const & source, Chunk const & destination, uint32_t direction_mask);
+        // Copies the lower faces of source into the aprons of its loaded lower neighbours and appends the ones that
+        // need a new mesh. Generation passes only_edited_aprons, untouched aprons already match generated terrain.
+        void propagateApron(Chunk const & source, bool only_edited_aprons, std::vector<glm::ivec3> & out_stale_chunks);
+        // Copies the faces of edited upper neighbours, loaded or parked, into a freshly generated chunk's apron and
+        // adds it to out_stale_chunks if there were any
+        void pullEditedAprons(Chunk & destination, std::vector<glm::ivec3> & out_stale_chunks);
 
+        // world_tuning.cpp
+        // Times every candidate work group size of each compute pass on scratch buffers and keeps the fastest. The
+        // choice is stored per driver and point width, so later runs only load it unless force is set.
+        void autotuneWorkGroupSizes(bool force);
+        // Fraction of the launched invocations that return right away because they're past the chunk
+        float getIdleInvocationFraction(ComputeKernel kernel, int unsigned work_group_size) const;
     };
 }
\ No newline at end of file
@@ -1,12 +1,32 @@
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include "profiler.hpp"
+
 #include "world.hpp"
 
 namespace eng
 {
-    int unsigned World::getComputeResolution(int unsigned point_width)
+    int unsigned World::getComputeResolution(ComputeKernel kernel, int unsigned point_width, int unsigned work_group_size) const
     {
-        return static_cast<int unsigned>(std::ceilf(static_cast<float>(point_width) / WORK_GROUP_SIZE));
+        int unsigned const invocations_per_axis = kernel == DENSITY_GENERATION ? point_width : point_width - 1;
+        return (invocations_per_axis + work_group_size - 1) / work_group_size;
     }
 
+    int unsigned World::getComputeResolution(ComputeKernel kernel, int unsigned point_width) const
+    {
+        return getComputeResolution(kernel, point_width, m_work_group_sizes[kernel]);
+    }
+
+    // GPU profiler scopes per [bricked][specialized](+[tiled]) permutation, so every variant gets its own track
+    char const constexpr * DENSITY_GENERATION_SCOPES[2][2] = { { "Density generation", "Density generation (specialized)" }, { "Density generation (bricked)", "Density generation (specialized, bricked)" } };
+    char const constexpr * MARCHING_CUBES_SCOPES[2][2][2] =
+    {
+        { { "Marching cubes", "Marching cubes (tiled)" }, { "Marching cubes (specialized)", "Marching cubes (specialized, tiled)" } },
+        { { "Marching cubes (bricked)", "Marching cubes (bricked, tiled)" }, { "Marching cubes (specialized, bricked)", "Marching cubes (specialized, bricked, tiled)" } }
+    };
+
     int constexpr sign(float x)
     {
         return (x > 0) - (x < 0);
@@ -49,11 +69,14 @@ namespace eng
         if (dz > 0) t_max_z = t_delta_z * (1 - adjusted_position_z + std::floorf(adjusted_position_z)); else t_max_z = t_delta_z * (adjusted_position_z - std::floorf(adjusted_position_z));
         int z = m_last_chunk_coords.z;
 
-        for (int i = 0; i < RAY_HIT_DATA_SIZE; ++i) m_hit_info_ptr[i] = 0; // Reset hit info
+        float constexpr empty_hit_info[RAY_HIT_DATA_SIZE]{};
+        r_game_system.getUploadAllocator().upload(m_ray_hit_data_ss, 0, empty_hit_info, sizeof(empty_hit_info)); // Reset hit info
         int const raycast_reach = 1;
+        std::vector<ChunkHandle> tested_chunks; // A hit in any other chunk than these is stale
         // Don't bother reading back hit info and stopping on hit, it's faster to just check every possibility
-        while (std::abs(x - m_last_chunk_coords.x) <= raycast_reach && std::abs(z - m_last_chunk_coords.z) <= raycast_reach && y >= 0 && y < 2)
+        while (std::abs(x - m_last_chunk_coords.x) <= raycast_reach && std::abs(y - m_last_chunk_coords.y) <= raycast_reach && std::abs(z - m_last_chunk_coords.z) <= raycast_reach)
         {
+            if (ChunkHandle const handle = m_chunk_pool.findChunk(glm::ivec3{ x, y, z }); handle.isValid()) tested_chunks.push_back(handle);
             chunkRayIntersection(glm::ivec3{ x, y, z }, camera.getPosition(), camera.getDirection());
             if (t_max_x < t_max_y)
             {
@@ -82,30 +105,57 @@ namespace eng
                 }
             }
         }
-        r_game_system.getGpuSynchronizer().setBarrier([this, sphereCubeIntersect = sphereCubeIntersect] // Terraforming deferred to when raycast is finished
+        r_game_system.getGpuSynchronizer().setBarrier([this, sphereCubeIntersect = sphereCubeIntersect, tested_chunks = std::move(tested_chunks)] // Terraforming deferred to when raycast is finished
         {
             if (m_hit_info_ptr[18])
             {
+                // The hit chunk was unloaded or regenerated while the ray was in flight, the hit no longer matches the terrain
+                ChunkHandle const hit_chunk = m_chunk_pool.findChunk(glm::ivec3{ m_hit_info_ptr[19], m_hit_info_ptr[20], m_hit_info_ptr[21] });
+                if (std::find(tested_chunks.begin(), tested_chunks.end(), hit_chunk) == tested_chunks.end())
+                {
+                    ++m_cancelled_chunk_jobs[TERRAFORM_EDIT];
+                    return;
+                }
+                ++m_completed_chunk_jobs[TERRAFORM_EDIT];
                 glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_generation_config_u);
                 glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_triangulation_table_ss);
 
-                for (int i = 0; i < 18; ++i)
+                std::vector<glm::ivec3> edited_chunks;
+                for (int i = 0; i < 27; ++i)
                 {
-                    int x = i % 3 - 1, y = i / 9, z = i / 3 % 3 - 1;
+                    int x = i % 3 - 1, y = i / 9 - 1, z = i / 3 % 3 - 1;
                     if (sphereCubeIntersect({ x, y, z }, glm::ivec3{ x, y, z } + 1, { m_hit_info_ptr[0], m_hit_info_ptr[1], m_hit_info_ptr[2], m_terraform_radius /*/ m_points_per_axis + 0.1f */})) // Intersection test in unit space (terraforming not to be used like this in future)
                     {
-                        terraform({ m_hit_info_ptr[19] + x, m_hit_info_ptr[20] + y, m_hit_info_ptr[21] + z });
-                        // CHUNK (0, 0) DOES SOMETHING WEIRD
+                        glm::ivec3 chunk_coordinate{ m_hit_info_ptr[19] + x, m_hit_info_ptr[20] + y, m_hit_info_ptr[21] + z };
+                        materializeChunk(chunk_coordinate); // Nothing to do unless it's outside the surface or skipped as uniform
+                        if (!terraform(chunk_coordinate)) continue;
+                        edited_chunks.push_back(chunk_coordinate);
+                        m_edited_chunks.insert(chunk_coordinate);
                     }
                 }
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+                // Aprons are copied once every edit has landed, then each affected chunk is meshed once
+                std::vector<glm::ivec3> stale_chunks = edited_chunks;
+                for (auto const & chunk_coordinate : edited_chunks)
+                {
+                    if (Chunk * chunk = m_chunk_pool.getChunkAt(chunk_coordinate)) propagateApron(*chunk, false, stale_chunks);
+                }
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                for (auto const & chunk_coordinate : stale_chunks)
+                {
+                    if (Chunk * chunk = m_chunk_pool.getResidentChunkAt(chunk_coordinate)) generateMesh(*chunk);
+                }
+                glFlush();
             }
         });
     }
 
     void World::chunkRayIntersection(glm::ivec3 const & chunk_coordinate, glm::vec3 const & origin, glm::vec3 const & direction)
     {
-        std::vector<Chunk>::iterator current_chunk;
-        if (!m_chunk_pool.getChunkAt(chunk_coordinate, current_chunk)) return;
+        Chunk const * current_chunk = m_chunk_pool.getChunkAt(chunk_coordinate);
+        if (!current_chunk) return;
+        ENG_PROFILE_GPU_SCOPE("Ray mesh intersection");
         // Generate dispatch command based on amount of triangles in chunk
         m_ray_mesh_command->bind();
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_dispatch_indirect_buffer);
@@ -115,64 +165,352 @@ namespace eng
         glm::mat4 transform = glm::scale(glm::mat4(1.0f), glm::vec3(m_chunk_size_in_units)) * glm::translate(glm::mat4(1.0f), static_cast<glm::vec3>(current_chunk->getPosition()));
         // Setup raycast input/output
         m_mesh_ray_intersect->bind();
-        m_mesh_ray_intersect->setUniformMatrix4f("u_transform", transform);
-        m_mesh_ray_intersect->setUniformVector3f("u_chunk_coordinate", static_cast<glm::vec3>(current_chunk->getPosition()));
-        m_mesh_ray_intersect->setUniformVector3f("u_ray_origin", origin);
-        m_mesh_ray_intersect->setUniformVector3f("u_ray_direction", direction);
+        m_mesh_ray_intersect->setUniformMatrix4f(U_TRANSFORM, transform);
+        m_mesh_ray_intersect->setUniformVector3f(U_CHUNK_COORDINATE, static_cast<glm::vec3>(current_chunk->getPosition()));
+        m_mesh_ray_intersect->setUniformVector3f(U_RAY_ORIGIN, origin);
+        m_mesh_ray_intersect->setUniformVector3f(U_RAY_DIRECTION, direction);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, current_chunk->getMeshVB());
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_ray_hit_data_ss);
         glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_dispatch_indirect_buffer);
         glDispatchComputeIndirect(0);
     }
 
+    bool World::useSpecializedKernels() const
+    {
+        return m_specialized_kernels && m_specialized_density_generator->isReady() && m_specialized_batched_density_generator->isReady() && m_specialized_marching_cubes->isReady() && m_specialized_marching_cubes_count->isReady();
+    }
+
     void World::generateDensityDistribution(Chunk const & chunk)
     {
-        m_density_generator->bind();
-        m_density_generator->setUniformUInt("u_points_per_axis", m_chunk_pool.getBaseLodPointWidth());
-        m_density_generator->setUniformVector3f("u_position_offset", static_cast<glm::vec3>(chunk.getPosition()));
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, chunk.getDensityDistributionBuffer());
-        int unsigned resolution = getComputeResolution(m_chunk_pool.getBaseLodPointWidth());
+        bool const specialized = useSpecializedKernels();
+        ENG_PROFILE_GPU_SCOPE(DENSITY_GENERATION_SCOPES[m_density_layout == DensityLayout::BRICKED][specialized]);
+        Shader & density_generator = specialized ? *m_specialized_density_generator : *m_density_generator;
+        dispatchDensityGeneration(density_generator, chunk.getDensityDistributionBuffer(), chunk.getMaterialBuffer(), static_cast<glm::vec3>(chunk.getPosition()), m_chunk_pool.getBaseLodPointWidth());
+    }
+
+    void World::dispatchDensityGeneration(Shader & kernel, BufferRange const & density, BufferRange const & materials, glm::vec3 const & chunk_position, int unsigned point_width)
+    {
+        kernel.bind();
+        kernel.setUniformUInt(U_POINTS_PER_AXIS, point_width); // Inactive when specialized
+        kernel.setUniformVector3f(U_POSITION_OFFSET, chunk_position);
+        density.bindStorage(3);
+        glClearNamedBufferSubData(materials.m_buffer, GL_R32UI, materials.m_offset, materials.m_size, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr); // Ids are ORed in
+        materials.bindStorage(11);
+        int unsigned resolution = getComputeResolution(DENSITY_GENERATION, point_width);
         glDispatchCompute(resolution, resolution, resolution);
         glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
     }
 
-    void World::generateMesh(Chunk const & chunk, uint8_t has_neighbors)
+    void World::generateDensityDistributions(std::span<Chunk * const> chunks)
     {
-        m_marching_cubes->bind();
-        m_marching_cubes->setUniformFloat("u_threshold", m_threshold);
-        m_marching_cubes->setUniformUInt("u_points_per_axis", m_chunk_pool.getBaseLodPointWidth());
-        //m_marching_cubes->setUniformInt("u_has_neighbors", has_neighbors);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, chunk.getMeshVB());
-        glClearNamedBufferData(chunk.getMeshVB(), GL_R32F, GL_RED, GL_FLOAT, nullptr);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, chunk.getDrawIndirectBuffer());
-        glNamedBufferSubData(chunk.getDrawIndirectBuffer(), 0, sizeof(INITIAL_INDIRECT_DRAW_CONFIG), INITIAL_INDIRECT_DRAW_CONFIG);
-        bindNeighborChunks(4, has_neighbors, chunk.getPosition());
-        int unsigned resolution = getComputeResolution(m_chunk_pool.getBaseLodPointWidth());
-        glDispatchCompute(resolution, resolution, resolution);
-        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        bool const specialized = useSpecializedKernels();
+        ENG_PROFILE_GPU_SCOPE(DENSITY_GENERATION_SCOPES[m_density_layout == DensityLayout::BRICKED][specialized]);
+        glm::ivec4 batch[MAX_BATCH_SIZE];
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            batch[i] = glm::ivec4(chunks[i]->getPosition(), static_cast<int>(chunks[i]->getSlot()));
+            BufferRange const & materials = chunks[i]->getMaterialBuffer();
+            glClearNamedBufferSubData(materials.m_buffer, GL_R32UI, materials.m_offset, materials.m_size, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr); // Ids are ORed in
+        }
+        r_game_system.getUploadAllocator().upload(m_chunk_batch_ss, 0, batch, chunks.size() * sizeof(glm::ivec4));
+
+        Shader & density_generator = specialized ? *m_specialized_batched_density_generator : *m_batched_density_generator;
+        density_generator.bind();
+        density_generator.setUniformUInt(U_POINTS_PER_AXIS, m_chunk_pool.getBaseLodPointWidth()); // Inactive when specialized
+        density_generator.setUniformUInt(U_DENSITY_STRIDE, static_cast<GLuint>(m_chunk_pool.getDensityStride() / sizeof(float)));
+        density_generator.setUniformUInt(U_MATERIAL_STRIDE, static_cast<GLuint>(m_chunk_pool.getMaterialStride() / sizeof(uint32_t)));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, chunks[0]->getDensityDistributionBuffer().m_buffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, chunks[0]->getMaterialBuffer().m_buffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_BATCH_BINDING, m_chunk_batch_ss);
+        int unsigned resolution = getComputeResolution(DENSITY_GENERATION, m_chunk_pool.getBaseLodPointWidth());
+        glDispatchCompute(resolution, resolution, resolution * static_cast<GLuint>(chunks.size()));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void World::generateMesh(Chunk & chunk)
+    {
+        m_chunk_pool.reserveMesh(chunk);
+        m_unfitted_meshes.insert(chunk.getPosition());
+        bool const specialized = useSpecializedKernels();
+        ENG_PROFILE_GPU_SCOPE(MARCHING_CUBES_SCOPES[m_density_layout == DensityLayout::BRICKED][specialized][m_tiled_meshing]);
+        MeshingBuffers const buffers = getMeshingBuffers(chunk, 0);
+        if (specialized) dispatchMarchingCubes({ &buffers, 1 }, m_chunk_pool.getBaseLodPointWidth(), *m_specialized_marching_cubes_count, *m_specialized_marching_cubes);
+        else dispatchMarchingCubes({ &buffers, 1 }, m_chunk_pool.getBaseLodPointWidth(), *m_marching_cubes_count, *m_marching_cubes);
     }
 
-    void World::terraform(glm::ivec3 const & chunk_coordinate)
+    void World::generateMeshes(std::span<Chunk * const> chunks)
     {
-        std::vector<Chunk>::iterator chunk;
-        if (m_chunk_pool.getChunkAt(chunk_coordinate, chunk))
+        bool const specialized = useSpecializedKernels();
+        ENG_PROFILE_GPU_SCOPE(MARCHING_CUBES_SCOPES[m_density_layout == DensityLayout::BRICKED][specialized][m_tiled_meshing]);
+        MeshingBuffers batch[MAX_BATCH_SIZE];
+        for (size_t i = 0; i < chunks.size(); ++i)
         {
-            m_terraform->bind();
-            m_terraform->setUniformUInt("u_points_per_axis", m_chunk_pool.getBaseLodPointWidth());
-            m_terraform->setUniformFloat("u_strength", m_terraform_strength * m_create_destroy_multiplier);
-            m_terraform->setUniformFloat("u_radius", m_terraform_radius);
-            m_terraform->setUniformVector3f("u_current_chunk", static_cast<glm::vec3>(chunk_coordinate));
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, chunk->getDensityDistributionBuffer());
-            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_ray_hit_data_ss);
-            int unsigned resolution = getComputeResolution(m_chunk_pool.getBaseLodPointWidth());
+            m_chunk_pool.reserveMesh(*chunks[i]);
+            m_unfitted_meshes.insert(chunks[i]->getPosition());
+            batch[i] = getMeshingBuffers(*chunks[i], i);
+        }
+        if (specialized) dispatchMarchingCubes({ batch, chunks.size() }, m_chunk_pool.getBaseLodPointWidth(), *m_specialized_marching_cubes_count, *m_specialized_marching_cubes);
+        else dispatchMarchingCubes({ batch, chunks.size() }, m_chunk_pool.getBaseLodPointWidth(), *m_marching_cubes_count, *m_marching_cubes);
+    }
+
+    World::MeshingBuffers World::getMeshingBuffers(Chunk const & chunk, size_t batch_index) const
+    {
+        BufferRange const cell_triangle_offsets{ m_cell_triangle_offsets_ss, static_cast<GLintptr>(m_cell_triangle_offsets_stride * batch_index), m_cell_triangle_offsets_stride };
+        BufferRange const block_triangle_offsets{ m_block_triangle_offsets_ss, static_cast<GLintptr>(m_block_triangle_offsets_stride * batch_index), m_block_triangle_offsets_stride };
+        return { chunk.getDensityDistributionBuffer(), chunk.getMaterialBuffer(), chunk.getMeshVB(), chunk.getMaterialVB(), chunk.getDrawIndirectBuffer(), cell_triangle_offsets, block_triangle_offsets };
+    }
+
+    void World::dispatchMarchingCubes(std::span<MeshingBuffers const> batch, int unsigned point_width, Shader & count_kernel, Shader & write_kernel)
+    {
+        int unsigned const cell_count = maxChunkTriangles(point_width) / 5;
+        int unsigned const block_count = (cell_count + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE;
+        int unsigned const resolution = getComputeResolution(MARCHING_CUBES, point_width);
+
+        // Triangles per cell
+        count_kernel.bind();
+        count_kernel.setUniformFloat(U_THRESHOLD, m_threshold);
+        count_kernel.setUniformUInt(U_POINTS_PER_AXIS, point_width); // Inactive when specialized
+        for (MeshingBuffers const & buffers : batch)
+        {
+            buffers.m_density.bindStorage(3);
+            buffers.m_cell_triangle_offsets.bindStorage(5);
             glDispatchCompute(resolution, resolution, resolution);
-            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
-            uint8_t has_neighbors = (chunk_coordinate.x != m_last_chunk_coords.x - m_render_distance) | ((chunk_coordinate.z != m_last_chunk_coords.z - m_render_distance) << 1) | ((chunk_coordinate.y == 1) << 2);
+        // Offsets within each block, then the block offsets along with the draw counts
+        m_scan_triangle_counts->bind();
+        m_scan_triangle_counts->setUniformUInt(U_VALUE_COUNT, cell_count);
+        for (MeshingBuffers const & buffers : batch)
+        {
+            buffers.m_cell_triangle_offsets.bindStorage(5);
+            buffers.m_block_triangle_offsets.bindStorage(6);
+            glDispatchCompute(block_count, 1, 1);
+        }
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        m_scan_block_totals->bind();
+        m_scan_block_totals->setUniformUInt(U_VALUE_COUNT, block_count);
+        for (MeshingBuffers const & buffers : batch)
+        {
+            buffers.m_block_triangle_offsets.bindStorage(6);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, buffers.m_draw_indirect);
+            glDispatchCompute(1, 1, 1);
+        }
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // Every cell writes its triangles at its offset
+        write_kernel.bind();
+        write_kernel.setUniformFloat(U_THRESHOLD, m_threshold);
+        write_kernel.setUniformUInt(U_POINTS_PER_AXIS, point_width);
+        for (MeshingBuffers const & buffers : batch)
+        {
+            buffers.m_density.bindStorage(3);
+            buffers.m_cell_triangle_offsets.bindStorage(5);
+            buffers.m_block_triangle_offsets.bindStorage(6);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffers.m_mesh);
+            buffers.m_materials.bindStorage(11);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, buffers.m_vertex_materials);
+            glDispatchCompute(resolution, resolution, resolution);
+        }
+        // The scratch buffers are reused by the next batch
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void World::benchmarkMeshing(int iterations)
+    {
+        int unsigned constexpr POINT_WIDTHS[] = { 16, 32, 64 };
+        MeshingBuffers const buffers = createScratchBuffers(POINT_WIDTHS[std::size(POINT_WIDTHS) - 1]);
+
+        // The generic kernels take the point width as a uniform, so all widths share them
+        std::shared_ptr<Shader> kernels[2][2];
+        for (int tiled = 0; tiled < 2; ++tiled)
+        {
+            Shader::Defines defines = makeComputeDefines();
+            defines.emplace_back("WORK_GROUP_SIZE", std::to_string(m_work_group_sizes[MARCHING_CUBES]));
+            if (tiled) defines.emplace_back("MARCHING_CUBES_TILED", "1");
+            kernels[tiled][0] = r_game_system.getAssetManager().getShader("res/shaders/marching_cubes.glsl", withDefine(defines, "MARCHING_CUBES_COUNT"));
+            kernels[tiled][1] = r_game_system.getAssetManager().getShader("res/shaders/marching_cubes.glsl", defines);
+        }
 
-            generateMesh(*chunk, has_neighbors);
-            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-            glFlush();
+        GLuint query;
+        glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_generation_config_u);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_triangulation_table_ss);
+        for (int unsigned point_width : POINT_WIDTHS)
+        {
+            // A surface chunk, so most cells are neither empty nor full
+            dispatchDensityGeneration(*m_density_generator, buffers.m_density, buffers.m_materials, glm::vec3(0.0f), point_width);
+
+            double milliseconds[2]{};
+            for (int tiled = 0; tiled < 2; ++tiled)
+            {
+                dispatchMarchingCubes({ &buffers, 1 }, point_width, *kernels[tiled][0], *kernels[tiled][1]); // Warm up
+                for (int i = 0; i < iterations; ++i)
+                {
+                    GLuint64 elapsed_ns = 0;
+                    glBeginQuery(GL_TIME_ELAPSED, query);
+                    dispatchMarchingCubes({ &buffers, 1 }, point_width, *kernels[tiled][0], *kernels[tiled][1]);
+                    glEndQuery(GL_TIME_ELAPSED);
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+                    milliseconds[tiled] += static_cast<double>(elapsed_ns) / 1e6 / iterations;
+                }
+            }
+            GLuint triangle_count = 0;
+            glGetNamedBufferSubData(buffers.m_draw_indirect, 5 * sizeof(GLuint), sizeof(triangle_count), &triangle_count);
+            ENG_LOG_F("Marching cubes at point width %u (%u triangles): %.3f ms untiled, %.3f ms tiled", point_width, triangle_count, milliseconds[0], milliseconds[1]);
+        }
+        glDeleteQueries(1, &query);
+        deleteScratchBuffers(buffers);
+    }
+
+    World::MeshingBuffers World::createScratchBuffers(int unsigned point_width)
+    {
+        size_t const point_count = getDensityStorageCount(DensityLayout::BRICKED, point_width);
+        size_t const cell_count = maxChunkTriangles(point_width) / 5;
+
+        AssetManager & asset_manager = r_game_system.getAssetManager();
+        MeshingBuffers buffers{};
+        for (BufferRange * range : { &buffers.m_density, &buffers.m_materials, &buffers.m_cell_triangle_offsets, &buffers.m_block_triangle_offsets }) range->m_buffer = asset_manager.createBuffer();
+        for (GLuint * buffer : { &buffers.m_mesh, &buffers.m_vertex_materials, &buffers.m_draw_indirect }) *buffer = asset_manager.createBuffer();
+        buffers.m_density.m_size = static_cast<GLsizeiptr>(point_count * sizeof(float));
+        buffers.m_materials.m_size = static_cast<GLsizeiptr>(TerrainMaterial::getPackedWordCount(point_count) * sizeof(uint32_t));
+        buffers.m_cell_triangle_offsets.m_size = static_cast<GLsizeiptr>(cell_count * sizeof(uint32_t));
+        buffers.m_block_triangle_offsets.m_size = static_cast<GLsizeiptr>((cell_count + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE * sizeof(uint32_t));
+        for (BufferRange const * range : { &buffers.m_density, &buffers.m_materials, &buffers.m_cell_triangle_offsets, &buffers.m_block_triangle_offsets }) glNamedBufferStorage(range->m_buffer, range->m_size, nullptr, 0);
+        glNamedBufferStorage(buffers.m_mesh, maxChunkTriangles(point_width) * sizeof(float) * 18, nullptr, 0);
+        glNamedBufferStorage(buffers.m_vertex_materials, maxChunkTriangles(point_width) * 3 * sizeof(uint32_t), nullptr, 0);
+        glNamedBufferStorage(buffers.m_draw_indirect, sizeof(INITIAL_INDIRECT_DRAW_CONFIG), INITIAL_INDIRECT_DRAW_CONFIG, 0);
+        return buffers;
+    }
+
+    void World::deleteScratchBuffers(MeshingBuffers const & buffers)
+    {
+        for (GLuint buffer : { buffers.m_density.m_buffer, buffers.m_materials.m_buffer, buffers.m_mesh, buffers.m_vertex_materials, buffers.m_draw_indirect, buffers.m_cell_triangle_offsets.m_buffer, buffers.m_block_triangle_offsets.m_buffer })
+        {
+            r_game_system.getAssetManager().deleteBuffer(buffer);
+        }
+    }
+
+    bool World::terraform(glm::ivec3 const & chunk_coordinate)
+    {
+        Chunk * chunk = m_chunk_pool.getChunkAt(chunk_coordinate);
+        if (!chunk) return false;
+        chunk->setEdited();
+        ENG_PROFILE_GPU_SCOPE("Terraform");
+        dispatchTerraform(*m_terraform, chunk->getDensityDistributionBuffer(), chunk->getMaterialBuffer(), static_cast<glm::vec3>(chunk_coordinate), m_chunk_pool.getBaseLodPointWidth());
+        return true;
+    }
+
+    bool World::materializeChunk(glm::ivec3 const & chunk_coordinate)
+    {
+        glm::ivec3 const offset = glm::abs(chunk_coordinate - m_last_chunk_coords);
+        if (std::max({ offset.x, offset.y, offset.z }) > m_render_distance || m_chunk_pool.hasChunkAt(chunk_coordinate)) return false;
+        ChunkHandle handle;
+        {
+            physx::PxSceneWriteLock scene_lock(*m_scene);
+            auto const prefetched = m_prefetched_chunks.find(chunk_coordinate);
+            bool const is_prefetched = prefetched != m_prefetched_chunks.end();
+            handle = m_chunk_pool.restoreChunk(chunk_coordinate, m_chunk_size_in_units, is_prefetched);
+            if (handle.isValid())
+            {
+                if (is_prefetched)
+                {
+                    m_visible_generation_ticket = std::max(m_visible_generation_ticket, prefetched->second);
+                    ++m_prefetch_hit_count;
+                    m_prefetched_chunks.erase(prefetched);
+                }
+                else
+                {
+                    ++m_restored_chunk_count;
+                    m_generation_ms_saved += m_generation_ms_per_chunk;
+                }
+                return true;
+            }
+            handle = m_chunk_pool.activateChunk(chunk_coordinate, m_chunk_size_in_units);
+        }
+        Chunk * chunk = m_chunk_pool.get(handle);
+        if (!chunk) return false;
+        m_skipped_chunks.erase(chunk_coordinate);
+        generateDensityDistribution(*chunk);
+
+        // The generated aprons only match neighbours that were never edited
+        for (uint32_t direction_mask = 1; direction_mask <= 7; ++direction_mask)
+        {
+            glm::ivec3 const neighbor_coordinate = chunk_coordinate + glm::ivec3(direction_mask & 1, direction_mask >> 1 & 1, direction_mask >> 2 & 1);
+            Chunk const * source = m_chunk_pool.getChunkAt(neighbor_coordinate);
+            if (!source) continue;
+            copyApron(*source, *chunk, direction_mask);
+            chunk->setApronEdited();
+        }
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        return true;
+    }
+
+    void World::dispatchTerraform(Shader & kernel, BufferRange const & density, BufferRange const & materials, glm::vec3 const & chunk_coordinate, int unsigned point_width)
+    {
+        kernel.bind();
+        kernel.setUniformUInt(U_POINTS_PER_AXIS, point_width);
+        kernel.setUniformFloat(U_STRENGTH, m_terraform_strength * m_create_destroy_multiplier);
+        kernel.setUniformFloat(U_RADIUS, m_terraform_radius);
+        kernel.setUniformVector3f(U_CURRENT_CHUNK, chunk_coordinate);
+        kernel.setUniformFloat(U_THRESHOLD, m_threshold);
+        kernel.setUniformUInt(U_BRUSH_MATERIAL, m_brush_material);
+        density.bindStorage(3);
+        materials.bindStorage(11);
+        glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_PALETTE_BINDING, m_material_palette_u);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_ray_hit_data_ss);
+        int unsigned resolution = getComputeResolution(TERRAFORM, point_width);
+        glDispatchCompute(resolution, resolution, resolution);
+    }
+
+    void World::copyApron(Chunk const & source, Chunk const & destination, uint32_t direction_mask)
+    {
+        int unsigned const points_from_zero = m_chunk_pool.getBaseLodPointWidth() - 1;
+        int unsigned point_count = 1;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (!(direction_mask >> axis & 1)) point_count *= points_from_zero;
+        }
+        m_apron_copy->bind();
+        m_apron_copy->setUniformUInt(U_POINTS_PER_AXIS, m_chunk_pool.getBaseLodPointWidth());
+        m_apron_copy->setUniformUInt(U_DIRECTION_MASK, direction_mask);
+        source.getDensityDistributionBuffer().bindStorage(3);
+        destination.getDensityDistributionBuffer().bindStorage(4);
+        source.getMaterialBuffer().bindStorage(11);
+        destination.getMaterialBuffer().bindStorage(13);
+        glDispatchCompute((point_count + APRON_COPY_GROUP_SIZE - 1) / APRON_COPY_GROUP_SIZE, 1, 1);
+    }
+
+    void World::propagateApron(Chunk const & source, bool only_edited_aprons, std::vector<glm::ivec3> & out_stale_chunks)
+    {
+        ENG_PROFILE_GPU_SCOPE("Apron propagation");
+        for (uint32_t direction_mask = 1; direction_mask <= 7; ++direction_mask)
+        {
+            glm::ivec3 const neighbor_coordinate = source.getPosition() - glm::ivec3(direction_mask & 1, direction_mask >> 1 & 1, direction_mask >> 2 & 1);
+            Chunk * destination = m_chunk_pool.getResidentChunkAt(neighbor_coordinate); // Parked ones would be restored with a stale apron otherwise
+            if (!destination) continue;
+            if (only_edited_aprons && !destination->isApronEdited()) continue;
+            copyApron(source, *destination, direction_mask);
+            destination->setApronEdited();
+            if (std::find(out_stale_chunks.begin(), out_stale_chunks.end(), neighbor_coordinate) == out_stale_chunks.end()) out_stale_chunks.push_back(neighbor_coordinate);
+        }
+    }
+
+    void World::pullEditedAprons(Chunk & destination, std::vector<glm::ivec3> & out_stale_chunks)
+    {
+        ENG_PROFILE_GPU_SCOPE("Apron propagation");
+        bool pulled = false;
+        for (uint32_t direction_mask = 1; direction_mask <= 7; ++direction_mask)
+        {
+            glm::ivec3 const neighbor_coordinate = destination.getPosition() + glm::ivec3(direction_mask & 1, direction_mask >> 1 & 1, direction_mask >> 2 & 1);
+            Chunk const * source = m_chunk_pool.getResidentChunkAt(neighbor_coordinate);
+            if (!source || !source->isEdited()) continue; // Unedited faces match the generated apron already
+            if (!pulled) glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT); // Generation and meshing of the destination are done first
+            copyApron(*source, destination, direction_mask);
+            pulled = true;
         }
+        if (!pulled) return;
+        destination.setApronEdited();
+        if (std::find(out_stale_chunks.begin(), out_stale_chunks.end(), destination.getPosition()) == out_stale_chunks.end()) out_stale_chunks.push_back(destination.getPosition());
     }
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "graphics/shader_cache.hpp"
+#include "logger.hpp"
+#include "profiler.hpp"
+#include "world/cpu_terrain.hpp"
+
+#include "world/world.hpp"
+
+namespace eng
+{
+    namespace
+    {
+        // Cubes of these stay within the 1024 invocations every driver supports
+        int unsigned constexpr WORK_GROUP_CANDIDATES[] = { 4, 5, 6, 8, 10 };
+        int constexpr TUNING_ITERATIONS = 10;
+
+        std::filesystem::path getTuningPath(int unsigned point_width)
+        {
+            // hashSource mixes in the driver, so a new GPU or driver starts over
+            char file_name[48];
+            std::snprintf(file_name, sizeof(file_name), "work_groups_%016llx.txt", static_cast<unsigned long long>(ShaderCache::hashSource("work_groups " + std::to_string(point_width))));
+            return std::filesystem::path(ShaderCache::CACHE_DIRECTORY) / file_name;
+        }
+    }
+
+    float World::getIdleInvocationFraction(ComputeKernel kernel, int unsigned work_group_size) const
+    {
+        int unsigned const point_width = m_chunk_pool.getBaseLodPointWidth();
+        double const used = kernel == DENSITY_GENERATION ? point_width : point_width - 1;
+        double const launched = getComputeResolution(kernel, point_width, work_group_size) * work_group_size;
+        return static_cast<float>(1.0 - (used * used * used) / (launched * launched * launched));
+    }
+
+    void World::autotuneWorkGroupSizes(bool force)
+    {
+        int unsigned const point_width = m_chunk_pool.getBaseLodPointWidth();
+        std::filesystem::path const tuning_path = getTuningPath(point_width);
+        if (!force)
+        {
+            std::ifstream stream(tuning_path);
+            std::string name;
+            int unsigned size;
+            float milliseconds;
+            int loaded = 0;
+            while (stream >> name >> size >> milliseconds)
+            {
+                for (int kernel = 0; kernel < COMPUTE_KERNEL_COUNT; ++kernel)
+                {
+                    if (name != COMPUTE_KERNEL_NAMES[kernel]) continue;
+                    m_work_group_sizes[kernel] = size;
+                    m_work_group_times_ms[kernel] = milliseconds;
+                    ++loaded;
+                }
+            }
+            if (loaded == COMPUTE_KERNEL_COUNT)
+            {
+                loadComputeKernels();
+                return;
+            }
+        }
+
+        ENG_PROFILE_SCOPE("Autotune work groups");
+        GLint max_invocations = 0;
+        glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &max_invocations);
+
+        // Tuned on the default terrain so the result doesn't depend on whatever config is loaded
+        cpu::GenerationConfig const config{};
+        GLuint const config_u = r_game_system.getAssetManager().createBuffer();
+        glNamedBufferStorage(config_u, sizeof(config), &config, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 0, config_u);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_triangulation_table_ss);
+        float constexpr empty_hit_info[RAY_HIT_DATA_SIZE]{};
+        r_game_system.getUploadAllocator().upload(m_ray_hit_data_ss, 0, empty_hit_info, sizeof(empty_hit_info)); // Brush at the chunk origin
+
+        MeshingBuffers const buffers = createScratchBuffers(point_width);
+        GLuint query;
+        glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+        AssetManager & asset_manager = r_game_system.getAssetManager();
+        // The kernels may not be loaded yet when tuning from the constructor
+        std::shared_ptr<Shader> const density_generator = asset_manager.getShader("res/shaders/generate_points.glsl", makeKernelDefines(DENSITY_GENERATION, m_work_group_sizes[DENSITY_GENERATION]));
+        for (int kernel_index = 0; kernel_index < COMPUTE_KERNEL_COUNT; ++kernel_index)
+        {
+            ComputeKernel const kernel = static_cast<ComputeKernel>(kernel_index);
+            float best_milliseconds = 0.0f;
+            for (int unsigned size : WORK_GROUP_CANDIDATES)
+            {
+                if (static_cast<GLint>(size * size * size) > max_invocations) continue;
+
+                Shader::Defines const defines = makeKernelDefines(kernel, size);
+                std::shared_ptr<Shader> shader, count_shader;
+                switch (kernel)
+                {
+                case DENSITY_GENERATION: shader = asset_manager.getShader("res/shaders/generate_points.glsl", defines); break;
+                case MARCHING_CUBES:
+                    shader = asset_manager.getShader("res/shaders/marching_cubes.glsl", defines);
+                    count_shader = asset_manager.getShader("res/shaders/marching_cubes.glsl", withDefine(defines, "MARCHING_CUBES_COUNT"));
+                    break;
+                case TERRAFORM: shader = asset_manager.getShader("res/shaders/terraform.glsl", defines); break;
+                default: break;
+                }
+                auto const dispatch = [&]
+                {
+                    switch (kernel)
+                    {
+                    case DENSITY_GENERATION: dispatchDensityGeneration(*shader, buffers.m_density, buffers.m_materials, glm::vec3(0.0f), point_width); break;
+                    case MARCHING_CUBES: dispatchMarchingCubes({ &buffers, 1 }, point_width, *count_shader, *shader); break;
+                    case TERRAFORM: dispatchTerraform(*shader, buffers.m_density, buffers.m_materials, glm::vec3(0.0f), point_width); break;
+                    default: break;
+                    }
+                    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+                };
+
+                // Every pass reads the density the previous one left, so start each candidate from a fresh surface
+                // chunk and let the warm up absorb the first use of the program
+                dispatchDensityGeneration(*density_generator, buffers.m_density, buffers.m_materials, glm::vec3(0.0f), point_width);
+                dispatch();
+                double milliseconds = 0.0;
+                for (int i = 0; i < TUNING_ITERATIONS; ++i)
+                {
+                    GLuint64 elapsed_ns = 0;
+                    glBeginQuery(GL_TIME_ELAPSED, query);
+                    dispatch();
+                    glEndQuery(GL_TIME_ELAPSED);
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+                    milliseconds += static_cast<double>(elapsed_ns) / 1e6 / TUNING_ITERATIONS;
+                }
+
+                int unsigned const groups = getComputeResolution(kernel, point_width, size);
+                ENG_LOG_F("%s: %u^3 work groups of %u^3, %u invocations, %.1f%% idle, %.3f ms", COMPUTE_KERNEL_NAMES[kernel], groups, size, groups * groups * groups * size * size * size, getIdleInvocationFraction(kernel, size) * 100.0f, milliseconds);
+                if (best_milliseconds == 0.0f || milliseconds < best_milliseconds)
+                {
+                    best_milliseconds = static_cast<float>(milliseconds);
+                    m_work_group_sizes[kernel] = size;
+                }
+            }
+            m_work_group_times_ms[kernel] = best_milliseconds;
+        }
+        glDeleteQueries(1, &query);
+        deleteScratchBuffers(buffers);
+        asset_manager.deleteBuffer(config_u);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_generation_config_u);
+
+        std::error_code error;
+        std::filesystem::create_directories(ShaderCache::CACHE_DIRECTORY, error);
+        std::ofstream stream(tuning_path);
+        for (int kernel = 0; kernel < COMPUTE_KERNEL_COUNT; ++kernel)
+        {
+            stream << COMPUTE_KERNEL_NAMES[kernel] << ' ' << m_work_group_sizes[kernel] << ' ' << m_work_group_times_ms[kernel] << '\n';
+        }
+        if (!stream) ENG_LOG_F("Failed to store tuned work group sizes in %s", tuning_path.string().c_str());
+        loadComputeKernels();
+    }
+}
\ No newline at end of file
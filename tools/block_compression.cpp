@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "block_compression.hpp"
+
+namespace eng::BlockCompression
+{
+    namespace
+    {
+        int constexpr BLOCK_TEXELS = 16;
+        int constexpr BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // Endpoints of the block along its principal axis over the first channel_count channels
+        void fitEndpoints(uint8_t const * texels, int channel_count, float * out_min, float * out_max)
+        {
+            float mean[4]{};
+            for (int i = 0; i < BLOCK_TEXELS; ++i)
+                for (int c = 0; c < channel_count; ++c) mean[c] += texels[i * 4 + c] / static_cast<float>(BLOCK_TEXELS);
+
+            float covariance[4][4]{};
+            for (int i = 0; i < BLOCK_TEXELS; ++i)
+                for (int a = 0; a < channel_count; ++a)
+                    for (int b = 0; b < channel_count; ++b) covariance[a][b] += (texels[i * 4 + a] - mean[a]) * (texels[i * 4 + b] - mean[b]);
+
+            // Power iteration, a handful of steps is plenty to separate the dominant axis of 16 points
+            float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+            for (int iteration = 0; iteration < 8; ++iteration)
+            {
+                float next[4]{};
+                float length = 0.0f;
+                for (int a = 0; a < channel_count; ++a)
+                {
+                    for (int b = 0; b < channel_count; ++b) next[a] += covariance[a][b] * axis[b];
+                    length = std::max(length, std::abs(next[a]));
+                }
+                if (length == 0.0f) break;
+                for (int a = 0; a < channel_count; ++a) axis[a] = next[a] / length;
+            }
+            float axis_length_squared = 0.0f;
+            for (int c = 0; c < channel_count; ++c) axis_length_squared += axis[c] * axis[c];
+
+            float min_t = 0.0f, max_t = 0.0f;
+            for (int i = 0; i < BLOCK_TEXELS; ++i)
+            {
+                float t = 0.0f;
+                for (int c = 0; c < channel_count; ++c) t += (texels[i * 4 + c] - mean[c]) * axis[c];
+                t /= axis_length_squared;
+                min_t = std::min(min_t, t);
+                max_t = std::max(max_t, t);
+            }
+            for (int c = 0; c < channel_count; ++c)
+            {
+                out_min[c] = std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f);
+                out_max[c] = std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f);
+            }
+        }
+
+        uint32_t getSquaredError(uint8_t const * a, uint8_t const * b, int channel_count)
+        {
+            uint32_t error = 0;
+            for (int c = 0; c < channel_count; ++c) error += (a[c] - b[c]) * (a[c] - b[c]);
+            return error;
+        }
+
+        uint16_t packRgb565(float const * color)
+        {
+            uint32_t const r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+            uint32_t const g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+            uint32_t const b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+            return static_cast<uint16_t>(r << 11 | g << 5 | b);
+        }
+
+        void unpackRgb565(uint16_t color, uint8_t * out_color)
+        {
+            out_color[0] = static_cast<uint8_t>((color >> 11 & 31) * 255 / 31);
+            out_color[1] = static_cast<uint8_t>((color >> 5 & 63) * 255 / 63);
+            out_color[2] = static_cast<uint8_t>((color & 31) * 255 / 31);
+            out_color[3] = 255;
+        }
+
+        // 7 bit endpoint plus the p-bit that reconstructs it best, as the 8 bit value the decoder sees
+        void quantizeBc7Endpoint(float const * color, uint8_t * out_endpoint, uint32_t & out_p_bit)
+        {
+            float best_error = -1.0f;
+            for (uint32_t p_bit = 0; p_bit < 2; ++p_bit)
+            {
+                uint8_t candidate[4];
+                float error = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    int const value = std::clamp(static_cast<int>(std::lround((color[c] - p_bit) / 2.0f)), 0, 127);
+                    candidate[c] = static_cast<uint8_t>(value << 1 | p_bit);
+                    error += (candidate[c] - color[c]) * (candidate[c] - color[c]);
+                }
+                if (best_error >= 0.0f && error >= best_error) continue;
+                best_error = error;
+                out_p_bit = p_bit;
+                std::memcpy(out_endpoint, candidate, 4);
+            }
+        }
+
+        struct BitWriter
+        {
+            uint8_t * m_data;
+            uint32_t m_position{};
+
+            void write(uint32_t value, uint32_t bit_count)
+            {
+                for (uint32_t i = 0; i < bit_count; ++i, ++m_position)
+                {
+                    if (value >> i & 1) m_data[m_position / 8] |= static_cast<uint8_t>(1 << m_position % 8);
+                }
+            }
+        };
+    }
+
+    uint32_t encodeBc1(uint8_t const * texels, uint8_t * out_block)
+    {
+        float min_color[4], max_color[4];
+        fitEndpoints(texels, 3, min_color, max_color);
+        uint16_t color_0 = packRgb565(max_color), color_1 = packRgb565(min_color);
+        // color_0 > color_1 selects the four colour mode, equal endpoints just use index 0 everywhere
+        if (color_0 < color_1) std::swap(color_0, color_1);
+
+        uint8_t palette[4][4];
+        unpackRgb565(color_0, palette[0]);
+        unpackRgb565(color_1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+            palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+        }
+
+        uint32_t indices = 0, block_error = 0;
+        for (int i = 0; i < BLOCK_TEXELS; ++i)
+        {
+            uint32_t best_index = 0, best_error = getSquaredError(texels + i * 4, palette[0], 3);
+            for (uint32_t index = 1; index < (color_0 == color_1 ? 1u : 4u); ++index)
+            {
+                uint32_t const error = getSquaredError(texels + i * 4, palette[index], 3);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best_index = index;
+                }
+            }
+            indices |= best_index << (i * 2);
+            block_error += best_error;
+        }
+
+        std::memcpy(out_block, &color_0, 2);
+        std::memcpy(out_block + 2, &color_1, 2);
+        std::memcpy(out_block + 4, &indices, 4);
+        return block_error;
+    }
+
+    uint32_t encodeBc7(uint8_t const * texels, uint8_t * out_block)
+    {
+        float min_color[4], max_color[4];
+        fitEndpoints(texels, 4, min_color, max_color);
+        uint8_t endpoints[2][4];
+        uint32_t p_bits[2];
+        quantizeBc7Endpoint(min_color, endpoints[0], p_bits[0]);
+        quantizeBc7Endpoint(max_color, endpoints[1], p_bits[1]);
+
+        uint8_t palette[16][4];
+        for (int index = 0; index < 16; ++index)
+            for (int c = 0; c < 4; ++c) palette[index][c] = static_cast<uint8_t>(((64 - BC7_WEIGHTS[index]) * endpoints[0][c] + BC7_WEIGHTS[index] * endpoints[1][c] + 32) >> 6);
+
+        uint32_t indices[BLOCK_TEXELS];
+        uint32_t block_error = 0;
+        for (int i = 0; i < BLOCK_TEXELS; ++i)
+        {
+            uint32_t best_index = 0, best_error = getSquaredError(texels + i * 4, palette[0], 4);
+            for (uint32_t index = 1; index < 16; ++index)
+            {
+                uint32_t const error = getSquaredError(texels + i * 4, palette[index], 4);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best_index = index;
+                }
+            }
+            indices[i] = best_index;
+            block_error += getSquaredError(texels + i * 4, palette[best_index], 3);
+        }
+
+        // The anchor index is stored without its top bit, which must therefore be 0
+        if (indices[0] & 8)
+        {
+            std::swap(endpoints[0], endpoints[1]);
+            std::swap(p_bits[0], p_bits[1]);
+            for (uint32_t & index : indices) index = 15 - index;
+        }
+
+        std::memset(out_block, 0, 16);
+        BitWriter writer{ out_block };
+        writer.write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.write(endpoints[0][c] >> 1, 7);
+            writer.write(endpoints[1][c] >> 1, 7);
+        }
+        writer.write(p_bits[0], 1);
+        writer.write(p_bits[1], 1);
+        writer.write(indices[0], 3);
+        for (int i = 1; i < BLOCK_TEXELS; ++i) writer.write(indices[i], 4);
+        return block_error;
+    }
+
+    double compress(MipChain const & image, GLenum format, MipChain & out_image)
+    {
+        uint32_t const block_size = MipChain::getBlockSize(format);
+        out_image.m_format = format;
+        out_image.m_width = image.m_width;
+        out_image.m_height = image.m_height;
+        out_image.m_levels.resize(image.m_levels.size());
+
+        double level_0_error = 0.0;
+        for (size_t level = 0; level < image.m_levels.size(); ++level)
+        {
+            int const width = image.getLevelWidth(level), height = image.getLevelHeight(level);
+            int const blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+            uint8_t const * source = image.m_levels[level].data();
+            std::vector<uint8_t> & destination = out_image.m_levels[level];
+            destination.resize(out_image.getLevelSize(level));
+
+            for (int block_y = 0; block_y < blocks_y; ++block_y)
+            {
+                for (int block_x = 0; block_x < blocks_x; ++block_x)
+                {
+                    uint8_t texels[BLOCK_TEXELS * 4];
+                    for (int y = 0; y < 4; ++y)
+                    {
+                        for (int x = 0; x < 4; ++x)
+                        {
+                            int const source_x = std::min(block_x * 4 + x, width - 1), source_y = std::min(block_y * 4 + y, height - 1);
+                            std::memcpy(texels + (y * 4 + x) * 4, source + (static_cast<size_t>(source_y) * width + source_x) * 4, 4);
+                        }
+                    }
+                    uint8_t * block = destination.data() + (static_cast<size_t>(block_y) * blocks_x + block_x) * block_size;
+                    uint32_t const error = format == GL_COMPRESSED_RGBA_BPTC_UNORM ? encodeBc7(texels, block) : encodeBc1(texels, block);
+                    if (level == 0) level_0_error += error;
+                }
+            }
+        }
+        return level_0_error;
+    }
+}
\ No newline at end of file
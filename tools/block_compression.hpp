@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+#include "graphics/mip_chain.hpp"
+
+namespace eng
+{
+    // Offline BCn encoders. Both fit endpoints along the principal axis of the block's colours and pick the nearest
+    // palette entry per texel, which is far from the quality of a full search but runs in seconds for the whole game.
+    namespace BlockCompression
+    {
+        // texels are a 4x4 block of RGBA8 in row order, the return value is the squared RGB error of the block
+        uint32_t encodeBc1(uint8_t const * texels, uint8_t * out_block);
+        // Mode 6 only: one subset, 7 bit RGBA endpoints with a p-bit each and 4 bit indices
+        uint32_t encodeBc7(uint8_t const * texels, uint8_t * out_block);
+
+        // Encodes every level of an RGBA8 chain into format, edge blocks repeat their last texel. Returns the squared
+        // RGB error of level 0.
+        double compress(MipChain const & image, GLenum format, MipChain & out_image);
+    }
+}
\ No newline at end of file
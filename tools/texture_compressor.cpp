@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <stb_image/stb_image.hpp>
+
+#include "graphics/dds.hpp"
+
+#include "block_compression.hpp"
+
+// Converts an image into a mipmapped BC1 or BC7 .dds the TextureLoader picks up next to the original:
+// texture_compressor [--format bc1|bc7] <input image> <output.dds>
+int main(int argc, char ** argv)
+{
+    using namespace eng;
+
+    GLenum format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    int argument = 1;
+    if (argc == 5 && std::strcmp(argv[1], "--format") == 0)
+    {
+        if (std::strcmp(argv[2], "bc7") == 0) format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+        else if (std::strcmp(argv[2], "bc1") != 0) argc = 0;
+        argument = 3;
+    }
+    if (argc - argument != 2)
+    {
+        std::fprintf(stderr, "Usage: %s [--format bc1|bc7] <input image> <output.dds>\n", argv[0]);
+        return 1;
+    }
+    char const * input_path = argv[argument], * output_path = argv[argument + 1];
+
+    // Same orientation and channel expansion as TextureLoader::decode
+    stbi_set_flip_vertically_on_load(true);
+    MipChain image;
+    int channels;
+    char unsigned * data = stbi_load(input_path, &image.m_width, &image.m_height, &channels, 4);
+    if (!data)
+    {
+        std::fprintf(stderr, "Failed to load %s: %s\n", input_path, stbi_failure_reason());
+        return 1;
+    }
+    image.m_levels.assign(1, std::vector<uint8_t>(data, data + image.getLevelSize(0)));
+    stbi_image_free(data);
+    image.generateMips();
+
+    auto const start = std::chrono::steady_clock::now();
+    MipChain compressed;
+    double const squared_error = BlockCompression::compress(image, format, compressed);
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!Dds::write(output_path, compressed))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", output_path);
+        return 1;
+    }
+
+    size_t uncompressed_size = 0, compressed_size = 0;
+    for (size_t level = 0; level < image.m_levels.size(); ++level)
+    {
+        uncompressed_size += image.m_levels[level].size();
+        compressed_size += compressed.m_levels[level].size();
+    }
+    double const mean_squared_error = squared_error / (3.0 * image.m_width * image.m_height);
+    double const psnr = mean_squared_error > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mean_squared_error) : INFINITY;
+    std::printf("%s -> %s (%s, %dx%d, %zu levels) in %.2f s\n", input_path, output_path, format == GL_COMPRESSED_RGBA_BPTC_UNORM ? "BC7" : "BC1",
+        image.m_width, image.m_height, image.m_levels.size(), seconds);
+    std::printf("  %.2f MiB as RGBA8, %.2f MiB compressed (%.1fx smaller), level 0 PSNR %.2f dB\n",
+        uncompressed_size / 1048576.0, compressed_size / 1048576.0, static_cast<double>(uncompressed_size) / compressed_size, psnr);
+    return 0;
+}
\ No newline at end of file